@@ -17,9 +17,12 @@
 #ifndef FLATBUFFERS_FLEXBUFFERS_H_
 #define FLATBUFFERS_FLEXBUFFERS_H_
 
+#include <errno.h>
 #include <map>
 // We use the basic binary writing functions from the regular FlatBuffers.
 #include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/hash.h"
+#include "flatbuffers/json.h"
 #include "flatbuffers/util.h"
 
 #ifdef _MSC_VER
@@ -30,6 +33,7 @@ namespace flexbuffers {
 
 class Reference;
 class Map;
+template<typename V, bool kVerify> class Traverser;
 
 // These are used in the lower 2 bits of a type field to determine the size of
 // the elements (and or size field) of the item pointed to (e.g. vector).
@@ -156,7 +160,7 @@ inline double ReadDouble(const uint8_t *data, uint8_t byte_width) {
            byte_width);
 }
 
-const uint8_t *Indirect(const uint8_t *offset, uint8_t byte_width) {
+inline const uint8_t *Indirect(const uint8_t *offset, uint8_t byte_width) {
   return offset - ReadUInt64(offset, byte_width);
 }
 
@@ -164,7 +168,7 @@ template<typename T> const uint8_t *Indirect(const uint8_t *offset) {
   return offset - flatbuffers::ReadScalar<T>(offset);
 }
 
-static BitWidth WidthU(uint64_t u) {
+inline BitWidth WidthU(uint64_t u) {
   #define FLATBUFFERS_GET_FIELD_BIT_WIDTH(value, width) { \
     if (!((u) & ~((1ULL << (width)) - 1ULL))) return BIT_WIDTH_##width; \
   }
@@ -175,12 +179,12 @@ static BitWidth WidthU(uint64_t u) {
   return BIT_WIDTH_64;
 }
 
-static BitWidth WidthI(int64_t i) {
+inline BitWidth WidthI(int64_t i) {
   auto u = static_cast<uint64_t>(i) << 1;
   return WidthU(i >= 0 ? u : ~u);
 }
 
-static BitWidth WidthF(double f) {
+inline BitWidth WidthF(double f) {
   return static_cast<double>(static_cast<float>(f)) == f ? BIT_WIDTH_32
                                                          : BIT_WIDTH_64;
 }
@@ -294,11 +298,46 @@ class FixedTypedVector : public Object {
   uint8_t len_;
 };
 
+// Maps built with BUILDER_FLAG_HASH_MAP_KEYS may have a hash index of their
+// keys, which lets lookups skip (almost) all string comparisons. This is an
+// open addressing table of slots, placed right before the size of the keys
+// vector. Each slot holds the index of a key plus one (0 for an empty slot)
+// in its lower half, and the upper bits of the key's hash in its upper half.
+// It is flagged with a bit in the keys byte width field above the 8 bits
+// readers unaware of it look at, so they still read such maps as before
+// (with a binary search over the sorted keys).
+const uint64_t MAP_HASH_INDEX_FLAG = 0x100;
+// Smaller maps are searched quickly enough without one.
+const size_t MAP_HASH_INDEX_MIN_SIZE = 16;
+
+inline uint32_t HashKey(const char *key) {
+  return flatbuffers::HashFnv1a<uint32_t>(key);
+}
+
+// The number of slots in the index of a map of "size" keys: a power of 2,
+// that keeps the load under 3/4.
+inline size_t HashIndexSize(size_t size) {
+  size_t slots = 2;
+  while (slots * 3 < size * 4) slots *= 2;
+  return slots;
+}
+
+// The byte width of those slots, which need room for "size" + 1.
+inline uint8_t HashIndexSlotWidth(size_t size) {
+  return size < 0xFFFF ? 4 : 8;
+}
+
 class Map : public Vector {
  public:
   Map(const uint8_t *data, uint8_t byte_width)
     : Vector(data, byte_width) {}
 
+  // Whether this map has a hash index (see MAP_HASH_INDEX_FLAG).
+  bool HasHashIndex() const {
+    return (ReadUInt64(data_ - byte_width_ * 2, byte_width_) &
+            MAP_HASH_INDEX_FLAG) != 0;
+  }
+
   Reference operator[](const char *key) const;
   Reference operator[](const std::string &key) const;
 
@@ -327,6 +366,10 @@ class Map : public Vector {
 
 class Reference {
  public:
+  // A null value.
+  Reference()
+    : data_(nullptr), parent_width_(1), byte_width_(1), type_(TYPE_NULL) {}
+
   Reference(const uint8_t *data, uint8_t parent_width, uint8_t byte_width,
             Type type)
     : data_(data), parent_width_(parent_width), byte_width_(byte_width),
@@ -465,15 +508,31 @@ class Reference {
       return flatbuffers::NumToString(AsDouble());
     } else if (IsNull()) {
       return "null";
-    } else if (IsMap()) {
-      return "{..}";  // TODO: show elements.
-    } else if (IsVector()) {
-      return "[..]";  // TODO: show elements.
     } else {
-      return "(?)";
+      // Vectors, maps and blobs, as compact JSON.
+      std::string s;
+      flatbuffers::JsonStringSink sink(&s);
+      flatbuffers::JsonOptions opts;
+      opts.indent_step = -1;
+      ToJson(sink, opts);
+      return s;
     }
   }
 
+  // Writes this value as JSON to "sink", which can be anything with a
+  // Write(const char *data, size_t size) method (see JsonPrinter). Returns
+  // false if a string could not be encoded.
+  template<typename Sink> bool ToJson(
+      Sink &sink,
+      const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) const {
+    flatbuffers::JsonPrinter<Sink> printer(sink, opts);
+    ToJson(printer);
+    return printer.Finish();
+  }
+
+  template<typename Sink> void ToJson(
+      flatbuffers::JsonPrinter<Sink> &printer) const;
+
   // This function returns the empty blob if you try to read a not-blob.
   // Strings can be viewed as blobs too.
   Blob AsBlob() const {
@@ -620,6 +679,8 @@ class Reference {
     return false;
   }
 
+  template<typename V, bool kVerify> friend class Traverser;
+
   const uint8_t *data_;
   uint8_t parent_width_;
   uint8_t byte_width_;
@@ -671,6 +732,30 @@ template<typename T> int KeyCompare(const void *key, const void *elem) {
 
 inline Reference Map::operator[](const char *key) const {
   auto keys = Keys();
+  if (HasHashIndex()) {
+    auto size = keys.size();
+    auto slot_width = HashIndexSlotWidth(size);
+    auto num_slots = HashIndexSize(size);
+    auto slots = keys.data_ - keys.byte_width_ - num_slots * slot_width;
+    auto hash = HashKey(key);
+    auto index_bits = slot_width * 4U;
+    auto tag = hash >> (32 - index_bits);
+    auto mask = num_slots - 1;
+    // Bounded, so a corrupt index can't make this loop forever.
+    for (size_t probe = 0, i = hash & mask; probe < num_slots;
+         probe++, i = (i + 1) & mask) {
+      auto slot = ReadUInt64(slots + i * slot_width, slot_width);
+      auto index = slot & ((1ULL << index_bits) - 1);
+      if (!index) break;
+      if ((slot >> index_bits) != tag || index > size) continue;
+      auto elem = keys.data_ + (index - 1) * keys.byte_width_;
+      if (!strcmp(key, reinterpret_cast<const char *>(
+                         Indirect(elem, keys.byte_width_))))
+        return (*static_cast<const Vector *>(this))[
+                 static_cast<size_t>(index - 1)];
+    }
+    return Reference(nullptr, 1, NullPackedType());
+  }
   // We can't pass keys.byte_width_ to the comparison function, so we have
   // to pick the right one ahead of time.
   int (*comp)(const void *, const void *) = nullptr;
@@ -705,16 +790,361 @@ inline Reference GetRoot(const std::vector<uint8_t> &buffer) {
   return GetRoot(buffer.data(), buffer.size());
 }
 
+// Receives the values of a FlexBuffer from Traverse(), depth first: a map
+// is StartMap(), then Key() and the value for each element (in key order),
+// then EndMap(), and likewise for vectors, with Element() before each value.
+// Keys stored as values are passed to String(), and booleans, which
+// FlexBuffers don't have, are ints.
+// Derive from this and hide the methods you need; each returns false to stop
+// the traversal.
+class Visitor {
+ public:
+  bool Null() { return true; }
+  bool Int(int64_t /*i*/) { return true; }
+  bool UInt(uint64_t /*u*/) { return true; }
+  bool Float(double /*d*/) { return true; }
+  bool String(const char * /*str*/, size_t /*len*/) { return true; }
+  bool Blob(const uint8_t * /*data*/, size_t /*len*/) { return true; }
+  bool StartVector(size_t /*size*/) { return true; }
+  bool Element(size_t /*i*/) { return true; }
+  bool EndVector() { return true; }
+  bool StartMap(size_t /*size*/) { return true; }
+  bool Key(size_t /*i*/, const char * /*key*/, size_t /*len*/) {
+    return true;
+  }
+  bool EndMap() { return true; }
+};
+
+// The implementation of Traverse() and VerifyBuffer().
+// Rather than recursing, this keeps a stack of the vectors and maps it is in,
+// and reads the elements of each with a loop specialized on their byte width.
+// With kVerify, every read is checked to lie within the buffer first.
+template<typename V, bool kVerify> class Traverser {
+ public:
+  Traverser(V &visitor, const uint8_t *begin, const uint8_t *end,
+            size_t max_depth, size_t max_values)
+    : visitor_(visitor), begin_(begin), end_(end), max_depth_(max_depth),
+      max_values_(max_values), values_(0) {}
+
+  bool Traverse(const Reference &root) {
+    bool ok = false;
+    switch (root.parent_width_) {
+      case 1: ok = Root<uint8_t>(root); break;
+      case 2: ok = Root<uint16_t>(root); break;
+      case 4: ok = Root<uint32_t>(root); break;
+      case 8: ok = Root<uint64_t>(root); break;
+    }
+    while (ok && !stack_.empty()) {
+      switch (stack_.back().byte_width) {
+        case 1: ok = Elements<uint8_t>(); break;
+        case 2: ok = Elements<uint16_t>(); break;
+        case 4: ok = Elements<uint32_t>(); break;
+        case 8: ok = Elements<uint64_t>(); break;
+      }
+    }
+    return ok;
+  }
+
+  void operator=(const Traverser &);
+
+ private:
+  // A vector or map being traversed.
+  struct Frame {
+    const uint8_t *elems;
+    const uint8_t *types;  // Packed, for untyped vectors and maps.
+    const uint8_t *keys;   // For maps.
+    size_t size;
+    size_t next;           // The next element to visit.
+    uint8_t byte_width;
+    uint8_t keys_width;
+    Type type;             // For typed vectors.
+  };
+
+  // Does [p, p + len) lie within the buffer?
+  bool InBuffer(const uint8_t *p, size_t len) const {
+    return !kVerify ||
+           (p >= begin_ && p <= end_ && len <= static_cast<size_t>(end_ - p));
+  }
+
+  // Reads the offset at "p" (checked by the caller), and checks it points
+  // into the buffer.
+  template<typename T> bool Offset(const uint8_t *p,
+                                   const uint8_t **target) const {
+    auto offset = flatbuffers::ReadScalar<T>(p);
+    if (kVerify && offset > static_cast<uint64_t>(p - begin_)) return false;
+    *target = p - offset;
+    return true;
+  }
+
+  // Checks a size field at "p" - byte_width, and that "size" elements of
+  // "elem_size" bytes follow it.
+  bool Sized(const uint8_t *p, uint8_t byte_width, size_t elem_size,
+             size_t *size) const {
+    if (!InBuffer(p - byte_width, byte_width)) return false;
+    auto s = ReadUInt64(p - byte_width, byte_width);
+    if (kVerify && (!InBuffer(p, 0) ||
+                    s > static_cast<uint64_t>(end_ - p) / elem_size))
+      return false;
+    *size = static_cast<size_t>(s);
+    return true;
+  }
+
+  template<typename T> bool Root(const Reference &root) {
+    return Value<T>(root.data_, root.type_, root.byte_width_);
+  }
+
+  // Visits the value stored at "elem", in a vector with elements of type T.
+  template<typename T> bool Value(const uint8_t *elem, Type type,
+                                  uint8_t byte_width) {
+    if (kVerify && ++values_ > max_values_) return false;
+    typedef typename std::make_signed<T>::type S;
+    switch (type) {
+      case TYPE_NULL: return visitor_.Null();
+      case TYPE_INT: return visitor_.Int(flatbuffers::ReadScalar<S>(elem));
+      case TYPE_UINT: return visitor_.UInt(flatbuffers::ReadScalar<T>(elem));
+      case TYPE_FLOAT: return visitor_.Float(ReadDouble(elem, sizeof(T)));
+      default: break;
+    }
+    const uint8_t *target;
+    if (!Offset<T>(elem, &target)) return false;
+    size_t size = 0;
+    switch (type) {
+      case TYPE_INDIRECT_INT:
+        return InBuffer(target, byte_width) &&
+               visitor_.Int(ReadInt64(target, byte_width));
+      case TYPE_INDIRECT_UINT:
+        return InBuffer(target, byte_width) &&
+               visitor_.UInt(ReadUInt64(target, byte_width));
+      case TYPE_INDIRECT_FLOAT:
+        return InBuffer(target, byte_width) &&
+               visitor_.Float(ReadDouble(target, byte_width));
+      case TYPE_KEY: {
+        auto str = reinterpret_cast<const char *>(target);
+        if (kVerify && (!InBuffer(target, 0) ||
+                        !memchr(str, 0, end_ - target)))
+          return false;
+        return visitor_.String(str, strlen(str));
+      }
+      case TYPE_STRING:
+        // The terminator isn't counted in the size.
+        if (!Sized(target, byte_width, 1, &size) ||
+            (kVerify && (size == static_cast<size_t>(end_ - target) ||
+                         target[size])))
+          return false;
+        return visitor_.String(reinterpret_cast<const char *>(target), size);
+      case TYPE_BLOB:
+        return Sized(target, byte_width, 1, &size) &&
+               visitor_.Blob(target, size);
+      case TYPE_VECTOR:
+      case TYPE_MAP: {
+        // The packed types follow the elements.
+        if (!Sized(target, byte_width, byte_width + 1U, &size)) return false;
+        Frame frame = { target, target + size * byte_width, nullptr, size, 0,
+                        byte_width, 0, TYPE_NULL };
+        if (type == TYPE_VECTOR)
+          return Push(frame) && visitor_.StartVector(size);
+        // Maps are preceded by the offset and byte width of their keys.
+        auto prefix = target - byte_width * 3;
+        const uint8_t *keys;
+        size_t keys_size = 0;
+        if (!InBuffer(prefix, byte_width * 2U) ||
+            !Offset(prefix, byte_width, &keys))
+          return false;
+        auto keys_field = ReadUInt64(prefix + byte_width, byte_width);
+        frame.keys = keys;
+        frame.keys_width = static_cast<uint8_t>(keys_field);
+        if (kVerify && (frame.keys_width > 8 ||
+                        (frame.keys_width & (frame.keys_width - 1)) ||
+                        !frame.keys_width ||
+                        !Sized(keys, frame.keys_width, frame.keys_width,
+                               &keys_size) ||
+                        keys_size != size))
+          return false;
+        if (kVerify && (keys_field & MAP_HASH_INDEX_FLAG)) {
+          // Map::operator[] checks the slots themselves.
+          auto index_size = HashIndexSize(size) * HashIndexSlotWidth(size);
+          if (static_cast<size_t>(keys - frame.keys_width - begin_) <
+                index_size)
+            return false;
+        }
+        return Push(frame) && visitor_.StartMap(size);
+      }
+      default: {
+        // Typed vectors, whose elements are inline, or offsets to values
+        // with a byte width of 1 (as in TypedVector::operator[]).
+        Frame frame = { target, nullptr, nullptr, 0, 0, byte_width, 0,
+                        TYPE_NULL };
+        if (IsTypedVector(type)) {
+          frame.type = ToTypedVectorElementType(type);
+          if (!Sized(target, byte_width, byte_width, &frame.size))
+            return false;
+        } else if (IsFixedTypedVector(type)) {
+          uint8_t len = 0;
+          frame.type = ToFixedTypedVectorElementType(type, &len);
+          frame.size = len;
+          if (!InBuffer(target, byte_width * frame.size)) return false;
+        } else {
+          return false;
+        }
+        return Push(frame) && visitor_.StartVector(frame.size);
+      }
+    }
+  }
+
+  bool Offset(const uint8_t *p, uint8_t byte_width,
+              const uint8_t **target) const {
+    switch (byte_width) {
+      case 1: return Offset<uint8_t>(p, target);
+      case 2: return Offset<uint16_t>(p, target);
+      case 4: return Offset<uint32_t>(p, target);
+      default: return Offset<uint64_t>(p, target);
+    }
+  }
+
+  bool Push(const Frame &frame) {
+    if (kVerify && stack_.size() >= max_depth_) return false;
+    stack_.push_back(frame);
+    return true;
+  }
+
+  // Visits the remaining elements of the innermost vector or map, whose
+  // elements are of type T, until it is done or one of them is a vector or
+  // map, which is visited first.
+  template<typename T> bool Elements() {
+    auto depth = stack_.size();
+    // A copy, as visiting an element may grow the stack.
+    auto frame = stack_.back();
+    while (frame.next < frame.size) {
+      auto i = frame.next++;
+      if (frame.keys) {
+        const uint8_t *key;
+        auto offset = frame.keys + i * frame.keys_width;
+        if (!Offset(offset, frame.keys_width, &key)) return false;
+        auto str = reinterpret_cast<const char *>(key);
+        if (kVerify && (!InBuffer(key, 0) || !memchr(str, 0, end_ - key)))
+          return false;
+        if (!visitor_.Key(i, str, strlen(str))) return false;
+      } else {
+        if (!visitor_.Element(i)) return false;
+      }
+      stack_.back().next = frame.next;
+      auto elem = frame.elems + i * sizeof(T);
+      if (frame.types) {
+        auto packed_type = frame.types[i];
+        auto type = static_cast<Type>(packed_type >> 2);
+        if (kVerify && type > TYPE_BLOB) return false;
+        if (!Value<T>(elem, type,
+                      static_cast<uint8_t>(1U << (packed_type & 3))))
+          return false;
+      } else {
+        if (!Value<T>(elem, frame.type, 1)) return false;
+      }
+      if (stack_.size() > depth) return true;
+    }
+    stack_.pop_back();
+    return frame.keys ? visitor_.EndMap() : visitor_.EndVector();
+  }
+
+  V &visitor_;
+  const uint8_t *begin_;
+  const uint8_t *end_;
+  size_t max_depth_;
+  size_t max_values_;
+  size_t values_;
+  std::vector<Frame> stack_;
+};
+
+// Visits "root" and everything in it, depth first (see Visitor). Returns
+// false if the visitor stopped it.
+template<typename V> bool Traverse(const Reference &root, V &visitor) {
+  Traverser<V, false> traverser(visitor, nullptr, nullptr, 0, 0);
+  return traverser.Traverse(root);
+}
+
+// Checks that the FlexBuffer in "buffer" can be read (with Reference or
+// Traverse) without reading outside of it, e.g. before reading one that came
+// from an untrusted source. Vectors and maps may be nested "max_depth" deep,
+// and at most "max_values" values (counting shared ones each time they are
+// used) are visited.
+inline bool VerifyBuffer(const uint8_t *buffer, size_t size,
+                         size_t max_depth = 64, size_t max_values = 1000000) {
+  // At least a root value, its type and its width.
+  if (size < 3) return false;
+  auto byte_width = buffer[size - 1];
+  if (byte_width != 1 && byte_width != 2 && byte_width != 4 &&
+      byte_width != 8)
+    return false;
+  if (size < 2U + byte_width || (buffer[size - 2] >> 2) > TYPE_BLOB)
+    return false;
+  Visitor visitor;
+  Traverser<Visitor, true> traverser(visitor, buffer, buffer + size,
+                                     max_depth, max_values);
+  return traverser.Traverse(GetRoot(buffer, size));
+}
+
+// Prints the values it visits with a JsonPrinter.
+template<typename Sink> class JsonVisitor : public Visitor {
+ public:
+  explicit JsonVisitor(flatbuffers::JsonPrinter<Sink> &printer)
+    : printer_(printer) {}
+
+  bool Null() { printer_.Null(); return true; }
+  bool Int(int64_t i) { printer_.Number(i); return true; }
+  bool UInt(uint64_t u) { printer_.Number(u); return true; }
+  bool Float(double d) { printer_.Number(d); return true; }
+  bool String(const char *str, size_t len) {
+    printer_.String(str, len);
+    return true;
+  }
+  // As an array of bytes, since it needn't be text.
+  bool Blob(const uint8_t *data, size_t len) {
+    printer_.StartArray();
+    for (size_t i = 0; i < len; i++) {
+      printer_.Element(static_cast<flatbuffers::uoffset_t>(i));
+      printer_.Number(data[i]);
+    }
+    printer_.EndArray();
+    return true;
+  }
+  bool StartVector(size_t /*size*/) { printer_.StartArray(); return true; }
+  bool Element(size_t i) {
+    printer_.Element(static_cast<flatbuffers::uoffset_t>(i));
+    return true;
+  }
+  bool EndVector() { printer_.EndArray(); return true; }
+  bool StartMap(size_t /*size*/) { printer_.StartObject(); return true; }
+  bool Key(size_t i, const char *key, size_t len) {
+    printer_.Key(static_cast<int>(i), key, len);
+    return true;
+  }
+  bool EndMap() { printer_.EndObject(); return true; }
+
+  void operator=(const JsonVisitor &);
+
+ private:
+  flatbuffers::JsonPrinter<Sink> &printer_;
+};
+
+template<typename Sink> void Reference::ToJson(
+    flatbuffers::JsonPrinter<Sink> &printer) const {
+  JsonVisitor<Sink> visitor(printer);
+  Traverse(*this, visitor);
+}
+
 // Flags that configure how the Builder behaves.
 // The "Share" flags determine if the Builder automatically tries to pool
 // this type. Pooling can reduce the size of serialized data if there are
 // multiple maps of the same kind, at the expense of slightly slower
-// serialization (the cost of lookups) and more memory use (std::set).
+// serialization (the cost of lookups) and more memory use (a hash table per
+// pool, see Builder::LimitPoolMemory).
 // By default this is on for keys, but off for strings.
 // Turn keys off if you have e.g. only one map.
 // Turn strings on if you expect many non-unique string values.
 // Additionally, sharing key vectors can save space if you have maps with
 // identical field populations.
+// Hashing map keys stores a hash index with the keys of maps of at least
+// MAP_HASH_INDEX_MIN_SIZE keys (see MAP_HASH_INDEX_FLAG), which makes looking
+// up keys in large maps faster, at the cost of 4 (or 8) bytes per slot.
 enum BuilderFlag {
   BUILDER_FLAG_NONE = 0,
   BUILDER_FLAG_SHARE_KEYS = 1,
@@ -722,25 +1152,71 @@ enum BuilderFlag {
   BUILDER_FLAG_SHARE_KEYS_AND_STRINGS = 3,
   BUILDER_FLAG_SHARE_KEY_VECTORS = 4,
   BUILDER_FLAG_SHARE_ALL = 7,
+  BUILDER_FLAG_HASH_MAP_KEYS = 8,
 };
 
-class Builder FLATBUFFERS_FINAL_CLASS {
+// Builds a FlexBuffer in a std::vector that gets its memory from
+// "Allocator", e.g. to place it in an arena or a pre-mapped region.
+// Most code will want to use Builder (see below) instead.
+template<typename Allocator = std::allocator<uint8_t>>
+class BuilderT FLATBUFFERS_FINAL_CLASS {
  public:
-  Builder(size_t initial_size = 256,
-          BuilderFlag flags = BUILDER_FLAG_SHARE_KEYS)
-      : buf_(initial_size), finished_(false), flags_(flags),
-        force_min_bit_width_(BIT_WIDTH_8), key_pool(KeyOffsetCompare(buf_)),
-        string_pool(StringOffsetCompare(buf_)) {
-    buf_.clear();
+  typedef std::vector<uint8_t, Allocator> Buffer;
+
+  BuilderT(size_t initial_size = 256,
+           BuilderFlag flags = BUILDER_FLAG_SHARE_KEYS,
+           const Allocator &allocator = Allocator())
+      : buf_(allocator), finished_(false), has_duplicate_keys_(false),
+        flags_(flags),
+        force_min_bit_width_(BIT_WIDTH_8), key_pool(buf_), string_pool(buf_),
+        key_vector_pool(KeyVectorCompare(buf_)) {
+    buf_.reserve(initial_size);
   }
 
   /// @brief Get the serialized buffer (after you call `Finish()`).
   /// @return Returns a vector owned by this class.
-  const std::vector<uint8_t> &GetBuffer() const {
+  const Buffer &GetBuffer() const {
     Finished();
     return buf_;
   }
 
+  /// @brief The size of the buffer built so far.
+  size_t GetSize() const { return buf_.size(); }
+
+  /// @brief Whether any map had the same key more than once, making some of
+  /// its values impossible to look up. The buffer is still valid otherwise.
+  bool HasDuplicateKeys() const { return has_duplicate_keys_; }
+
+  /// @brief Move the serialized buffer out of the builder, which is then
+  /// cleared (see `Clear()`), but no longer has any capacity.
+  Buffer ReleaseBuffer() {
+    Finished();
+    Buffer buf(std::move(buf_));
+    Clear();
+    return buf;
+  }
+
+  /// @brief Swap the serialized buffer into `*buf`, and clear the builder.
+  /// The builder then reuses the memory of what was in `*buf`, so building
+  /// many buffers this way needn't allocate at all.
+  void ReleaseBuffer(Buffer *buf) {
+    Finished();
+    buf_.swap(*buf);
+    Clear();
+  }
+
+  /// @brief Reset the builder, so it can build a new buffer. This keeps the
+  /// memory it has allocated so far.
+  void Clear() {
+    buf_.clear();
+    stack_.clear();
+    finished_ = false;
+    has_duplicate_keys_ = false;
+    key_pool.Clear();
+    string_pool.Clear();
+    key_vector_pool.clear();
+  }
+
   // All value constructing functions below have two versions: one that
   // takes a key (for placement inside a map) and one that doesn't (for inside
   // vectors and elsewhere).
@@ -752,7 +1228,7 @@ class Builder FLATBUFFERS_FINAL_CLASS {
   void Int(const char *key, int64_t i) { Key(key); Int(i); }
 
   void UInt(uint64_t u) { stack_.push_back(Value(u, TYPE_UINT, WidthU(u))); }
-  void UInt(const char *key, uint64_t u) { Key(key); Int(u); }
+  void UInt(const char *key, uint64_t u) { Key(key); UInt(u); }
 
   void Float(float f) { stack_.push_back(Value(f)); }
   void Float(const char *key, float f) { Key(key); Float(f); }
@@ -796,18 +1272,15 @@ class Builder FLATBUFFERS_FINAL_CLASS {
   }
 
   size_t Key(const char *str, size_t len) {
-    auto sloc = buf_.size();
-    WriteBytes(str, len + 1);
-    if (flags_ & BUILDER_FLAG_SHARE_KEYS) {
-      auto it = key_pool.find(sloc);
-      if (it != key_pool.end()) {
-        // Already in the buffer. Remove key we just serialized, and use
-        // existing offset instead.
-        buf_.resize(sloc);
-        sloc = *it;
-      } else {
-        key_pool.insert(sloc);
-      }
+    auto share = (flags_ & BUILDER_FLAG_SHARE_KEYS) != 0;
+    auto hash = share ? key_pool.Hash(str, len) : 0;
+    auto sloc = share ? key_pool.Find(str, len, hash) : StringPool::kNotFound;
+    if (sloc == StringPool::kNotFound) {
+      sloc = buf_.size();
+      // "str" needn't be zero terminated.
+      WriteBytes(str, len);
+      buf_.push_back(0);
+      if (share) key_pool.Insert(sloc, len, hash);
     }
     stack_.push_back(Value(static_cast<uint64_t>(sloc), TYPE_KEY, BIT_WIDTH_8));
     return sloc;
@@ -817,22 +1290,20 @@ class Builder FLATBUFFERS_FINAL_CLASS {
   size_t Key(const std::string &str) { return Key(str.c_str(), str.size()); }
 
   size_t String(const char *str, size_t len) {
-    auto reset_to = buf_.size();
-    auto sloc = CreateBlob(str, len, 1, TYPE_STRING);
     if (flags_ & BUILDER_FLAG_SHARE_STRINGS) {
-      StringOffset so(sloc, len);
-      auto it = string_pool.find(so);
-      if (it != string_pool.end()) {
-        // Already in the buffer. Remove string we just serialized, and use
-        // existing offset instead.
-        buf_.resize(reset_to);
-        sloc = it->first;
-        stack_.back().u_ = sloc;
-      } else {
-        string_pool.insert(so);
+      auto hash = string_pool.Hash(str, len);
+      auto sloc = string_pool.Find(str, len, hash);
+      if (sloc != StringPool::kNotFound) {
+        // Already in the buffer, use the existing offset.
+        stack_.push_back(Value(static_cast<uint64_t>(sloc), TYPE_STRING,
+                               WidthU(len)));
+        return sloc;
       }
+      sloc = CreateBlob(str, len, 1, TYPE_STRING);
+      string_pool.Insert(sloc, len, hash);
+      return sloc;
     }
-    return sloc;
+    return CreateBlob(str, len, 1, TYPE_STRING);
   }
   size_t String(const char *str) {
     return String(str, strlen(str));
@@ -897,32 +1368,45 @@ class Builder FLATBUFFERS_FINAL_CLASS {
     // We want to sort 2 array elements at a time.
     struct TwoValue { Value key; Value val; };
     // TODO(wvo): strict aliasing?
-    // TODO(wvo): allow the caller to indicate the data is already sorted
-    // for maximum efficiency? With an assert to check sortedness to make sure
-    // we're not breaking binary search.
-    // Or, we can track if the map is sorted as keys are added which would be
-    // be quite cheap (cheaper than checking it here), so we can skip this
-    // step automatically when appliccable, and encourage people to write in
-    // sorted fashion.
-    // std::sort is typically already a lot faster on sorted data though.
     auto dict = reinterpret_cast<TwoValue *>(stack_.data() + start);
-    std::sort(dict, dict + len,
-              [&](const TwoValue &a, const TwoValue &b) -> bool {
+    auto less = [&](const TwoValue &a, const TwoValue &b) -> bool {
       auto as = reinterpret_cast<const char *>(buf_.data() + a.key.u_);
       auto bs = reinterpret_cast<const char *>(buf_.data() + b.key.u_);
       auto comp = strcmp(as, bs);
-      // If this assertion hits, you've added two keys with the same value to
-      // this map.
-      // TODO: Have to check for pointer equality, as some sort implementation
-      // apparently call this function with the same element?? Why?
-      assert(comp || &a == &b);
+      // Two keys with the same value in this map. Rather than asserting, as
+      // this may come from input such as JSON, flag it for the caller.
+      // Have to check for pointer equality, as some sort implementations
+      // call this function with the same element.
+      if (!comp && &a != &b) has_duplicate_keys_ = true;
       return comp < 0;
-    });
-    // First create a vector out of all keys.
-    // TODO(wvo): if kBuilderFlagShareKeyVectors is true, see if we can share
-    // the first vector.
-    auto keys = CreateVector(start, len, 2, true, false);
-    auto vec = CreateVector(start + 1, len, 2, false, false, &keys);
+    };
+    // Maps are often written in key order already (e.g. from a std::map, or
+    // records with a fixed layout), which one pass over the keys detects,
+    // and then we needn't sort at all.
+    // Keys are pushed without knowing which map they belong to (a vector may
+    // have been started inside this one), so it is simplest to check here.
+    size_t sorted = 1;
+    while (sorted < len && less(dict[sorted - 1], dict[sorted])) sorted++;
+    if (sorted < len) std::sort(dict, dict + len, less);
+    // First create a vector out of all keys, or reuse an identical one
+    // (which then has a hash index already, if it needs one).
+    auto hashed = (flags_ & BUILDER_FLAG_HASH_MAP_KEYS) &&
+                  len >= MAP_HASH_INDEX_MIN_SIZE;
+    Value keys;
+    if (flags_ & BUILDER_FLAG_SHARE_KEY_VECTORS) {
+      KeyVector key_vector(len);
+      for (size_t i = 0; i < len; i++) key_vector[i] = dict[i].key.u_;
+      auto it = key_vector_pool.find(key_vector);
+      if (it != key_vector_pool.end()) {
+        keys = it->second;
+      } else {
+        keys = CreateKeyVector(start, len, hashed);
+        key_vector_pool.insert(std::make_pair(key_vector, keys));
+      }
+    } else {
+      keys = CreateKeyVector(start, len, hashed);
+    }
+    auto vec = CreateVector(start + 1, len, 2, false, false, &keys, hashed);
     // Remove temp elements and return map.
     stack_.resize(start);
     stack_.push_back(vec);
@@ -1042,6 +1526,14 @@ class Builder FLATBUFFERS_FINAL_CLASS {
     force_min_bit_width_ = bw;
   }
 
+  // Limits the memory used by each of the key and string pools (see
+  // BuilderFlag). Once a pool is full, keys or strings already in it are
+  // still shared, but new ones aren't added.
+  void LimitPoolMemory(size_t max_bytes) {
+    key_pool.set_max_bytes(max_bytes);
+    string_pool.set_max_bytes(max_bytes);
+  }
+
   void Finish() {
     // If you hit this assert, you likely have objects that were never included
     // in a parent. You need to have exactly one root to finish a buffer.
@@ -1242,8 +1734,39 @@ class Builder FLATBUFFERS_FINAL_CLASS {
     return vloc;
   }
 
+  // Creates the keys vector of a map from the sorted keys at "start" (every
+  // other element on the stack), preceded by their hash index if "hashed".
+  Value CreateKeyVector(size_t start, size_t len, bool hashed) {
+    if (!hashed) return CreateVector(start, len, 2, true, false);
+    auto slot_width = HashIndexSlotWidth(len);
+    auto index_bits = slot_width * 4U;
+    auto mask = HashIndexSize(len) - 1;
+    hash_index_.assign(mask + 1, 0);
+    for (size_t i = 0; i < len; i++) {
+      auto key = reinterpret_cast<const char *>(buf_.data() +
+                                                stack_[start + i * 2].u_);
+      auto hash = HashKey(key);
+      auto j = hash & mask;
+      while (hash_index_[j]) j = (j + 1) & mask;
+      uint64_t tag = hash >> (32 - index_bits);
+      hash_index_[j] = (i + 1) | (tag << index_bits);
+    }
+    // The index is a multiple of 8 bytes, so when aligned to that, the keys
+    // vector (and its size) follows it directly.
+    Align(BIT_WIDTH_64);
+    for (auto it = hash_index_.begin(); it != hash_index_.end(); ++it) {
+      Write(*it, slot_width);
+    }
+    auto index_end = buf_.size();
+    auto keys = CreateVector(start, len, 2, true, false);
+    assert(keys.u_ == index_end + (1U << keys.min_bit_width_));
+    (void)index_end;
+    return keys;
+  }
+
   Value CreateVector(size_t start, size_t vec_len, size_t step, bool typed,
-                     bool fixed, const Value *keys = nullptr) {
+                     bool fixed, const Value *keys = nullptr,
+                     bool hashed = false) {
     // Figure out smallest bit width we can store this vector with.
     auto bit_width = std::max(force_min_bit_width_, WidthU(vec_len));
     auto prefix_elems = 1;
@@ -1252,6 +1775,8 @@ class Builder FLATBUFFERS_FINAL_CLASS {
       // to this vector.
       bit_width = std::max(bit_width, keys->ElemWidth(buf_.size(), 0));
       prefix_elems += 2;
+      // MAP_HASH_INDEX_FLAG doesn't fit in a byte.
+      if (hashed) bit_width = std::max(bit_width, BIT_WIDTH_16);
     }
     Type vector_type = TYPE_KEY;
     // Check bit widths and types for all elements.
@@ -1275,7 +1800,8 @@ class Builder FLATBUFFERS_FINAL_CLASS {
     // Write vector. First the keys width/offset if available, and size.
     if (keys) {
       WriteOffset(keys->u_, byte_width);
-      Write(1U << keys->min_bit_width_, byte_width);
+      Write<uint64_t>((1ULL << keys->min_bit_width_) |
+                      (hashed ? MAP_HASH_INDEX_FLAG : 0), byte_width);
     }
     if (!fixed) Write(vec_len, byte_width);
     // Then the actual data.
@@ -1298,46 +1824,218 @@ class Builder FLATBUFFERS_FINAL_CLASS {
   }
 
   // You shouldn't really be copying instances of this class.
-  Builder(const Builder &);
-  Builder &operator=(const Builder &);
+  BuilderT(const BuilderT &);
+  BuilderT &operator=(const BuilderT &);
 
-  std::vector<uint8_t> buf_;
+  Buffer buf_;
   std::vector<Value> stack_;
 
   bool finished_;
+  bool has_duplicate_keys_;
 
   BuilderFlag flags_;
 
   BitWidth force_min_bit_width_;
 
-  struct KeyOffsetCompare {
-    KeyOffsetCompare(const std::vector<uint8_t> &buf) : buf_(&buf) {}
-    bool operator() (size_t a, size_t b) const {
-      auto stra = reinterpret_cast<const char *>(buf_->data() + a);
-      auto strb = reinterpret_cast<const char *>(buf_->data() + b);
-      return strcmp(stra, strb) < 0;
+  // An open addressing hash set of the strings (or keys) in buf_. It stores
+  // their offsets and hashes, so lookups rarely need to look at buf_, and
+  // inserts don't allocate unless the table grows.
+  class StringPool {
+   public:
+    static const size_t kNotFound = static_cast<size_t>(-1);
+
+    explicit StringPool(const Buffer &buf)
+      : buf_(&buf), count_(0), max_bytes_(static_cast<size_t>(-1)) {}
+
+    static uint32_t Hash(const char *str, size_t len) {
+      return flatbuffers::HashFnv1a<uint32_t>(str, len);
+    }
+
+    // Returns the offset of a string equal to the "len" bytes at "str", or
+    // kNotFound.
+    size_t Find(const char *str, size_t len, uint32_t hash) const {
+      if (entries_.empty()) return kNotFound;
+      auto mask = entries_.size() - 1;
+      for (auto i = hash & mask; entries_[i].loc != kNotFound;
+           i = (i + 1) & mask) {
+        auto &entry = entries_[i];
+        if (entry.hash == hash && entry.len == len &&
+            !memcmp(buf_->data() + entry.loc, str, len))
+          return entry.loc;
+      }
+      return kNotFound;
+    }
+
+    // Adds a string not in the pool yet, if there's room.
+    void Insert(size_t loc, size_t len, uint32_t hash) {
+      // Keep the load under 3/4, so probe sequences stay short.
+      if ((count_ + 1) * 4 > entries_.size() * 3 && !Grow()) return;
+      Place(loc, len, hash);
+      count_++;
+    }
+
+    void set_max_bytes(size_t max_bytes) { max_bytes_ = max_bytes; }
+
+    void Clear() {
+      Entry empty = { kNotFound, 0, 0 };
+      std::fill(entries_.begin(), entries_.end(), empty);
+      count_ = 0;
+    }
+
+   private:
+    struct Entry {
+      size_t loc;
+      size_t len;
+      uint32_t hash;
+    };
+
+    void Place(size_t loc, size_t len, uint32_t hash) {
+      auto mask = entries_.size() - 1;
+      auto i = hash & mask;
+      while (entries_[i].loc != kNotFound) i = (i + 1) & mask;
+      Entry entry = { loc, len, hash };
+      entries_[i] = entry;
     }
-    const std::vector<uint8_t> *buf_;
+
+    bool Grow() {
+      auto size = entries_.empty() ? 64 : entries_.size() * 2;
+      if (size * sizeof(Entry) > max_bytes_) return false;
+      std::vector<Entry> old;
+      old.swap(entries_);
+      Entry empty = { kNotFound, 0, 0 };
+      entries_.resize(size, empty);
+      for (auto it = old.begin(); it != old.end(); ++it) {
+        if (it->loc != kNotFound) Place(it->loc, it->len, it->hash);
+      }
+      return true;
+    }
+
+    const Buffer *buf_;
+    std::vector<Entry> entries_;  // Size is a power of 2.
+    size_t count_;
+    size_t max_bytes_;
   };
 
-  typedef std::pair<size_t, size_t> StringOffset;
-  struct StringOffsetCompare {
-    StringOffsetCompare(const std::vector<uint8_t> &buf) : buf_(&buf) {}
-    bool operator() (const StringOffset &a, const StringOffset &b) const {
-      auto stra = reinterpret_cast<const char *>(buf_->data() + a.first);
-      auto strb = reinterpret_cast<const char *>(buf_->data() + b.first);
-      return strncmp(stra, strb, std::min(a.second, b.second) + 1) < 0;
+  // The (sorted) keys of a map, compared by content, so vectors can be
+  // shared even if the keys themselves aren't.
+  typedef std::vector<size_t> KeyVector;
+  struct KeyVectorCompare {
+    KeyVectorCompare(const Buffer &buf) : buf_(&buf) {}
+    bool operator() (const KeyVector &a, const KeyVector &b) const {
+      if (a.size() != b.size()) return a.size() < b.size();
+      for (size_t i = 0; i < a.size(); i++) {
+        if (a[i] == b[i]) continue;
+        auto comp = strcmp(reinterpret_cast<const char *>(buf_->data() + a[i]),
+                           reinterpret_cast<const char *>(buf_->data() + b[i]));
+        if (comp) return comp < 0;
+      }
+      return false;
     }
-    const std::vector<uint8_t> *buf_;
+    const Buffer *buf_;
   };
 
-  typedef std::set<size_t, KeyOffsetCompare> KeyOffsetMap;
-  typedef std::set<StringOffset, StringOffsetCompare> StringOffsetMap;
+  typedef std::map<KeyVector, Value, KeyVectorCompare> KeyVectorMap;
+
+  StringPool key_pool;
+  StringPool string_pool;
+  KeyVectorMap key_vector_pool;
 
-  KeyOffsetMap key_pool;
-  StringOffsetMap string_pool;
+  std::vector<uint64_t> hash_index_;  // Scratch space for CreateKeyVector.
 };
 
+typedef BuilderT<> Builder;
+
+// Parses one JSON value into "builder", for FromJson below.
+template<typename Allocator> bool ParseJsonValue(
+    flatbuffers::JsonReader &reader, BuilderT<Allocator> &builder,
+    int depth) {
+  // Same limit as the generated parsers have for tables, to bound the
+  // recursion on hostile input.
+  const int kMaxDepth = 64;
+  if (depth > kMaxDepth) return reader.Error("maximum nesting depth exceeded");
+  switch (reader.Peek()) {
+    case '{': {
+      reader.Expect('{');
+      auto start = builder.StartMap();
+      int n = 0;
+      const char *key;
+      size_t len;
+      while (reader.NextField(&n, &key, &len)) {
+        builder.Key(key, len);
+        if (!ParseJsonValue(reader, builder, depth + 1)) return false;
+      }
+      if (!reader.ok()) return false;
+      builder.EndMap(start);
+      if (builder.HasDuplicateKeys())
+        return reader.Error("field set more than once");
+      return true;
+    }
+    case '[': {
+      reader.Expect('[');
+      auto start = builder.StartVector();
+      for (flatbuffers::uoffset_t n = 0; reader.NextElement(n); n++) {
+        if (!ParseJsonValue(reader, builder, depth + 1)) return false;
+      }
+      if (!reader.ok()) return false;
+      builder.EndVector(start, false, false);
+      return true;
+    }
+    case '\"': {
+      const std::string *str;
+      if (!reader.String(&str)) return false;
+      builder.String(str->c_str(), str->length());
+      return true;
+    }
+    default: {
+      if (reader.Null()) {
+        builder.Null();
+        return true;
+      }
+      const char *token;
+      if (!reader.NumberToken(&token)) return false;
+      if (!strcmp(token, "true") || !strcmp(token, "false")) {
+        builder.Bool(*token == 't');
+        return true;
+      }
+      char *end;
+      // Integers stay integers, if they fit.
+      if (!strpbrk(token, ".eEnN")) {
+        errno = 0;
+        if (*token == '-') {
+          auto i = flatbuffers::StringToInt(token, &end);
+          if (!*end && !errno) { builder.Int(i); return true; }
+        } else {
+          auto u = flatbuffers::StringToUInt(token, &end);
+          if (!*end && !errno) {
+            if (u > static_cast<uint64_t>(INT64_MAX)) builder.UInt(u);
+            else builder.Int(static_cast<int64_t>(u));
+            return true;
+          }
+        }
+      }
+      auto d = strtod(token, &end);
+      if (*end) return reader.Error(std::string("invalid number: ") + token);
+      builder.Double(d);
+      return true;
+    }
+  }
+}
+
+// Parses schemaless JSON (in the dialect JsonReader accepts) straight into
+// "builder", and finishes it. Returns false on failure, with the reason in
+// *error if given; Clear() the builder before using it again then.
+template<typename Allocator> bool FromJson(const char *json, size_t len,
+                                           BuilderT<Allocator> *builder,
+                                           std::string *error = nullptr) {
+  flatbuffers::JsonReader reader(json, len);
+  if (!ParseJsonValue(reader, *builder, 0) || !reader.End()) {
+    if (error) *error = reader.error();
+    return false;
+  }
+  builder->Finish();
+  return true;
+}
+
 }  // namespace flexbuffers
 
 #endif  // FLATBUFFERS_FLEXBUFFERS_H_
@@ -62,6 +62,17 @@ T HashFnv1a(const char *input) {
   return hash;
 }
 
+// Same as above, for input that is not necessarily zero terminated.
+template <typename T>
+T HashFnv1a(const char *input, size_t len) {
+  T hash = FnvTraits<T>::kOffsetBasis;
+  for (const char *c = input, *end = input + len; c != end; ++c) {
+    hash ^= static_cast<unsigned char>(*c);
+    hash *= FnvTraits<T>::kFnvPrime;
+  }
+  return hash;
+}
+
 template <typename T>
 struct NamedHashFunction {
   const char *name;
@@ -18,8 +18,10 @@
 #define FLATBUFFERS_IDL_H_
 
 #include <map>
+#include <cstdio>
 #include <stack>
 #include <memory>
+#include <unordered_map>
 #include <functional>
 
 #include "flatbuffers/flatbuffers.h"
@@ -137,6 +139,8 @@ struct Type {
 
   Offset<reflection::Type> Serialize(FlatBufferBuilder *builder) const;
 
+  bool Deserialize(const Parser &parser, const reflection::Type *type);
+
   BaseType base_type;
   BaseType element;       // only set if t == BASE_TYPE_VECTOR
   StructDef *struct_def;  // only set if t or element == BASE_TYPE_STRUCT
@@ -157,6 +161,8 @@ struct Value {
 // also provides quick lookup.
 template<typename T> class SymbolTable {
  public:
+  SymbolTable() : frozen_(false) {}
+
   ~SymbolTable() {
     for (auto it = vec.begin(); it != vec.end(); ++it) {
       delete *it;
@@ -168,6 +174,7 @@ template<typename T> class SymbolTable {
     auto it = dict.find(name);
     if (it != dict.end()) return true;
     dict[name] = e;
+    frozen_ = false;
     return false;
   }
 
@@ -177,6 +184,7 @@ template<typename T> class SymbolTable {
       auto obj = it->second;
       dict.erase(it);
       dict[newname] = obj;
+      frozen_ = false;
     } else {
       assert(false);
     }
@@ -187,9 +195,60 @@ template<typename T> class SymbolTable {
     return it == dict.end() ? nullptr : it->second;
   }
 
+  // Lookup by a name that is not necessarily zero terminated. Once the table
+  // has been frozen this does not allocate, and costs a single hash of the
+  // name plus (typically) one comparison.
+  T *Lookup(const char *name, size_t len) const {
+    if (!frozen_) return Lookup(std::string(name, len));
+    auto mask = index_.size() - 1;
+    auto hash = HashFnv1a<uint32_t>(name, len);
+    for (auto i = hash & mask; ; i = (i + 1) & mask) {
+      auto &slot = index_[i];
+      if (!slot.value) return nullptr;
+      if (slot.hash == hash && slot.key->length() == len &&
+          !memcmp(slot.key->c_str(), name, len))
+        return slot.value;
+    }
+  }
+
+  // Build the hash index used by Lookup(name, len) above. Call this once the
+  // table is complete; any subsequent Add() or Move() drops back to the
+  // ordinary map lookup until Freeze() is called again.
+  void Freeze() {
+    if (frozen_) return;
+    size_t size = 1;
+    while (size < dict.size() * 2) size *= 2;
+    index_.assign(size, IndexSlot());
+    auto mask = size - 1;
+    for (auto it = dict.begin(); it != dict.end(); ++it) {
+      auto hash = HashFnv1a<uint32_t>(it->first.c_str(), it->first.length());
+      auto i = hash & mask;
+      while (index_[i].value) i = (i + 1) & mask;
+      index_[i].hash = hash;
+      index_[i].key = &it->first;
+      index_[i].value = it->second;
+    }
+    frozen_ = true;
+  }
+
+  bool IsFrozen() const { return frozen_; }
+
  public:
   std::map<std::string, T *> dict;      // quick lookup
   std::vector<T *> vec;  // Used to iterate in order of insertion
+
+ private:
+  // Open addressing with linear probing, at most half full. Keys point into
+  // dict, whose nodes are stable.
+  struct IndexSlot {
+    IndexSlot() : hash(0), key(nullptr), value(nullptr) {}
+    uint32_t hash;
+    const std::string *key;
+    T *value;
+  };
+
+  std::vector<IndexSlot> index_;
+  bool frozen_;
 };
 
 // A name space, as set in the schema.
@@ -214,6 +273,9 @@ struct Definition {
       SerializeAttributes(FlatBufferBuilder *builder,
                           const Parser &parser) const;
 
+  bool DeserializeAttributes(Parser &parser,
+                             const Vector<Offset<reflection::KeyValue>> *attrs);
+
   std::string name;
   std::string file;
   std::vector<std::string> doc_comment;
@@ -232,6 +294,9 @@ struct FieldDef : public Definition {
   Offset<reflection::Field> Serialize(FlatBufferBuilder *builder, uint16_t id,
                                       const Parser &parser) const;
 
+  bool Deserialize(Parser &parser, const StructDef &struct_def,
+                   const reflection::Field *field);
+
   Value value;
   bool deprecated; // Field is allowed to be present in old data, but can't be
                    // written in new data nor accessed in new code.
@@ -261,6 +326,8 @@ struct StructDef : public Definition {
   Offset<reflection::Object> Serialize(FlatBufferBuilder *builder,
                                        const Parser &parser) const;
 
+  bool Deserialize(Parser &parser, const reflection::Object *object);
+
   SymbolTable<FieldDef> fields;
   bool fixed;       // If it's struct, not a table.
   bool predecl;     // If it's used before it was defined.
@@ -288,6 +355,8 @@ struct EnumVal {
 
   Offset<reflection::EnumVal> Serialize(FlatBufferBuilder *builder) const;
 
+  bool Deserialize(const Parser &parser, const reflection::EnumVal *val);
+
   std::string name;
   std::vector<std::string> doc_comment;
   int64_t value;
@@ -295,11 +364,24 @@ struct EnumVal {
 };
 
 struct EnumDef : public Definition {
-  EnumDef() : is_union(false) {}
-
-  EnumVal *ReverseLookup(int enum_idx, bool skip_union_default = true) {
-    for (auto it = vals.vec.begin() + static_cast<int>(is_union &&
-                                                       skip_union_default);
+  EnumDef() : is_union(false), reverse_indexed_(false), reverse_min_(0) {}
+
+  EnumVal *ReverseLookup(int64_t enum_idx,
+                         bool skip_union_default = true) const {
+    auto skip = is_union && skip_union_default;
+    if (reverse_indexed_ && vals.IsFrozen()) {
+      EnumVal *ev = nullptr;
+      if (!reverse_dense_.empty()) {
+        // Unsigned compare also rejects values below the minimum.
+        auto i = static_cast<uint64_t>(enum_idx - reverse_min_);
+        if (i < reverse_dense_.size()) ev = reverse_dense_[i];
+      } else {
+        auto it = reverse_sparse_.find(enum_idx);
+        if (it != reverse_sparse_.end()) ev = it->second;
+      }
+      return skip && ev == vals.vec.front() ? nullptr : ev;
+    }
+    for (auto it = vals.vec.begin() + static_cast<int>(skip);
              it != vals.vec.end(); ++it) {
       if ((*it)->value == enum_idx) {
         return *it;
@@ -308,12 +390,27 @@ struct EnumDef : public Definition {
     return nullptr;
   }
 
+  // Freezes vals (see SymbolTable::Freeze()), and indexes them by value, such
+  // that ReverseLookup() takes constant time until the next vals.Add().
+  // Does nothing if the index is already up to date.
+  void Freeze();
+
   Offset<reflection::Enum> Serialize(FlatBufferBuilder *builder,
                                      const Parser &parser) const;
 
+  bool Deserialize(Parser &parser, const reflection::Enum *_enum);
+
   SymbolTable<EnumVal> vals;
   bool is_union;
   Type underlying_type;
+
+ private:
+  bool reverse_indexed_;
+  // A table indexed by (value - reverse_min_) if the values are dense enough,
+  // a hash map otherwise.
+  int64_t reverse_min_;
+  std::vector<EnumVal *> reverse_dense_;
+  std::unordered_map<int64_t, EnumVal *> reverse_sparse_;
 };
 
 inline bool EqualByName(const Type &a, const Type &b) {
@@ -353,11 +450,13 @@ struct IDLOptions {
   bool generate_name_strings;
   bool escape_proto_identifiers;
   bool generate_object_based_api;
+  bool generate_json_functions;
   std::string cpp_object_api_pointer_type;
   bool union_value_namespacing;
   bool allow_non_utf8;
   std::string include_prefix;
   bool binary_schema_comments;
+  bool binary_schema_builtins;
 
   // Possible options for the more general generator below.
   enum Language {
@@ -396,10 +495,12 @@ struct IDLOptions {
       generate_name_strings(false),
       escape_proto_identifiers(false),
       generate_object_based_api(false),
+      generate_json_functions(false),
       cpp_object_api_pointer_type("std::unique_ptr"),
       union_value_namespacing(true),
       allow_non_utf8(false),
       binary_schema_comments(false),
+      binary_schema_builtins(false),
       lang(IDLOptions::kJava),
       lang_to_generate(0) {}
 };
@@ -464,7 +565,8 @@ class Parser : public ParserState {
     : root_struct_def_(nullptr),
       opts(options),
       source_(nullptr),
-      anonymous_counter(0) {
+      anonymous_counter(0),
+      json_builder_(&builder_) {
     // Just in case none are declared:
     namespaces_.push_back(new Namespace());
     known_attributes_["deprecated"] = true;
@@ -504,6 +606,27 @@ class Parser : public ParserState {
   bool Parse(const char *_source, const char **include_paths = nullptr,
              const char *source_filename = nullptr);
 
+  // Parse a sequence of JSON objects of the root type, either concatenated or
+  // one per line (NDJSON), using a parser that already holds the schema.
+  // Each object is serialized into builder_ as a size prefixed FlatBuffer,
+  // which is handed to sink and only valid for the duration of that call.
+  // builder_ and all other parsing state are reused between objects, and the
+  // schema is left untouched, so this can be called repeatedly.
+  // source must be zero terminated.
+  bool ParseJsonStream(const char *source,
+                       const std::function<void(const uint8_t *buf,
+                                                size_t size)> &sink,
+                       const char *source_filename = nullptr);
+
+  // Parse a single JSON object of type struct_def (a table) from the len
+  // bytes at json, which need not be zero terminated, and serialize it
+  // directly into fbb rather than builder_. On success, *out holds the
+  // offset of the table in fbb, for the caller to store in a parent object
+  // or Finish() with. fbb must not be in the middle of building a table or
+  // vector. On failure, fbb may hold partial data and should be discarded.
+  bool ParseJsonInto(FlatBufferBuilder &fbb, const StructDef &struct_def,
+                     const char *json, size_t len, Offset<void> *out);
+
   // Set the root type. May override the one set in the schema.
   bool SetRootType(const char *name);
 
@@ -519,12 +642,28 @@ class Parser : public ParserState {
   // See reflection/reflection.fbs
   void Serialize();
 
+  // Populates this (otherwise empty) parser with the definitions of a binary
+  // schema, as produced by Serialize() / flatc -b --schema. This is much
+  // faster than parsing the original .fbs files. Built-in attributes
+  // (e.g. hash, original_order) are only available if the schema was
+  // serialized with binary_schema_builtins (flatc --bfbs-builtins).
+  // Returns false and sets error_ on failure.
+  bool Deserialize(const reflection::Schema &schema);
+
+  // As above, but first verifies the size bytes at buf contain a valid
+  // binary schema.
+  bool Deserialize(const uint8_t *buf, size_t size);
+
   // Checks that the schema represented by this parser is a safe evolution
   // of the schema provided. Returns non-empty error on any problems.
   std::string ConformTo(const Parser &base);
 
   FLATBUFFERS_CHECKED_ERROR CheckBitsFit(int64_t val, size_t bits);
 
+  // Build the allocation-free lookup indices of all field and enum value
+  // tables. Parse() does this automatically once a schema is complete.
+  void FreezeSymbolTables();
+
 private:
   FLATBUFFERS_CHECKED_ERROR Error(const std::string &msg);
   FLATBUFFERS_CHECKED_ERROR ParseHexNum(int nibbles, uint64_t *val);
@@ -579,6 +718,12 @@ private:
   FLATBUFFERS_CHECKED_ERROR DoParse(const char *_source,
                                     const char **include_paths,
                                     const char *source_filename);
+  FLATBUFFERS_CHECKED_ERROR DoParseJsonInto(const StructDef &struct_def,
+                                            Offset<void> *out);
+  FLATBUFFERS_CHECKED_ERROR DoParseJsonStream(
+      const char *_source,
+      const std::function<void(const uint8_t *buf, size_t size)> &sink,
+      const char *source_filename);
   FLATBUFFERS_CHECKED_ERROR CheckClash(std::vector<FieldDef*> &fields,
                                        StructDef *struct_def,
                                        const char *suffix,
@@ -613,12 +758,59 @@ private:
   std::vector<std::pair<Value, FieldDef *>> field_stack_;
 
   int anonymous_counter;
+
+  // Where JSON values are serialized to: builder_, unless ParseJsonInto()
+  // was given another builder.
+  FlatBufferBuilder *json_builder_;
+  std::string json_source_;
 };
 
 // Utility functions for multiple generators:
 
 extern std::string MakeCamel(const std::string &in, bool first = true);
 
+// Collects generated text in a fixed size chunk, and hands each full chunk
+// to a writer function, such that generating text for a large buffer needs
+// only a bounded amount of memory.
+class TextSink {
+ public:
+  // Returns false on a write error, after which no more output is written.
+  typedef std::function<bool(const char *data, size_t size)> Writer;
+
+  explicit TextSink(const Writer &writer, size_t chunk_size = 4096)
+    : writer_(writer), chunk_(chunk_size ? chunk_size : 1), used_(0),
+      ok_(true) {}
+
+  void Write(const char *data, size_t size);
+  void WriteRepeated(size_t count, char c);
+
+  TextSink &operator+=(const char *s) { Write(s, strlen(s)); return *this; }
+  TextSink &operator+=(const std::string &s) {
+    Write(s.c_str(), s.length());
+    return *this;
+  }
+  TextSink &operator+=(char c) {
+    if (used_ == chunk_.size()) Flush();
+    chunk_[used_++] = c;
+    return *this;
+  }
+
+  // Passes any buffered text on to the writer. Returns false if any write
+  // so far failed.
+  bool Flush();
+  bool ok() const { return ok_; }
+
+  // Writers for the common destinations. These do not take ownership.
+  static Writer FileWriter(FILE *file);
+  static Writer FileDescriptorWriter(int fd);
+
+ private:
+  Writer writer_;
+  std::vector<char> chunk_;
+  size_t used_;
+  bool ok_;
+};
+
 // Generate text (JSON) from a given FlatBuffer, and a given Parser
 // object that has been populated with the corresponding schema.
 // If ident_step is 0, no indentation will be generated. Additionally,
@@ -630,10 +822,24 @@ extern std::string MakeCamel(const std::string &in, bool first = true);
 extern bool GenerateText(const Parser &parser,
                          const void *flatbuffer,
                          std::string *text);
+
+// As above, but streams the text to sink, which is flushed at the end.
+// Returns false on a write error as well. On failure, part of the text may
+// already have been written.
+extern bool GenerateText(const Parser &parser,
+                         const void *flatbuffer,
+                         TextSink *sink);
 extern bool GenerateTextFile(const Parser &parser,
                              const std::string &path,
                              const std::string &file_name);
 
+// As above, but for the "size" bytes of the FlexBuffer "flexbuf" rather than
+// the data in the Parser, which needs no schema (flatc --flexjson).
+extern bool GenerateTextFile(const Parser &parser,
+                             const uint8_t *flexbuf, size_t size,
+                             const std::string &path,
+                             const std::string &file_name);
+
 // Generate binary files from a given FlatBuffer, and a given Parser
 // object that has been populated with the corresponding schema.
 // See idl_gen_general.cpp.
@@ -641,6 +847,13 @@ extern bool GenerateBinary(const Parser &parser,
                            const std::string &path,
                            const std::string &file_name);
 
+// As above, but writes the "size" bytes of the FlexBuffer "flexbuf"
+// (flatc --flexjson).
+extern bool GenerateBinary(const Parser &parser,
+                           const uint8_t *flexbuf, size_t size,
+                           const std::string &path,
+                           const std::string &file_name);
+
 // Generate a C++ header from the definitions in the Parser object.
 // See idl_gen_cpp.
 extern std::string GenerateCPP(const Parser &parser,
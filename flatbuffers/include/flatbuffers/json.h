@@ -0,0 +1,585 @@
+/*
+ * Copyright 2017 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_JSON_H_
+#define FLATBUFFERS_JSON_H_
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/util.h"
+
+// Runtime support for the JSON functions flatc generates for C++ with
+// --gen-json-functions. Unlike GenerateText() and Parser in idl.h, these
+// need no schema at runtime.
+
+namespace flatbuffers {
+
+// Same meaning as the corresponding fields in IDLOptions.
+struct JsonOptions {
+  JsonOptions() : indent_step(2), strict_json(false), allow_non_utf8(false) {}
+
+  int indent_step;
+  bool strict_json;
+  bool allow_non_utf8;
+};
+
+// A sink for generated text appending to a string. Any type with a
+// Write(const char *data, size_t size) method (such as TextSink in idl.h)
+// can be used instead.
+class JsonStringSink {
+ public:
+  explicit JsonStringSink(std::string *text) : text_(text) {}
+  void Write(const char *data, size_t size) { text_->append(data, size); }
+
+ private:
+  std::string *text_;
+};
+
+// Formatting primitives called by the generated PrintJson() functions. The
+// output is identical to that of GenerateText() with the same options.
+template<typename Sink> class JsonPrinter {
+ public:
+  JsonPrinter(Sink &sink, const JsonOptions &opts)
+    : sink_(sink), opts_(opts), indent_(0), ok_(true) {}
+
+  // Returns false if a string could not be encoded.
+  bool ok() const { return ok_; }
+
+  // n is the number of fields or elements already output at this level.
+  void StartObject() { Write("{", 1); Nest(); }
+  void EndObject() { Unnest(); Write("}", 1); }
+  template<size_t N> void Key(int n, const char (&name)[N]) {
+    if (n) Write(",", 1);
+    NewLine();
+    Indent();
+    if (opts_.strict_json) Write("\"", 1);
+    Write(name, N - 1);
+    Write(opts_.strict_json ? "\": " : ": ", opts_.strict_json ? 3 : 2);
+  }
+  // For names only known at runtime, which are quoted unless they are
+  // identifiers (and strict_json isn't set).
+  void Key(int n, const char *name, size_t len) {
+    if (n) Write(",", 1);
+    NewLine();
+    Indent();
+    if (opts_.strict_json || !IsIdentifier(name, len)) {
+      String(name, len);
+    } else {
+      Write(name, len);
+    }
+    Write(": ", 2);
+  }
+
+  void StartArray() { Write("[", 1); NewLine(); Nest(); }
+  void EndArray() { Unnest(); Write("]", 1); }
+  void Element(uoffset_t n) {
+    if (n) { Write(",", 1); NewLine(); }
+    Indent();
+  }
+
+  // Enum values are output as identifiers, with quotes if strict.
+  template<size_t N> void Identifier(const char (&name)[N]) {
+    if (opts_.strict_json) Write("\"", 1);
+    Write(name, N - 1);
+    if (opts_.strict_json) Write("\"", 1);
+  }
+
+  void Bool(bool b) { if (b) Write("true", 4); else Write("false", 5); }
+  void Null() { Write("null", 4); }
+
+  void Number(int8_t i) { Number(static_cast<int64_t>(i)); }
+  void Number(uint8_t i) { Number(static_cast<uint64_t>(i)); }
+  void Number(int16_t i) { Number(static_cast<int64_t>(i)); }
+  void Number(uint16_t i) { Number(static_cast<uint64_t>(i)); }
+  void Number(int32_t i) { Number(static_cast<int64_t>(i)); }
+  void Number(uint32_t i) { Number(static_cast<uint64_t>(i)); }
+  void Number(int64_t i) {
+    if (i >= 0) return Number(static_cast<uint64_t>(i));
+    Write("-", 1);
+    Number(0 - static_cast<uint64_t>(i));
+  }
+  void Number(uint64_t i) {
+    char buf[20];
+    auto p = buf + sizeof(buf);
+    do { *--p = static_cast<char>('0' + i % 10); i /= 10; } while (i);
+    Write(p, static_cast<size_t>(buf + sizeof(buf) - p));
+  }
+  void Number(float f) { Number(static_cast<double>(f)); }
+  void Number(double d) {
+    // Same as NumToString<double>(): fixed notation, without trailing zeroes.
+    char buf[512];
+    auto len = snprintf(buf, sizeof(buf), "%f", d);
+    if (len < 0) { ok_ = false; return; }
+    auto size = std::min(static_cast<size_t>(len), sizeof(buf) - 1);
+    while (size > 1 && buf[size - 1] == '0') size--;
+    if (buf[size - 1] == '.') size--;
+    Write(buf, size);
+  }
+
+  void String(const flatbuffers::String &s) { String(s.c_str(), s.size()); }
+  void String(const char *str, size_t len) {
+    Write("\"", 1);
+    auto start = str;  // Start of the run of characters not yet output.
+    for (size_t i = 0; i < len; i++) {
+      char c = str[i];
+      if (c >= ' ' && c <= '~' && c != '\"' && c != '\\') continue;
+      Write(start, static_cast<size_t>(str + i - start));
+      switch (c) {
+        case '\n': Write("\\n", 2); break;
+        case '\t': Write("\\t", 2); break;
+        case '\r': Write("\\r", 2); break;
+        case '\b': Write("\\b", 2); break;
+        case '\f': Write("\\f", 2); break;
+        case '\"': Write("\\\"", 2); break;
+        case '\\': Write("\\\\", 2); break;
+        default: {
+          // Not printable ASCII data. Let's see if it's valid UTF-8 first:
+          const char *utf8 = str + i;
+          int ucc = FromUTF8(&utf8);
+          if (ucc < 0) {
+            if (!opts_.allow_non_utf8) { ok_ = false; return; }
+            Write("\\x", 2);
+            Hex(static_cast<uint8_t>(c), 2);
+          } else {
+            if (ucc <= 0xFFFF) {
+              Write("\\u", 2);
+              Hex(static_cast<uint32_t>(ucc), 4);
+            } else if (ucc <= 0x10FFFF) {
+              // Encode as a surrogate pair.
+              uint32_t base = static_cast<uint32_t>(ucc) - 0x10000;
+              Write("\\u", 2);
+              Hex((base >> 10) + 0xD800, 4);
+              Write("\\u", 2);
+              Hex((base & 0x03FF) + 0xDC00, 4);
+            }
+            // Skip past characters recognized.
+            i = static_cast<size_t>(utf8 - str - 1);
+          }
+          break;
+        }
+      }
+      start = str + i + 1;
+    }
+    Write(start, static_cast<size_t>(str + len - start));
+    Write("\"", 1);
+  }
+
+  // Ends the document.
+  bool Finish() { NewLine(); return ok_; }
+
+ private:
+  void Write(const char *data, size_t size) { sink_.Write(data, size); }
+  void NewLine() { if (opts_.indent_step >= 0) Write("\n", 1); }
+  void Nest() { if (opts_.indent_step > 0) indent_ += opts_.indent_step; }
+  void Unnest() {
+    if (opts_.indent_step > 0) indent_ -= opts_.indent_step;
+    NewLine();
+    Indent();
+  }
+  void Indent() {
+    static const char spaces[] = "                                ";
+    for (auto n = indent_; n > 0; n -= static_cast<int>(sizeof(spaces) - 1)) {
+      Write(spaces, std::min(static_cast<size_t>(n), sizeof(spaces) - 1));
+    }
+  }
+  static bool IsIdentifier(const char *name, size_t len) {
+    if (!len || isdigit(static_cast<unsigned char>(name[0]))) return false;
+    for (size_t i = 0; i < len; i++) {
+      if (!isalnum(static_cast<unsigned char>(name[i])) && name[i] != '_')
+        return false;
+    }
+    return true;
+  }
+  void Hex(uint32_t i, int digits) {
+    char buf[8];
+    for (int d = digits - 1; d >= 0; d--, i >>= 4) {
+      buf[d] = "0123456789ABCDEF"[i & 0xF];
+    }
+    Write(buf, static_cast<size_t>(digits));
+  }
+
+  Sink &sink_;
+  const JsonOptions &opts_;
+  int indent_;
+  bool ok_;
+};
+
+// Tokenizer called by the generated ParseJson() functions. It accepts the
+// same JSON dialect as Parser: unquoted field names and enum identifiers,
+// trailing commas, and // and /* */ comments.
+class JsonReader {
+ public:
+  JsonReader(const char *json, size_t len)
+    : start_(json), cur_(json), end_(json + len) {}
+
+  bool ok() const { return error_.empty(); }
+  // Human readable error, including the line number.
+  const std::string &error() const { return error_; }
+
+  // Records the first error only, since later ones tend to be caused by it.
+  bool Error(const std::string &msg) {
+    if (ok()) {
+      int line = 1;
+      for (auto p = start_; p < cur_; p++) line += *p == '\n';
+      error_ = "line " + NumToString(line) + ": " + msg;
+    }
+    return false;
+  }
+
+  const char *Position() const { return cur_; }
+  void Rewind(const char *position) { cur_ = position; }
+
+  // Returns the next character without consuming it, 0 at the end.
+  char Peek() {
+    SkipWhitespace();
+    return cur_ < end_ ? *cur_ : 0;
+  }
+
+  bool Expect(char c) {
+    if (Peek() != c) return Error(std::string("expecting: ") + c);
+    cur_++;
+    return true;
+  }
+
+  // Expects nothing but whitespace to remain.
+  bool End() {
+    if (Peek() || cur_ != end_) return Error("expecting: end of file");
+    return true;
+  }
+
+  // Iterates the fields of an object: call with n set to 0 after
+  // Expect('{'). Returns false at the closing '}', or on error (check ok()).
+  bool NextField(int *n, const char **key, size_t *len) {
+    if (*n && Peek() != '}' && !Expect(',')) return false;
+    if (Peek() == '}') { cur_++; return false; }
+    if (Peek() == '\"') {
+      const std::string *s;
+      if (!String(&s)) return false;
+      *key = s->c_str();
+      *len = s->length();
+    } else {
+      *key = cur_;
+      while (cur_ < end_ && IsIdentifierChar(*cur_)) cur_++;
+      *len = static_cast<size_t>(cur_ - *key);
+      if (!*len) return Error("expecting: field name");
+    }
+    if (!Expect(':')) return false;
+    (*n)++;
+    return true;
+  }
+
+  // Iterates the elements of an array: call with the number of elements
+  // seen so far, after Expect('['). Returns false at the closing ']', or on
+  // error (check ok()).
+  bool NextElement(uoffset_t n) {
+    if (n && Peek() != ']' && !Expect(',')) return false;
+    if (Peek() == ']') { cur_++; return false; }
+    return true;
+  }
+
+  // Consumes a null value, with which a field is ignored.
+  bool Null() {
+    if (Peek() != 'n' || !MatchWord("null")) return false;
+    cur_ += 4;
+    return true;
+  }
+
+  // Marks a field as seen, failing if it was seen before.
+  bool Once(bool *seen, const char *name) {
+    if (*seen) return Error(std::string("field set more than once: ") + name);
+    *seen = true;
+    return true;
+  }
+
+  // Parses a string, unescaped into a buffer that is valid until the next
+  // call.
+  bool String(const std::string **str) {
+    if (!Expect('\"')) return false;
+    scratch_.clear();
+    for (;;) {
+      if (cur_ >= end_) return Error("unterminated string");
+      char c = *cur_++;
+      if (c == '\"') break;
+      if (c != '\\') { scratch_ += c; continue; }
+      if (cur_ >= end_) return Error("unterminated string");
+      switch (*cur_++) {
+        case 'n': scratch_ += '\n'; break;
+        case 't': scratch_ += '\t'; break;
+        case 'r': scratch_ += '\r'; break;
+        case 'b': scratch_ += '\b'; break;
+        case 'f': scratch_ += '\f'; break;
+        case '\"': scratch_ += '\"'; break;
+        case '\\': scratch_ += '\\'; break;
+        case '/': scratch_ += '/'; break;
+        case 'x': {
+          uint32_t val;
+          if (!Hex(2, &val)) return false;
+          scratch_ += static_cast<char>(val);
+          break;
+        }
+        case 'u': {
+          uint32_t val;
+          if (!Hex(4, &val)) return false;
+          if (val >= 0xD800 && val <= 0xDBFF && end_ - cur_ >= 6 &&
+              cur_[0] == '\\' && cur_[1] == 'u') {
+            // The first half of a surrogate pair.
+            auto backup = cur_;
+            uint32_t low;
+            cur_ += 2;
+            if (!Hex(4, &low)) return false;
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+              val = 0x10000 + ((val - 0xD800) << 10) + (low - 0xDC00);
+            } else {
+              cur_ = backup;
+            }
+          }
+          ToUTF8(val, &scratch_);
+          break;
+        }
+        default: return Error("unknown escape code in string constant");
+      }
+    }
+    *str = &scratch_;
+    return true;
+  }
+
+  // Parses a number (or a number in a string) into a scalar, with the same
+  // range checks as Parser.
+  template<typename T> bool Number(T *val) {
+    const char *token;
+    if (!NumberToken(&token)) return false;
+    return Convert(token, val);
+  }
+
+  // Parses an enum value: a number, or one or more identifiers separated by
+  // spaces, which are or-ed together. lookup returns false for unknown
+  // identifiers.
+  template<typename T> bool Enum(T *val,
+                                 bool (*lookup)(const char *name, size_t len,
+                                                int64_t *value)) {
+    auto c = Peek();
+    if (c != '\"' && !IsIdentifierStart(c)) return Number(val);
+    const char *words;
+    size_t len;
+    if (c == '\"') {
+      const std::string *s;
+      if (!String(&s)) return false;
+      if (!s->empty() && !IsIdentifierStart((*s)[0])) {
+        return Convert(s->c_str(), val);
+      }
+      words = s->c_str();
+      len = s->length();
+    } else {
+      words = cur_;
+      while (cur_ < end_ && IsIdentifierChar(*cur_)) cur_++;
+      len = static_cast<size_t>(cur_ - words);
+    }
+    // An empty string names no value, rather than 0.
+    if (!len) return Error("unknown enum value: ");
+    int64_t result = 0;
+    for (auto word = words, end = words + len; word < end; ) {
+      auto word_end = word;
+      while (word_end < end && *word_end != ' ') word_end++;
+      int64_t v;
+      if (!lookup(word, static_cast<size_t>(word_end - word), &v))
+        return Error("unknown enum value: " + std::string(word, word_end));
+      result |= v;
+      word = word_end;
+      while (word < end && *word == ' ') word++;
+    }
+    return Convert(NumToString(result).c_str(), val);
+  }
+
+  // Copies a number (or the contents of a string) into a zero terminated
+  // buffer, since the input need not be zero terminated. The buffer is valid
+  // until the next call.
+  bool NumberToken(const char **token) {
+    if (Peek() == '\"') {
+      const std::string *s;
+      if (!String(&s)) return false;
+      *token = s->c_str();
+      return true;
+    }
+    auto start = cur_;
+    while (cur_ < end_ && (IsIdentifierChar(*cur_) || *cur_ == '.' ||
+                           *cur_ == '-' || *cur_ == '+')) {
+      cur_++;
+    }
+    if (cur_ == start) {
+      return Error(cur_ < end_
+                   ? std::string("cannot parse value starting with: ") + *cur_
+                   : std::string("unexpected end of file"));
+    }
+    scratch_.assign(start, cur_);
+    *token = scratch_.c_str();
+    return true;
+  }
+
+  // Skips any value, e.g. to come back to it later.
+  bool SkipValue() {
+    switch (Peek()) {
+      case '{': {
+        cur_++;
+        int n = 0;
+        const char *key;
+        size_t len;
+        while (NextField(&n, &key, &len)) {
+          if (!SkipValue()) return false;
+        }
+        return ok();
+      }
+      case '[': {
+        cur_++;
+        uoffset_t n = 0;
+        for (; NextElement(n); n++) {
+          if (!SkipValue()) return false;
+        }
+        return ok();
+      }
+      case '\"': {
+        const std::string *s;
+        return String(&s);
+      }
+      default: {
+        const char *token;
+        return NumberToken(&token);
+      }
+    }
+  }
+
+ private:
+  static bool IsIdentifierStart(char c) {
+    return isalpha(static_cast<unsigned char>(c)) || c == '_';
+  }
+  static bool IsIdentifierChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+  }
+
+  bool Match(const char *word) const {
+    auto len = strlen(word);
+    return static_cast<size_t>(end_ - cur_) >= len &&
+           !memcmp(cur_, word, len);
+  }
+
+  // Like Match(), but word must not just be the start of a longer
+  // identifier, such as "null" in "nullable".
+  bool MatchWord(const char *word) const {
+    auto len = strlen(word);
+    return Match(word) &&
+           (static_cast<size_t>(end_ - cur_) == len ||
+            !IsIdentifierChar(cur_[len]));
+  }
+
+  void SkipWhitespace() {
+    while (cur_ < end_) {
+      auto c = *cur_;
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        cur_++;
+      } else if (c == '/' && end_ - cur_ > 1 && cur_[1] == '/') {
+        while (cur_ < end_ && *cur_ != '\n') cur_++;
+      } else if (c == '/' && end_ - cur_ > 1 && cur_[1] == '*') {
+        cur_ += 2;
+        while (cur_ < end_ && !Match("*/")) cur_++;
+        cur_ = std::min(cur_ + 2, end_);
+      } else {
+        break;
+      }
+    }
+  }
+
+  bool Hex(int digits, uint32_t *val) {
+    *val = 0;
+    for (int i = 0; i < digits; i++, cur_++) {
+      if (cur_ >= end_ || !isxdigit(static_cast<unsigned char>(*cur_)))
+        return Error("escape code must be followed by hex digits");
+      auto c = *cur_;
+      *val = *val * 16 + static_cast<uint32_t>(
+          isdigit(static_cast<unsigned char>(c)) ? c - '0'
+                                                 : (c | 0x20) - 'a' + 10);
+    }
+    return true;
+  }
+
+  template<typename T> bool Convert(const char *token, T *val) {
+    if (!strcmp(token, "true")) token = "1";
+    else if (!strcmp(token, "false")) token = "0";
+    char *end;
+    auto i = StringToInt(token, &end);
+    if (*end) return Error(std::string("invalid integer: ") + token);
+    // Same check as Parser::CheckBitsFit().
+    if (sizeof(T) < 8) {
+      auto mask = static_cast<int64_t>((1ull << (sizeof(T) * 8)) - 1);
+      if ((i & ~mask) != 0 && (i | mask) != -1)
+        return Error("constant does not fit in a " +
+                     NumToString(sizeof(T) * 8) + "-bit field");
+    }
+    *val = static_cast<T>(i);
+    return true;
+  }
+  bool Convert(const char *token, uint64_t *val) {
+    char *end;
+    *val = StringToUInt(token, &end);
+    if (*end) return Error(std::string("invalid integer: ") + token);
+    return true;
+  }
+  bool Convert(const char *token, bool *val) {
+    int64_t i;
+    if (!Convert(token, &i)) return false;
+    *val = i != 0;
+    return true;
+  }
+  bool Convert(const char *token, float *val) {
+    double d;
+    if (!Convert(token, &d)) return false;
+    *val = static_cast<float>(d);
+    return true;
+  }
+  bool Convert(const char *token, double *val) {
+    char *end;
+    *val = strtod(token, &end);
+    if (*end) return Error(std::string("invalid float: ") + token);
+    return true;
+  }
+
+  const char *start_;
+  const char *cur_;
+  const char *end_;
+  std::string scratch_;
+  std::string error_;
+};
+
+// Parses the JSON representation of table T into fbb, using the functions
+// flatc generates with --gen-json-functions. Returns a null offset on
+// failure, with the reason in *error if given.
+template<typename T> Offset<T> FromJson(const char *json, size_t len,
+                                        FlatBufferBuilder &fbb,
+                                        std::string *error = nullptr) {
+  JsonReader reader(json, len);
+  Offset<T> root;
+  if (!ParseJson(&root, fbb, reader) || !reader.End()) {
+    if (error) *error = reader.error();
+    return Offset<T>();
+  }
+  return root;
+}
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_JSON_H_
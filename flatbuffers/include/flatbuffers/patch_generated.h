@@ -0,0 +1,458 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+
+#ifndef FLATBUFFERS_GENERATED_PATCH_REFLECTION_H_
+#define FLATBUFFERS_GENERATED_PATCH_REFLECTION_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+namespace reflection {
+
+struct PatchValue;
+
+struct PatchSplice;
+
+struct PatchElement;
+
+struct PatchField;
+
+struct PatchTable;
+
+enum PatchOp {
+  PatchOp_Set = 0,
+  PatchOp_Clear = 1,
+  PatchOp_Modify = 2,
+  PatchOp_MIN = PatchOp_Set,
+  PatchOp_MAX = PatchOp_Modify
+};
+
+inline const char **EnumNamesPatchOp() {
+  static const char *names[] = {
+    "Set",
+    "Clear",
+    "Modify",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNamePatchOp(PatchOp e) {
+  const size_t index = static_cast<int>(e);
+  return EnumNamesPatchOp()[index];
+}
+
+struct PatchValue FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_DATA = 4,
+    VT_UNION_TYPE = 6
+  };
+  const flatbuffers::Vector<uint8_t> *data() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_DATA);
+  }
+  uint8_t union_type() const {
+    return GetField<uint8_t>(VT_UNION_TYPE, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_DATA) &&
+           verifier.Verify(data()) &&
+           VerifyField<uint8_t>(verifier, VT_UNION_TYPE) &&
+           verifier.EndTable();
+  }
+};
+
+struct PatchValueBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_data(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data) {
+    fbb_.AddOffset(PatchValue::VT_DATA, data);
+  }
+  void add_union_type(uint8_t union_type) {
+    fbb_.AddElement<uint8_t>(PatchValue::VT_UNION_TYPE, union_type, 0);
+  }
+  PatchValueBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  PatchValueBuilder &operator=(const PatchValueBuilder &);
+  flatbuffers::Offset<PatchValue> Finish() {
+    const auto end = fbb_.EndTable(start_, 2);
+    auto o = flatbuffers::Offset<PatchValue>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PatchValue> CreatePatchValue(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data = 0,
+    uint8_t union_type = 0) {
+  PatchValueBuilder builder_(_fbb);
+  builder_.add_data(data);
+  builder_.add_union_type(union_type);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PatchValue> CreatePatchValueDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const std::vector<uint8_t> *data = nullptr,
+    uint8_t union_type = 0) {
+  return reflection::CreatePatchValue(
+      _fbb,
+      data ? _fbb.CreateVector<uint8_t>(*data) : 0,
+      union_type);
+}
+
+struct PatchSplice FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_START = 4,
+    VT_REMOVE = 6,
+    VT_DATA = 8,
+    VT_VALUES = 10
+  };
+  uint32_t start() const {
+    return GetField<uint32_t>(VT_START, 0);
+  }
+  uint32_t remove() const {
+    return GetField<uint32_t>(VT_REMOVE, 0);
+  }
+  const flatbuffers::Vector<uint8_t> *data() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_DATA);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<PatchValue>> *values() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<PatchValue>> *>(VT_VALUES);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_START) &&
+           VerifyField<uint32_t>(verifier, VT_REMOVE) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_DATA) &&
+           verifier.Verify(data()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_VALUES) &&
+           verifier.Verify(values()) &&
+           verifier.VerifyVectorOfTables(values()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PatchSpliceBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_start(uint32_t start) {
+    fbb_.AddElement<uint32_t>(PatchSplice::VT_START, start, 0);
+  }
+  void add_remove(uint32_t remove) {
+    fbb_.AddElement<uint32_t>(PatchSplice::VT_REMOVE, remove, 0);
+  }
+  void add_data(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data) {
+    fbb_.AddOffset(PatchSplice::VT_DATA, data);
+  }
+  void add_values(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchValue>>> values) {
+    fbb_.AddOffset(PatchSplice::VT_VALUES, values);
+  }
+  PatchSpliceBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  PatchSpliceBuilder &operator=(const PatchSpliceBuilder &);
+  flatbuffers::Offset<PatchSplice> Finish() {
+    const auto end = fbb_.EndTable(start_, 4);
+    auto o = flatbuffers::Offset<PatchSplice>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PatchSplice> CreatePatchSplice(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t start = 0,
+    uint32_t remove = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchValue>>> values = 0) {
+  PatchSpliceBuilder builder_(_fbb);
+  builder_.add_values(values);
+  builder_.add_data(data);
+  builder_.add_remove(remove);
+  builder_.add_start(start);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PatchSplice> CreatePatchSpliceDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t start = 0,
+    uint32_t remove = 0,
+    const std::vector<uint8_t> *data = nullptr,
+    const std::vector<flatbuffers::Offset<PatchValue>> *values = nullptr) {
+  return reflection::CreatePatchSplice(
+      _fbb,
+      start,
+      remove,
+      data ? _fbb.CreateVector<uint8_t>(*data) : 0,
+      values ? _fbb.CreateVector<flatbuffers::Offset<PatchValue>>(*values) : 0);
+}
+
+struct PatchElement FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_INDEX = 4,
+    VT_PATCH = 6
+  };
+  uint32_t index() const {
+    return GetField<uint32_t>(VT_INDEX, 0);
+  }
+  const PatchTable *patch() const {
+    return GetPointer<const PatchTable *>(VT_PATCH);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_INDEX) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_PATCH) &&
+           verifier.VerifyTable(patch()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PatchElementBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_index(uint32_t index) {
+    fbb_.AddElement<uint32_t>(PatchElement::VT_INDEX, index, 0);
+  }
+  void add_patch(flatbuffers::Offset<PatchTable> patch) {
+    fbb_.AddOffset(PatchElement::VT_PATCH, patch);
+  }
+  PatchElementBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  PatchElementBuilder &operator=(const PatchElementBuilder &);
+  flatbuffers::Offset<PatchElement> Finish() {
+    const auto end = fbb_.EndTable(start_, 2);
+    auto o = flatbuffers::Offset<PatchElement>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PatchElement> CreatePatchElement(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t index = 0,
+    flatbuffers::Offset<PatchTable> patch = 0) {
+  PatchElementBuilder builder_(_fbb);
+  builder_.add_patch(patch);
+  builder_.add_index(index);
+  return builder_.Finish();
+}
+
+struct PatchField FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_ID = 4,
+    VT_OP = 6,
+    VT_DATA = 8,
+    VT_UNION_TYPE = 10,
+    VT_PATCH = 12,
+    VT_SPLICES = 14,
+    VT_ELEMENTS = 16
+  };
+  uint16_t id() const {
+    return GetField<uint16_t>(VT_ID, 0);
+  }
+  bool KeyCompareLessThan(const PatchField *o) const {
+    return id() < o->id();
+  }
+  int KeyCompareWithValue(uint16_t val) const {
+    const auto key = id();
+    if (key < val) {
+      return -1;
+    } else if (key > val) {
+      return 1;
+    } else {
+      return 0;
+    }
+  }
+  PatchOp op() const {
+    return static_cast<PatchOp>(GetField<int8_t>(VT_OP, 0));
+  }
+  const flatbuffers::Vector<uint8_t> *data() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_DATA);
+  }
+  uint8_t union_type() const {
+    return GetField<uint8_t>(VT_UNION_TYPE, 0);
+  }
+  const PatchTable *patch() const {
+    return GetPointer<const PatchTable *>(VT_PATCH);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<PatchSplice>> *splices() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<PatchSplice>> *>(VT_SPLICES);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<PatchElement>> *elements() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<PatchElement>> *>(VT_ELEMENTS);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint16_t>(verifier, VT_ID) &&
+           VerifyField<int8_t>(verifier, VT_OP) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_DATA) &&
+           verifier.Verify(data()) &&
+           VerifyField<uint8_t>(verifier, VT_UNION_TYPE) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_PATCH) &&
+           verifier.VerifyTable(patch()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_SPLICES) &&
+           verifier.Verify(splices()) &&
+           verifier.VerifyVectorOfTables(splices()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_ELEMENTS) &&
+           verifier.Verify(elements()) &&
+           verifier.VerifyVectorOfTables(elements()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PatchFieldBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_id(uint16_t id) {
+    fbb_.AddElement<uint16_t>(PatchField::VT_ID, id, 0);
+  }
+  void add_op(PatchOp op) {
+    fbb_.AddElement<int8_t>(PatchField::VT_OP, static_cast<int8_t>(op), 0);
+  }
+  void add_data(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data) {
+    fbb_.AddOffset(PatchField::VT_DATA, data);
+  }
+  void add_union_type(uint8_t union_type) {
+    fbb_.AddElement<uint8_t>(PatchField::VT_UNION_TYPE, union_type, 0);
+  }
+  void add_patch(flatbuffers::Offset<PatchTable> patch) {
+    fbb_.AddOffset(PatchField::VT_PATCH, patch);
+  }
+  void add_splices(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchSplice>>> splices) {
+    fbb_.AddOffset(PatchField::VT_SPLICES, splices);
+  }
+  void add_elements(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchElement>>> elements) {
+    fbb_.AddOffset(PatchField::VT_ELEMENTS, elements);
+  }
+  PatchFieldBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  PatchFieldBuilder &operator=(const PatchFieldBuilder &);
+  flatbuffers::Offset<PatchField> Finish() {
+    const auto end = fbb_.EndTable(start_, 7);
+    auto o = flatbuffers::Offset<PatchField>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PatchField> CreatePatchField(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint16_t id = 0,
+    PatchOp op = PatchOp_Set,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data = 0,
+    uint8_t union_type = 0,
+    flatbuffers::Offset<PatchTable> patch = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchSplice>>> splices = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchElement>>> elements = 0) {
+  PatchFieldBuilder builder_(_fbb);
+  builder_.add_elements(elements);
+  builder_.add_splices(splices);
+  builder_.add_patch(patch);
+  builder_.add_data(data);
+  builder_.add_id(id);
+  builder_.add_union_type(union_type);
+  builder_.add_op(op);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PatchField> CreatePatchFieldDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint16_t id = 0,
+    PatchOp op = PatchOp_Set,
+    const std::vector<uint8_t> *data = nullptr,
+    uint8_t union_type = 0,
+    flatbuffers::Offset<PatchTable> patch = 0,
+    const std::vector<flatbuffers::Offset<PatchSplice>> *splices = nullptr,
+    const std::vector<flatbuffers::Offset<PatchElement>> *elements = nullptr) {
+  return reflection::CreatePatchField(
+      _fbb,
+      id,
+      op,
+      data ? _fbb.CreateVector<uint8_t>(*data) : 0,
+      union_type,
+      patch,
+      splices ? _fbb.CreateVector<flatbuffers::Offset<PatchSplice>>(*splices) : 0,
+      elements ? _fbb.CreateVector<flatbuffers::Offset<PatchElement>>(*elements) : 0);
+}
+
+struct PatchTable FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_FIELDS = 4
+  };
+  const flatbuffers::Vector<flatbuffers::Offset<PatchField>> *fields() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<PatchField>> *>(VT_FIELDS);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_FIELDS) &&
+           verifier.Verify(fields()) &&
+           verifier.VerifyVectorOfTables(fields()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PatchTableBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_fields(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchField>>> fields) {
+    fbb_.AddOffset(PatchTable::VT_FIELDS, fields);
+  }
+  PatchTableBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  PatchTableBuilder &operator=(const PatchTableBuilder &);
+  flatbuffers::Offset<PatchTable> Finish() {
+    const auto end = fbb_.EndTable(start_, 1);
+    auto o = flatbuffers::Offset<PatchTable>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PatchTable> CreatePatchTable(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<PatchField>>> fields = 0) {
+  PatchTableBuilder builder_(_fbb);
+  builder_.add_fields(fields);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PatchTable> CreatePatchTableDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const std::vector<flatbuffers::Offset<PatchField>> *fields = nullptr) {
+  return reflection::CreatePatchTable(
+      _fbb,
+      fields ? _fbb.CreateVector<flatbuffers::Offset<PatchField>>(*fields) : 0);
+}
+
+inline const reflection::PatchTable *GetPatchTable(const void *buf) {
+  return flatbuffers::GetRoot<reflection::PatchTable>(buf);
+}
+
+inline const char *PatchTableIdentifier() {
+  return "FBPT";
+}
+
+inline bool PatchTableBufferHasIdentifier(const void *buf) {
+  return flatbuffers::BufferHasIdentifier(
+      buf, PatchTableIdentifier());
+}
+
+inline bool VerifyPatchTableBuffer(
+    flatbuffers::Verifier &verifier) {
+  return verifier.VerifyBuffer<reflection::PatchTable>(PatchTableIdentifier());
+}
+
+inline void FinishPatchTableBuffer(
+    flatbuffers::FlatBufferBuilder &fbb,
+    flatbuffers::Offset<reflection::PatchTable> root) {
+  fbb.Finish(root, PatchTableIdentifier());
+}
+
+}  // namespace reflection
+
+#endif  // FLATBUFFERS_GENERATED_PATCH_REFLECTION_H_
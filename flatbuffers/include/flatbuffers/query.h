@@ -0,0 +1,99 @@
+/*
+ * Copyright 2017 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_QUERY_H_
+#define FLATBUFFERS_QUERY_H_
+
+#include "flatbuffers/reflection.h"
+
+// Predicates over FlatBuffers, evaluated without unpacking them.
+
+namespace flatbuffers {
+
+// A predicate over the fields of a table, such as:
+//   hp > 100 && name startswith "Orc"
+// compiled against a schema into bytecode that reads the fields through
+// CompiledPaths.
+//
+// Predicates compare a field path with a constant using ==, !=, <, <=, >, >=
+// or (for strings) startswith, and are combined with &&, || and !, grouped
+// with parentheses. Constants are numbers, "strings" (in which \" and \\ are
+// the only escapes), true and false, or the name of a value of the field's
+// enum. A path on its own is true if the field is set. Unset scalars compare
+// as their default, comparisons with an unset string are false (except for
+// !=, which is true).
+//
+// Evaluating a Query doesn't modify it, so one can be shared between threads.
+class Query {
+ public:
+  // "schema" must outlive the query.
+  explicit Query(const CompiledSchema &schema) : schema_(schema) {}
+
+  // Returns false and sets error() if "expr" isn't a valid predicate over
+  // tables of type "objectdef". The query is empty (and always true) then.
+  bool Compile(const reflection::Object &objectdef, const std::string &expr);
+
+  const std::string &error() const { return error_; }
+
+  bool Evaluate(const Table &table) const;
+
+  // Evaluates the predicate on the root tables of "count" buffers, and sets
+  // results[i] to 1 if buffers[i] matches, 0 if not.
+  // This runs one instruction at a time over blocks of buffers, rather than
+  // all instructions over one buffer at a time, which is a lot faster for
+  // many small buffers.
+  void Evaluate(const uint8_t *const *buffers, size_t count,
+                uint8_t *results) const;
+
+  enum Comparison { kEq, kNe, kLt, kLe, kGt, kGe, kStartsWith };
+
+ private:
+  enum Opcode {
+    kCompareInt,     // Reads "path" with GetI.
+    kCompareUInt,    // Reads "path" with GetI, and compares it as unsigned.
+    kCompareFloat,   // Reads "path" with GetF.
+    kCompareString,  // Reads "path" with GetString.
+    kIsSet,
+    kAnd,
+    kOr,
+    kNot
+  };
+
+  struct Instruction {
+    Opcode op;
+    Comparison cmp;
+    uint32_t path;      // Into paths_.
+    uint32_t constant;  // Into ints_, floats_ or strings_.
+  };
+
+  // Enough for any reasonable expression, so evaluating needn't allocate.
+  static const size_t kMaxDepth = 32;
+  static const size_t kBlockSize = 256;
+
+  class Compiler;
+
+  const CompiledSchema &schema_;
+  std::string error_;
+  std::vector<Instruction> code_;  // In postfix order.
+  std::vector<CompiledPath> paths_;
+  std::vector<int64_t> ints_;
+  std::vector<double> floats_;
+  std::vector<std::string> strings_;
+};
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_QUERY_H_
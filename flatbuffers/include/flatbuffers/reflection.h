@@ -23,6 +23,9 @@
 // previous version of flatc whenever this code needs to change.
 // See reflection/generate_code.sh
 #include "flatbuffers/reflection_generated.h"
+#include "flatbuffers/patch_generated.h"
+
+#include <unordered_map>
 
 // Helper functionality for reflection.
 
@@ -410,6 +413,80 @@ void ResizeVector(const reflection::Schema &schema, uoffset_t newsize, T val,
 }
 #endif
 
+// Records many string and vector resizes on a FlatBuffer, and then applies
+// them together. SetString and ResizeAnyVector above each walk the whole
+// object graph and move every byte after the edit, so N edits cost N passes
+// over the buffer. Apply() instead fixes up all offsets in a single walk, and
+// rebuilds the buffer with a single copy.
+// Nothing in "flatbuf" changes until Apply() is called, so pointers into it
+// obtained before recording stay valid until then. If the same string or
+// vector is edited more than once, the last edit wins.
+// New vector elements are set to "fill" (one element worth of bytes), or to 0
+// if it is null. Elements that are offsets must be set by the caller after
+// Apply(), e.g. using AddFlatBuffer and Vector::MutateOffset.
+class MutationBatch {
+ public:
+  MutationBatch(const reflection::Schema &schema,
+                std::vector<uint8_t> *flatbuf,
+                const reflection::Object *root_table = nullptr)
+    : schema_(schema), buf_(*flatbuf), root_table_(root_table) {}
+
+  void SetString(const String *str, const std::string &val);
+
+  void ResizeAnyVector(const VectorOfAny *vec, uoffset_t newsize,
+                       uoffset_t num_elems, uoffset_t elem_size,
+                       const uint8_t *fill = nullptr);
+
+  #ifndef FLATBUFFERS_CPP98_STL
+  template<typename T> void ResizeVector(const Vector<T> *vec,
+                                         uoffset_t newsize, T val) {
+    uint8_t fill[sizeof(T)];
+    if (std::is_scalar<T>::value) {
+      WriteScalar(fill, val);
+    } else {  // struct
+      memcpy(fill, &val, sizeof(T));
+    }
+    ResizeAnyVector(reinterpret_cast<const VectorOfAny *>(vec), newsize,
+                    vec->size(), static_cast<uoffset_t>(sizeof(T)), fill);
+  }
+  #endif
+
+  // Number of edits recorded since the last Apply().
+  size_t size() const { return edits_.size(); }
+
+  // Resizes the buffer and writes all recorded edits. Pointers into the
+  // buffer are invalidated.
+  void Apply();
+
+ private:
+  struct Edit {
+    uoffset_t object;     // String or vector being edited.
+    uoffset_t start;      // End of its old data, where bytes are inserted.
+    int delta;            // Bytes inserted (or removed, if negative).
+    uoffset_t old_size;   // Old number of chars or elements.
+    uoffset_t new_size;   // New number of chars or elements.
+    uoffset_t elem_size;
+    bool is_string;
+    std::string data;     // New string contents, or vector fill element.
+  };
+
+  void AddEdit(Edit &edit);
+  uoffset_t NewPos(uoffset_t pos) const;
+  const Edit *FindEdit(uoffset_t start) const;
+  void FixOffset(uoffset_t offsetloc);
+  void FixTable(const reflection::Object &objectdef, uoffset_t tableloc);
+
+  const reflection::Schema &schema_;
+  std::vector<uint8_t> &buf_;
+  const reflection::Object *root_table_;
+  std::vector<Edit> edits_;
+  // Valid during Apply() only:
+  std::vector<uoffset_t> starts_;
+  std::vector<int64_t> shifts_;
+  std::vector<uint8_t> newbuf_;
+  std::vector<bool> visited_;
+};
+
 // Adds any new data (in the form of a new FlatBuffer) to an existing
 // FlatBuffer. This can be used when any of the above methods are not
 // sufficient, in particular for adding new tables and new fields.
@@ -429,21 +506,666 @@ inline bool SetFieldT(Table *table, const reflection::Field &field,
 
 // ------------------------- COPYING -------------------------
 
+// A set of field paths to copy out of a table with ProjectTable, such as
+// "name", or "enemy.name" to copy just the name of a sub-table. A path
+// through a vector of tables applies to every element. The paths are
+// resolved against the schema once, into a tree of per-object bitsets.
+// Selecting a union also selects its type field. Take care to select all
+// required fields, or the result won't verify.
+class FieldMask {
+ public:
+  FieldMask(const reflection::Schema &schema,
+            const reflection::Object &objectdef);
+
+  // Returns false if the path doesn't name a field, or goes through a field
+  // that isn't a table or vector of tables.
+  bool Add(const std::string &path);
+
+  const reflection::Object &object() const { return *nodes_[0].objectdef; }
+
+ private:
+  friend class TableCopier;
+
+  struct Node {
+    const reflection::Object *objectdef;
+    std::vector<uint64_t> selected;  // By field id.
+    // Node index for fields of which only some sub-fields are selected,
+    // 0 if the whole field is.
+    std::vector<size_t> children;
+
+    bool IsSelected(voffset_t id) const {
+      return (selected[id / 64] >> (id % 64)) & 1;
+    }
+  };
+
+  size_t AddNode(const reflection::Object &objectdef);
+  void Select(size_t node, voffset_t id);
+
+  const reflection::Schema &schema_;
+  std::vector<Node> nodes_;
+};
+
+// Deep copies tables out of existing FlatBuffers into a FlatBufferBuilder.
+// The fields to copy are planned once per object type, strings and vectors of
+// scalars or structs are copied in one go, and objects referenced more than
+// once are copied only once, so a DAG stays a DAG.
+// Keep one instance around for as long as you copy into the same builder, so
+// plans and shared objects are reused across copies. Call Reset() if you
+// Clear() the builder.
+// Copied objects are remembered by their address in the source, so also call
+// Reset() before a source buffer is freed, reused or modified; otherwise a
+// later copy may return offsets to the copy of whatever was there before.
+// If every table you copy lives in one buffer, pass it as "buf" and "size" to
+// track copied objects in a flat array rather than a hash map.
+class TableCopier {
+ public:
+  TableCopier(FlatBufferBuilder &fbb, const reflection::Schema &schema,
+              bool use_string_pooling = false,
+              const uint8_t *buf = nullptr, size_t size = 0);
+
+  // "objectdef" must be a table: structs are copied along with the table or
+  // vector that holds them. Returns 0 for a struct.
+  Offset<const Table *> CopyTable(const reflection::Object &objectdef,
+                                  const Table &table);
+
+  // Copies only the fields selected by "mask", which must be for
+  // "objectdef". Projected copies are not shared.
+  Offset<const Table *> CopyTable(const reflection::Object &objectdef,
+                                  const Table &table, const FieldMask &mask);
+
+  // Copies a string, vector, table or union field of "table", returning 0
+  // if it isn't set.
+  uoffset_t CopyField(const reflection::Object &objectdef,
+                      const reflection::Field &fielddef, const Table &table);
+
+  uoffset_t CopyString(const String &str);
+
+  // Forgets all objects copied so far (but not the plans).
+  void Reset();
+
+  void operator=(const TableCopier &tc);
+
+ private:
+  struct ObjectPlan;
+
+  struct FieldPlan {
+    voffset_t id;
+    voffset_t offset;
+    reflection::BaseType base_type;
+    reflection::BaseType element;  // For vectors.
+    size_t size;        // Inline size of the field.
+    size_t align;
+    size_t elem_size;   // For vectors of scalars and structs.
+    size_t elem_align;
+    bool is_offset;
+    const ObjectPlan *object;  // For tables and vectors of tables.
+    // For unions and vectors of unions, indexed by the union type.
+    const std::vector<const ObjectPlan *> *union_types;
+  };
+
+  struct ObjectPlan {
+    // In order of decreasing alignment, which is the order we add them in.
+    std::vector<FieldPlan> fields;
+    voffset_t numfields;
+  };
+
+  const ObjectPlan *GetPlan(const reflection::Object &objectdef);
+  const std::vector<const ObjectPlan *> *GetUnionPlans(
+                                               const reflection::Enum &enumdef);
+  uoffset_t &Copied(const void *obj);
+  // A null "node" copies the whole object.
+  uoffset_t CopyObject(const ObjectPlan &plan, const Table &table,
+                       const FieldMask::Node *node);
+  uoffset_t CopyOffsetField(const FieldPlan &field, const Table &table,
+                            const uint8_t *ref, const FieldMask::Node *node);
+  uoffset_t CopyVector(const FieldPlan &field, const Table &table,
+                       const VectorOfAny &vec, const FieldMask::Node *node);
+
+  FlatBufferBuilder &fbb_;
+  const reflection::Schema &schema_;
+  bool use_string_pooling_;
+  const uint8_t *buf_;
+  size_t size_;
+  std::unordered_map<const reflection::Object *, ObjectPlan> plans_;
+  std::unordered_map<const reflection::Enum *,
+                     std::vector<const ObjectPlan *>> union_plans_;
+  // Where each source object was copied to, by position if "buf" was given.
+  std::vector<uoffset_t> copied_;
+  std::unordered_map<const void *, uoffset_t> copied_map_;
+  // Offsets of copied subobjects, for all tables and vectors being copied.
+  std::vector<Offset<void>> offsets_;
+  const FieldMask *mask_;
+};
+
 // Generic copying of tables from a FlatBuffer into a FlatBuffer builder.
 // Can be used to do any kind of merging/selecting you may want to do out
-// of existing buffers. Also useful to reconstruct a whole buffer if the
-// above resizing functionality has introduced garbage in a buffer you want
-// to remove.
-// Note: this does not deal with DAGs correctly. If the table passed forms a
-// DAG, the copy will be a tree instead (with duplicates). Strings can be
-// shared however, by passing true for use_string_pooling.
-
+// of existing buffers. To remove garbage introduced by the above resizing
+// functionality, use Compact below instead.
+// Strings can be shared by passing true for use_string_pooling.
+// "objectdef" must be a table, 0 is returned for a struct.
+// This is a one-off TableCopier, use one directly when copying many tables.
 Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
                                 const reflection::Schema &schema,
                                 const reflection::Object &objectdef,
                                 const Table &table,
                                 bool use_string_pooling = false);
 
+// Copies the fields of "table" selected by "mask" into "fbb".
+// This is a one-off TableCopier, use one directly when projecting many tables.
+Offset<const Table *> ProjectTable(FlatBufferBuilder &fbb,
+                                   const reflection::Schema &schema,
+                                   const reflection::Object &objectdef,
+                                   const Table &table,
+                                   const FieldMask &mask);
+
+// Removes the garbage that resizing (see SetString, MutationBatch) and
+// AddFlatBuffer leave behind, by copying only the objects reachable from the
+// root into a new buffer in one pass. Unlike a CopyTable round trip, objects
+// referenced more than once are copied once and stay shared, identical
+// vtables are shared, and table fields are laid out to minimize padding.
+// The file identifier, if any, is kept.
+// Returns the number of bytes reclaimed. If the copy would not be smaller,
+// "flatbuf" is left unchanged and 0 is returned.
+// If your FlatBuffer's root table is not the schema's root table, you should
+// pass in your root_table type as well.
+size_t Compact(const reflection::Schema &schema,
+               std::vector<uint8_t> *flatbuf,
+               const reflection::Object *root_table = nullptr);
+
+// ------------------------- DIFF / PATCH -------------------------
+
+// Computes a patch that turns the FlatBuffer "from" into "to", and finishes
+// it in "patchfbb". See reflection/patch.fbs for its format: it only holds
+// fields that were set or cleared, changes to sub-tables, the range of
+// elements that changed in vectors, and changes to elements of vectors of
+// tables of the same length, so it is usually much smaller than "to".
+// If your FlatBuffer's root table is not the schema's root table, you should
+// pass in your root_table type as well.
+void Diff(const reflection::Schema &schema, const uint8_t *from,
+          const uint8_t *to, FlatBufferBuilder *patchfbb,
+          const reflection::Object *root_table = nullptr);
+
+// Builds the FlatBuffer that "patch" (created by Diff) turns "base" into,
+// and finishes it in "fbb". The parts of "base" that didn't change are
+// copied with a TableCopier, so objects shared in "base" stay shared.
+// The file identifier, if any, is kept.
+void ApplyPatch(const reflection::Schema &schema, const uint8_t *base,
+                const uint8_t *patch, FlatBufferBuilder *fbb,
+                const reflection::Object *root_table = nullptr);
+
+// ------------------------- MERGE -------------------------
+
+// What Merge does with vectors set in both tables.
+enum MergePolicy {
+  kMergeReplaceVectors,  // Use the overlay's vector.
+  kMergeConcatVectors    // Append the overlay's elements to the base's.
+};
+
+// Builds a table that has the fields of "overlay" where it has them set, and
+// those of "base" elsewhere, in one pass. Sub-tables (and unions of the same
+// type) set in both are merged recursively, everything else is copied whole
+// from the table it comes from, keeping shared objects shared.
+// Both tables must be of type "objectdef".
+// Note that concatenating vectors of tables sorted by key can leave the
+// result unsorted.
+Offset<const Table *> Merge(FlatBufferBuilder &fbb,
+                            const reflection::Schema &schema,
+                            const reflection::Object &objectdef,
+                            const Table &base, const Table &overlay,
+                            MergePolicy policy = kMergeReplaceVectors);
+
+// ------------------------- COMPILED ACCESSORS -------------------------
+
+// How to read one field, see CompiledSchema.
+struct CompiledField {
+  const reflection::Field *fielddef;
+  const reflection::Object *objectdef;  // For tables and structs.
+  int64_t default_i;
+  double default_f;
+  // Read the scalar at the given address, 0 for non-scalars.
+  int64_t (*read_i)(const uint8_t *p);
+  double (*read_f)(const uint8_t *p);
+};
+
+// A path of fields from a table, such as "enemy.pos.x", resolved by
+// CompiledSchema::Compile. Reading through it does no name lookups, no
+// switching on the field type and no allocation.
+class CompiledPath {
+ public:
+  CompiledPath() : field_(nullptr), offset_(0), struct_offset_(0) {}
+
+  bool IsValid() const { return field_ != nullptr; }
+  const reflection::Field &field() const { return *field_->fielddef; }
+  reflection::BaseType type() const {
+    return field_->fielddef->type()->base_type();
+  }
+
+  // Where the field is stored inline, or null if it, or a table on the way
+  // to it, is not set.
+  const uint8_t *GetAddress(const Table &table) const {
+    auto t = &table;
+    for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+      t = t->GetPointer<const Table *>(*it);
+      if (!t) return nullptr;
+    }
+    auto p = t->GetAddressOf(offset_);
+    return p ? p + struct_offset_ : nullptr;
+  }
+
+  // Reads a scalar field, converting it if needed, or returns its default if
+  // it is not set.
+  int64_t GetI(const Table &table) const {
+    auto p = GetAddress(table);
+    return p ? field_->read_i(p) : field_->default_i;
+  }
+  double GetF(const Table &table) const {
+    auto p = GetAddress(table);
+    return p ? field_->read_f(p) : field_->default_f;
+  }
+
+  // These return null if the field is not set, or is of another type.
+  const String *GetString(const Table &table) const {
+    return type() == reflection::String ? Deref<const String *>(table)
+                                        : nullptr;
+  }
+  const Table *GetTable(const Table &table) const {
+    return type() == reflection::Obj && !field_->objectdef->is_struct()
+           ? Deref<const Table *>(table)
+           : nullptr;
+  }
+  const VectorOfAny *GetVector(const Table &table) const {
+    return type() == reflection::Vector ? Deref<const VectorOfAny *>(table)
+                                        : nullptr;
+  }
+
+ private:
+  friend class CompiledSchema;
+
+  template<typename P> P Deref(const Table &table) const {
+    auto p = GetAddress(table);
+    return p ? reinterpret_cast<P>(p + ReadScalar<uoffset_t>(p)) : nullptr;
+  }
+
+  const CompiledField *field_;
+  std::vector<voffset_t> tables_;  // Vtable offsets of the tables on the way.
+  voffset_t offset_;               // Vtable offset in the last table.
+  uoffset_t struct_offset_;        // If the path goes into a struct.
+};
+
+// Accessors for every field of every object in a schema, built once.
+// Nothing changes after construction, so one instance (and the paths compiled
+// from it) can be shared by any number of threads. It must outlive its paths.
+class CompiledSchema {
+ public:
+  explicit CompiledSchema(const reflection::Schema &schema);
+
+  const reflection::Schema &schema() const { return schema_; }
+
+  // Compiles a path of field names separated by '.', starting at a table of
+  // type "objectdef". All fields but the last must be tables or structs.
+  // Returns false if the path can't be resolved.
+  bool Compile(const reflection::Object &objectdef, const std::string &path,
+               CompiledPath *compiled) const;
+
+  // Same, for a table of the type with the given fully qualified name.
+  bool Compile(const std::string &object_name, const std::string &path,
+               CompiledPath *compiled) const;
+
+ private:
+  const reflection::Schema &schema_;
+  // By field id.
+  std::unordered_map<const reflection::Object *,
+                     std::vector<CompiledField>> fields_;
+};
+
+// ------------------------- DYNAMIC BUILDER -------------------------
+
+// The BaseType a C++ scalar is stored as. Use integers for bools and enums.
+template<typename T> reflection::BaseType ScalarBaseType() {
+  if (std::is_floating_point<T>::value)
+    return sizeof(T) == sizeof(float) ? reflection::Float : reflection::Double;
+  auto log2size = sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4
+                  ? 2 : 3;
+  return static_cast<reflection::BaseType>(reflection::Byte + log2size * 2 +
+                                           !std::is_signed<T>::value);
+}
+
+// Builds FlatBuffers of types only known at runtime, such as from a schema
+// loaded from a .bfbs file, without going through JSON text.
+// Fields are set through handles looked up once, and every value is checked
+// against the schema: setters return false on a mismatch.
+// Tables are laid out the same way as by generated Create functions, so given
+// the same calls in the same order the bytes are the same as those of
+// generated code (for schemas with original_order tables, the .bfbs must
+// have been generated with --bfbs-builtins).
+// Unlike with FlatBufferBuilder, tables may be started while building another
+// table: fields are collected, and only written out on EndTable().
+class DynamicBuilder {
+ public:
+  // A field of an object, invalid if the lookup failed.
+  struct FieldHandle {
+    FieldHandle() : object(-1), id(0) {}
+    bool IsValid() const { return object >= 0; }
+    int object;  // Index in the schema.
+    voffset_t id;
+  };
+
+  // A finished table, invalid if it couldn't be finished.
+  struct TableRef {
+    TableRef() : offset(0), object(-1) {}
+    bool IsValid() const { return object >= 0; }
+    uoffset_t offset;
+    int object;
+  };
+
+  // A finished vector, invalid if its elements didn't match.
+  struct VectorRef {
+    VectorRef() : offset(0), element(reflection::None), object(-1) {}
+    bool IsValid() const { return element != reflection::None; }
+    uoffset_t offset;
+    reflection::BaseType element;
+    int object;  // For tables and structs, -1 if any (an empty vector).
+  };
+
+  DynamicBuilder(FlatBufferBuilder &fbb, const reflection::Schema &schema);
+
+  // Returns -1 if there's no object of that (fully qualified) name.
+  int LookupObject(const char *name) const;
+  FieldHandle LookupField(int object, const char *name) const;
+
+  void StartTable(int object);
+  // Writes out the table started last. Returns an invalid TableRef (and
+  // writes nothing) if a required field was not set.
+  TableRef EndTable();
+
+  // These all add a field to the table started last. A field may only be
+  // set once, and the value must be of exactly the field's type, except that
+  // bools and union types can be set from uint8_t.
+  template<typename T> bool AddScalar(FieldHandle field, T value) {
+    auto type = ScalarBaseType<T>();
+    auto fielddef = StartField(field);
+    if (!fielddef || !ScalarMatches(fielddef->type()->base_type(), type))
+      return false;
+    Pending pending = { field.id, fielddef->type()->base_type(), 0, 0, 0 };
+    if (type == reflection::Float || type == reflection::Double) {
+      pending.f = static_cast<double>(value);
+    } else {
+      pending.i = static_cast<int64_t>(value);
+    }
+    pending_.push_back(pending);
+    return true;
+  }
+  bool AddString(FieldHandle field, const char *str, size_t len);
+  bool AddString(FieldHandle field, const std::string &str) {
+    return AddString(field, str.c_str(), str.size());
+  }
+  bool AddString(FieldHandle field, Offset<String> str);
+  // "data" is a struct of the field's type, as laid out in a FlatBuffer.
+  bool AddStruct(FieldHandle field, const uint8_t *data);
+  bool AddTable(FieldHandle field, TableRef table);
+  // Also sets the union type field.
+  bool AddUnion(FieldHandle field, TableRef table);
+  bool AddVector(FieldHandle field, VectorRef vec);
+
+  template<typename T> VectorRef CreateVector(const T *v, size_t len) {
+    VectorRef ref;
+    ref.offset = fbb_.CreateVector(v, len).o;
+    ref.element = ScalarBaseType<T>();
+    return ref;
+  }
+  template<typename T> VectorRef CreateVector(const std::vector<T> &v) {
+    return CreateVector(v.data(), v.size());
+  }
+  VectorRef CreateVectorOfStrings(const std::vector<std::string> &v);
+  // "data" holds "len" structs of type "object".
+  VectorRef CreateVectorOfStructs(int object, const uint8_t *data,
+                                  size_t len);
+  // The tables must all be of the same type.
+  VectorRef CreateVectorOfTables(const TableRef *tables, size_t len);
+
+  void Finish(TableRef root, const char *file_identifier = nullptr) {
+    fbb_.Finish(Offset<Table>(root.offset), file_identifier);
+  }
+
+  void operator=(const DynamicBuilder &db);
+
+ private:
+  // A field that was set, to write out on EndTable().
+  struct Pending {
+    voffset_t id;
+    reflection::BaseType type;
+    int64_t i;
+    double f;
+    uoffset_t ref;  // For offsets, or the position in struct_data_.
+  };
+
+  struct Frame {
+    int object;
+    size_t pending_start;
+    size_t struct_data_start;
+  };
+
+  static bool ScalarMatches(reflection::BaseType field_type,
+                            reflection::BaseType type) {
+    return field_type == type ||
+           (type == reflection::UByte &&
+            (field_type == reflection::Bool ||
+             field_type == reflection::UType));
+  }
+
+  // The definition of "field", if it can be set in the current table.
+  const reflection::Field *StartField(FieldHandle field) const;
+  bool AddOffset(FieldHandle field, reflection::BaseType type, uoffset_t ref);
+
+  FlatBufferBuilder &fbb_;
+  const reflection::Schema &schema_;
+  // By object index, then by field id.
+  std::vector<std::vector<const reflection::Field *>> fields_;
+  std::vector<bool> sortbysize_;
+  std::vector<Frame> frames_;
+  std::vector<Pending> pending_;
+  std::vector<uint8_t> struct_data_;
+};
+
+// ------------------------- CANONICAL FORM -------------------------
+
+// Writes the FlatBuffer "buf" into "fbb" in a canonical layout, such that
+// buffers holding the same data come out byte for byte the same, however
+// they were built: fields equal to their default (bitwise, for floats) are
+// left out, as are unions that are not set or of an unknown type along with
+// their type field, objects are written depth first in field id order,
+// nothing is shared (but vtables), and the padding in structs is zeroed.
+// The file identifier, if any, is kept.
+// "fbb" must be empty, and is set to deduplicate vtables.
+// If your FlatBuffer's root table is not the schema's root table, you should
+// pass in your root_table type as well.
+void Canonicalize(const reflection::Schema &schema, const uint8_t *buf,
+                  FlatBufferBuilder *fbb,
+                  const reflection::Object *root_table = nullptr);
+
+// A 128 bit content hash, use "low" if 64 bits are enough.
+struct ContentHash {
+  uint64_t low;
+  uint64_t high;
+
+  bool operator==(const ContentHash &o) const {
+    return low == o.low && high == o.high;
+  }
+  bool operator!=(const ContentHash &o) const { return !(*this == o); }
+};
+
+// Hashes the data in tables, walking them directly: tables that would be the
+// same after Canonicalize have the same hash, on any platform.
+// This is meant for caching and deduplication, it is not a cryptographic
+// hash. Keep an instance around to hash many tables, but don't share it
+// between threads.
+class TableHasher {
+ public:
+  explicit TableHasher(const reflection::Schema &schema)
+    : schema_(schema), a_(0), b_(0) {}
+
+  ContentHash Hash(const reflection::Object &objectdef, const Table &table);
+
+  void operator=(const TableHasher &th);
+
+ private:
+  void AddWord(uint64_t word);
+  void AddBytes(const uint8_t *data, size_t len);
+  void AddTable(const reflection::Object &objectdef, const Table &table);
+  void AddStruct(const reflection::Object &objectdef, const uint8_t *data);
+  void AddElement(const reflection::Field &fielddef, const Table &table,
+                  const VectorOfAny &vec, uoffset_t i);
+
+  const reflection::Schema &schema_;
+  uint64_t a_, b_;
+  // Fields of each object by id, to hash them in a stable order.
+  std::unordered_map<const reflection::Object *,
+                     std::vector<const reflection::Field *>> fields_;
+};
+
+// This is a one-off TableHasher, use one directly when hashing many tables.
+inline ContentHash HashTable(const reflection::Schema &schema,
+                             const reflection::Object &objectdef,
+                             const Table &table) {
+  TableHasher hasher(schema);
+  return hasher.Hash(objectdef, table);
+}
+
+// ------------------------- FLEXBUFFERS -------------------------
+
+}  // namespace flatbuffers
+
+// Declared here so that users of reflection (and idl.h) don't all need
+// flexbuffers.h: include it to use FlexConverter.
+namespace flexbuffers {
+template<typename Allocator> class BuilderT;
+typedef BuilderT<std::allocator<uint8_t>> Builder;
+class Map;
+class Reference;
+}  // namespace flexbuffers
+
+namespace flatbuffers {
+
+// Converts between FlexBuffers and FlatBuffers of the types in a schema, in
+// one pass, without going through JSON text.
+// Tables and structs are maps from field names to values, vectors are
+// vectors, and unions are the map of their table, with the type in the field
+// named "<union>_type" (as in JSON). Scalars are ints, uints or floats:
+// bools are ints (FlexBuffers have none), and enums may also be given by the
+// name of a value.
+// Each object type is planned once, with its fields sorted by name, which is
+// also the order of the keys of a FlexBuffer map, so converting never looks
+// up a field by name.
+// Keep one instance around to convert many values, but don't share it
+// between threads.
+class FlexConverter {
+ public:
+  // If "skip_unknown_fields", keys that aren't fields are ignored rather than
+  // an error.
+  explicit FlexConverter(const reflection::Schema &schema,
+                         bool skip_unknown_fields = false);
+
+  // Builds a table of type "objectdef" from the FlexBuffer map "map".
+  // Returns 0 and sets error() if "map" doesn't fit the schema: a value is of
+  // the wrong type or out of range for its field, a key isn't a field, or a
+  // required field (or a field of a struct) is missing. Clear "fbb" then.
+  // Null values are left out. "map" is read without bounds checks, so use
+  // flexbuffers::VerifyBuffer first on untrusted data.
+  Offset<const Table *> FlexToFlat(const reflection::Object &objectdef,
+                                   flexbuffers::Reference map,
+                                   FlatBufferBuilder &fbb);
+
+  // Adds the fields of "table", of type "objectdef", that are set (and not
+  // deprecated) to "builder", as a map.
+  void FlatToFlex(const reflection::Object &objectdef, const Table &table,
+                  flexbuffers::Builder &builder);
+
+  const std::string &error() const { return error_; }
+
+  void operator=(const FlexConverter &fc);
+
+ private:
+  struct ObjectPlan;
+
+  struct FieldPlan {
+    const reflection::Field *fielddef;
+    const char *name;
+    size_t name_len;
+    voffset_t offset;  // In the vtable, or in a struct.
+    reflection::BaseType base_type;
+    reflection::BaseType element;  // For vectors.
+    size_t size;       // Inline size of the field.
+    size_t align;
+    size_t elem_size;  // For vectors.
+    size_t elem_align;
+    // The range of integer scalars (or elements).
+    int64_t min;
+    uint64_t max;
+    const reflection::Enum *enumdef;  // For enums, union types and unions.
+    const ObjectPlan *object;  // For tables, structs and vectors of them.
+    std::string type_key;      // For unions, the name of their type field.
+  };
+
+  struct ObjectPlan {
+    const reflection::Object *objectdef;
+    std::vector<FieldPlan> fields;  // In name order.
+    voffset_t numfields;
+  };
+
+  // A field to add to the table being built.
+  struct Pending {
+    const FieldPlan *field;
+    int64_t i;
+    double f;
+    uoffset_t ref;  // For offsets, or the position in struct_data_.
+  };
+
+  const ObjectPlan *GetPlan(const reflection::Object &objectdef);
+  bool Error(const ObjectPlan &plan, const FieldPlan *field,
+             const std::string &msg);
+  // These return 0 (or false) on error.
+  uoffset_t ToTable(const ObjectPlan &plan, flexbuffers::Reference map);
+  bool ToField(const ObjectPlan &plan, const FieldPlan &field,
+               flexbuffers::Reference value, const flexbuffers::Map &map);
+  bool ToStruct(const ObjectPlan &plan, flexbuffers::Reference map,
+                uint8_t *data);
+  bool ToScalar(const ObjectPlan &plan, const FieldPlan &field,
+                reflection::BaseType type, flexbuffers::Reference value,
+                int64_t *i, double *f);
+  uoffset_t ToVector(const ObjectPlan &plan, const FieldPlan &field,
+                     flexbuffers::Reference value,
+                     const flexbuffers::Map &map);
+  uoffset_t ToUnion(const ObjectPlan &plan, const FieldPlan &field,
+                    flexbuffers::Reference type, flexbuffers::Reference value);
+  void FromTable(const ObjectPlan &plan, const Table &table);
+  void FromStruct(const ObjectPlan &plan, const uint8_t *data);
+  void FromScalar(reflection::BaseType type, const uint8_t *data);
+  void FromVector(const FieldPlan &field, const Table &table,
+                  const VectorOfAny &vec);
+
+  const reflection::Schema &schema_;
+  bool skip_unknown_fields_;
+  std::unordered_map<const reflection::Object *, ObjectPlan> plans_;
+  FlatBufferBuilder *fbb_;
+  flexbuffers::Builder *builder_;
+  std::string error_;
+  int depth_;
+  std::vector<Pending> pending_;
+  std::vector<uint8_t> struct_data_;
+  std::vector<Offset<void>> offsets_;
+  std::vector<uint8_t> scratch_;  // Elements of vectors of scalars.
+};
+
+// These are one-off FlexConverters, use one directly to convert many values.
+Offset<const Table *> FlexToFlat(const reflection::Schema &schema,
+                                 const reflection::Object &objectdef,
+                                 flexbuffers::Reference map,
+                                 FlatBufferBuilder &fbb,
+                                 std::string *error = nullptr);
+void FlatToFlex(const reflection::Schema &schema,
+                const reflection::Object &objectdef, const Table &table,
+                flexbuffers::Builder &builder);
+
 // Verifies the provided flatbuffer using reflection.
 // root should point to the root type for this flatbuffer.
 // buf should point to the start of flatbuffer data.
@@ -15,3 +15,4 @@
 # limitations under the License.
 
 ../flatc -c --no-prefix -o ../include/flatbuffers reflection.fbs
+../flatc -c -o ../include/flatbuffers patch.fbs
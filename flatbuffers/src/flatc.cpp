@@ -15,6 +15,7 @@
  */
 
 #include "flatbuffers/flatc.h"
+#include "flatbuffers/flexbuffers.h"
 
 #define FLATC_VERSION "1.6.0 (" __DATE__ ")"
 
@@ -86,14 +87,22 @@ std::string FlatCompiler::GetUsageString(const char* program_name) const {
       "  --escape-proto-ids Disable appending '_' in namespaces names.\n"
       "  --gen-object-api   Generate an additional object-based API.\n"
       "  --cpp-ptr-type T   Set object API pointer type (default std::unique_ptr)\n"
+      "  --gen-json-functions Generate JSON functions that need no schema (C++).\n"
       "  --no-js-exports    Removes Node.js style export lines in JS.\n"
       "  --goog-js-export   Uses goog.exports* for closure compiler exporting in JS.\n"
+      "  --jsonl            JSON files hold a sequence of root objects (one per\n"
+      "                     line or concatenated), written with -b as a sequence\n"
+      "                     of size prefixed binaries.\n"
+      "  --flexjson         With -b, convert JSON files to FlexBuffers, and\n"
+      "                     with -t, FlexBuffer files (after --) to JSON.\n"
+      "                     Needs no schema.\n"
       "  --raw-binary       Allow binaries without file_indentifier to be read.\n"
       "                     This may crash flatc given a mismatched schema.\n"
       "  --proto            Input is a .proto, translate to .fbs.\n"
       "  --grpc             Generate GRPC interfaces for the specified languages\n"
       "  --schema           Serialize schemas instead of JSON (use with -b)\n"
       "  --bfbs-comments    Add doc comments to the binary schema files.\n"
+      "  --bfbs-builtins    Add builtin attributes to the binary schema files.\n"
       "  --conform FILE     Specify a schema the following schemas should be\n"
       "                     an evolution of. Gives errors if not.\n"
       "  --conform-includes Include path for the schema given with --conform\n"
@@ -119,6 +128,8 @@ int FlatCompiler::Compile(int argc, const char** argv) {
   bool any_generator = false;
   bool print_make_rules = false;
   bool raw_binary = false;
+  bool json_stream = false;
+  bool flex_json = false;
   bool schema_binary = false;
   bool grpc_enabled = false;
   std::vector<std::string> filenames;
@@ -175,6 +186,8 @@ int FlatCompiler::Compile(int argc, const char** argv) {
         opts.generate_name_strings = true;
       } else if(arg == "--gen-object-api") {
         opts.generate_object_based_api = true;
+      } else if(arg == "--gen-json-functions") {
+        opts.generate_json_functions = true;
       } else if (arg == "--cpp-ptr-type") {
         if (++argi >= argc) Error("missing type following" + arg, true);
         opts.cpp_object_api_pointer_type = argv[argi];
@@ -188,6 +201,10 @@ int FlatCompiler::Compile(int argc, const char** argv) {
         opts.include_dependence_headers = false;
       } else if (arg == "--gen-onefile") {
         opts.one_file = true;
+      } else if (arg == "--jsonl") {
+        json_stream = true;
+      } else if (arg == "--flexjson") {
+        flex_json = true;
       } else if (arg == "--raw-binary") {
         raw_binary = true;
       } else if(arg == "--") {  // Separator between text and binary inputs.
@@ -207,6 +224,8 @@ int FlatCompiler::Compile(int argc, const char** argv) {
         grpc_enabled = true;
       } else if(arg == "--bfbs-comments") {
         opts.binary_schema_comments = true;
+      } else if(arg == "--bfbs-builtins") {
+        opts.binary_schema_builtins = true;
       } else {
         for (size_t i = 0; i < params_.num_generators; ++i) {
           if (arg == params_.generators[i].generator_opt_long ||
@@ -235,6 +254,11 @@ int FlatCompiler::Compile(int argc, const char** argv) {
     Error("no options: specify at least one generator.", true);
   }
 
+  if (json_stream && (opts.lang_to_generate & IDLOptions::kJson))
+    Error("--jsonl cannot be combined with --json", true);
+  if (json_stream && flex_json)
+    Error("--jsonl cannot be combined with --flexjson", true);
+
   flatbuffers::Parser conform_parser;
   if (!conform_to_schema.empty()) {
     std::string contents;
@@ -245,6 +269,11 @@ int FlatCompiler::Compile(int argc, const char** argv) {
   }
 
   std::unique_ptr<flatbuffers::Parser> parser(new flatbuffers::Parser(opts));
+  // With --flexjson, JSON files are parsed into flex_builder, and flex_buf is
+  // the FlexBuffer to output as text, of flex_size bytes.
+  flexbuffers::Builder flex_builder;
+  const uint8_t *flex_buf = nullptr;
+  size_t flex_size = 0;
 
   for (auto file_it = filenames.begin();
             file_it != filenames.end();
@@ -255,7 +284,24 @@ int FlatCompiler::Compile(int argc, const char** argv) {
 
       bool is_binary = static_cast<size_t>(file_it - filenames.begin()) >=
                        binary_files_from;
-      if (is_binary) {
+      if (flex_json) {
+        flex_builder.Clear();
+        if (is_binary) {
+          flex_buf = reinterpret_cast<const uint8_t *>(contents.c_str());
+          flex_size = contents.length();
+          if (!flexbuffers::VerifyBuffer(flex_buf, flex_size))
+            Error("not a valid FlexBuffer: " + *file_it, false, false);
+        } else {
+          if (flatbuffers::GetExtension(*file_it) == "fbs")
+            Error("--flexjson needs no schema: " + *file_it, true);
+          std::string err;
+          if (!flexbuffers::FromJson(contents.c_str(), contents.length(),
+                                     &flex_builder, &err))
+            Error(*file_it + ": " + err, false, false);
+          flex_buf = flex_builder.GetBuffer().data();
+          flex_size = flex_builder.GetSize();
+        }
+      } else if (is_binary) {
         parser->builder_.Clear();
         parser->builder_.PushFlatBuffer(
           reinterpret_cast<const uint8_t *>(contents.c_str()),
@@ -292,7 +338,20 @@ int FlatCompiler::Compile(int argc, const char** argv) {
           // so explicitly using an include.
           parser.reset(new flatbuffers::Parser(opts));
         }
-        ParseFile(*parser.get(), *file_it, contents, include_directories);
+        if (json_stream && !is_schema) {
+          std::string stream;
+          if (!parser->ParseJsonStream(contents.c_str(),
+                                       [&](const uint8_t *buf, size_t size) {
+                stream.append(reinterpret_cast<const char *>(buf), size);
+              }, file_it->c_str()))
+            Error(parser->error_, false, false);
+          parser->builder_.Clear();
+          parser->builder_.PushFlatBuffer(
+            reinterpret_cast<const uint8_t *>(stream.c_str()),
+            stream.length());
+        } else {
+          ParseFile(*parser.get(), *file_it, contents, include_directories);
+        }
         if (is_schema && !conform_to_schema.empty()) {
           auto err = parser->ConformTo(conform_parser);
           if (!err.empty()) Error("schemas don\'t conform: " + err);
@@ -311,7 +370,22 @@ int FlatCompiler::Compile(int argc, const char** argv) {
         if (generator_enabled[i]) {
           if (!print_make_rules) {
             flatbuffers::EnsureDirExists(output_path);
-            if (!params_.generators[i].generate(*parser.get(), output_path, filebase)) {
+            auto lang = params_.generators[i].lang;
+            bool ok;
+            if (flex_json && lang == IDLOptions::kBinary) {
+              // Only JSON files are converted to binary.
+              ok = flatbuffers::GenerateBinary(*parser.get(), flex_buf,
+                                               flex_builder.GetSize(),
+                                               output_path, filebase);
+            } else if (flex_json && lang == IDLOptions::kJson) {
+              ok = flatbuffers::GenerateTextFile(*parser.get(), flex_buf,
+                                                 flex_size, output_path,
+                                                 filebase);
+            } else {
+              ok = params_.generators[i].generate(*parser.get(), output_path,
+                                                  filebase);
+            }
+            if (!ok) {
               Error(std::string("Unable to generate ") +
                     params_.generators[i].lang_name +
                     " for " +
@@ -92,6 +92,9 @@ class CppGenerator : public BaseGenerator {
     code_ += "";
 
     code_ += "#include \"flatbuffers/flatbuffers.h\"";
+    if (parser_.opts.generate_json_functions) {
+      code_ += "#include \"flatbuffers/json.h\"";
+    }
     code_ += "";
 
     if (parser_.opts.include_dependence_headers) {
@@ -161,6 +164,53 @@ class CppGenerator : public BaseGenerator {
       }
     }
 
+    // Generate JSON functions, after all types are complete.
+    if (parser_.opts.generate_json_functions) {
+      for (auto it = parser_.enums_.vec.begin();
+           it != parser_.enums_.vec.end(); ++it) {
+        const auto &enum_def = **it;
+        if (!enum_def.generated) {
+          SetNameSpace(enum_def.defined_namespace);
+          GenEnumJsonPrinter(enum_def);
+          GenEnumJsonParser(enum_def);
+        }
+      }
+      for (auto it = parser_.structs_.vec.begin();
+           it != parser_.structs_.vec.end(); ++it) {
+        const auto &struct_def = **it;
+        if (!struct_def.generated) {
+          SetNameSpace(struct_def.defined_namespace);
+          GenJsonPrinter(struct_def);
+        }
+      }
+      // The parsers call each other, so declare them all first.
+      for (auto it = parser_.structs_.vec.begin();
+           it != parser_.structs_.vec.end(); ++it) {
+        const auto &struct_def = **it;
+        if (!struct_def.generated) {
+          SetNameSpace(struct_def.defined_namespace);
+          code_ += GenJsonParserSignature(struct_def) + ";";
+          code_ += "";
+        }
+      }
+      for (auto it = parser_.enums_.vec.begin();
+           it != parser_.enums_.vec.end(); ++it) {
+        const auto &enum_def = **it;
+        if (!enum_def.generated && enum_def.is_union) {
+          SetNameSpace(enum_def.defined_namespace);
+          GenUnionJsonParser(enum_def);
+        }
+      }
+      for (auto it = parser_.structs_.vec.begin();
+           it != parser_.structs_.vec.end(); ++it) {
+        const auto &struct_def = **it;
+        if (!struct_def.generated) {
+          SetNameSpace(struct_def.defined_namespace);
+          GenJsonParser(struct_def);
+        }
+      }
+    }
+
     // Generate convenient global helper functions:
     if (parser_.root_struct_def_) {
       auto &struct_def = *parser_.root_struct_def_;
@@ -577,8 +627,8 @@ class CppGenerator : public BaseGenerator {
 
     // Generate a generate string table for enum values.
     // Problem is, if values are very sparse that could generate really big
-    // tables. Ideally in that case we generate a map lookup instead, but for
-    // the moment we simply don't output a table at all.
+    // tables. In that case we generate a switch instead, which the compiler
+    // turns into a binary search or jump table.
     auto range =
         enum_def.vals.vec.back()->value - enum_def.vals.vec.front()->value + 1;
     // Average distance between values above which we consider a table
@@ -617,6 +667,22 @@ class CppGenerator : public BaseGenerator {
       code_ += "  return EnumNames{{ENUM_NAME}}()[index];";
       code_ += "}";
       code_ += "";
+    } else {
+      code_ += "inline const char *EnumName{{ENUM_NAME}}({{ENUM_NAME}} e) {";
+      code_ += "  switch (e) {";
+      std::set<int64_t> seen;
+      for (auto it = enum_def.vals.vec.begin(); it != enum_def.vals.vec.end();
+           ++it) {
+        const auto &ev = **it;
+        // Aliases would be duplicate case labels.
+        if (!seen.insert(ev.value).second) continue;
+        code_ += "    case " + GetEnumValUse(enum_def, ev) + ": return \"" +
+                 ev.name + "\";";
+      }
+      code_ += "    default: return \"\";";
+      code_ += "  }";
+      code_ += "}";
+      code_ += "";
     }
 
     // Generate type traits for unions to map from a type to union enum value.
@@ -701,6 +767,469 @@ class CppGenerator : public BaseGenerator {
     }
   }
 
+  // Generate a function printing an enum value as its identifier, or as a
+  // number if it has none.
+  void GenEnumJsonPrinter(const EnumDef &enum_def) {
+    code_.SetValue("ENUM_NAME", enum_def.name);
+    code_.SetValue("BASE_TYPE", GenTypeBasic(enum_def.underlying_type, false));
+    code_ += "template<typename Sink>";
+    code_ += "void PrintJson({{ENUM_NAME}} e, "
+             "flatbuffers::JsonPrinter<Sink> &p) {";
+    code_ += "  switch (e) {";
+    std::set<int64_t> seen;
+    // Like GenerateText(), print a union NONE type as a number.
+    for (auto it = enum_def.vals.vec.begin() + (enum_def.is_union ? 1 : 0);
+         it != enum_def.vals.vec.end(); ++it) {
+      const auto &ev = **it;
+      // Aliases would be duplicate case labels.
+      if (!seen.insert(ev.value).second) continue;
+      code_ += "    case " + GetEnumValUse(enum_def, ev) +
+               ": p.Identifier(\"" + ev.name + "\"); break;";
+    }
+    code_ += "    default: p.Number(static_cast<{{BASE_TYPE}}>(e));";
+    code_ += "  }";
+    code_ += "}";
+    code_ += "";
+  }
+
+  // Returns the statement printing the scalar value expression val, which
+  // is cast to the enum type if it is the raw element of a vector.
+  std::string GenJsonScalar(const Type &type, const std::string &val,
+                            bool raw) {
+    if (type.enum_def) {
+      return "PrintJson(" +
+             (raw ? "static_cast<" + WrapInNameSpace(*type.enum_def) + ">(" +
+                    val + ")"
+                  : val) +
+             ", p);";
+    } else if (type.base_type == BASE_TYPE_BOOL) {
+      return raw ? "p.Bool(" + val + " != 0);" : "p.Bool(" + val + ");";
+    } else {
+      return "p.Number(" + val + ");";
+    }
+  }
+
+  // Returns the statement(s) printing the non-scalar value expression val,
+  // which is a pointer (or a reference for structs inside structs). Lines
+  // after the first are indented by indent.
+  std::string GenJsonPointer(const Type &type, const std::string &val,
+                             bool is_ref, const std::string &indent) {
+    const auto deref = is_ref ? val : "*" + val;
+    switch (type.base_type) {
+      case BASE_TYPE_STRING: return "p.String(" + deref + ");";
+      case BASE_TYPE_STRUCT: return "PrintJson(" + deref + ", p);";
+      case BASE_TYPE_VECTOR: {
+        const auto elem = type.VectorType();
+        const auto get = val + "->Get(i)";
+        return "p.StartArray();\n" +
+               indent + "for (flatbuffers::uoffset_t i = 0; i < " + val +
+               "->size(); i++) {\n" +
+               indent + "  p.Element(i);\n" +
+               indent + "  " +
+               (IsScalar(elem.base_type)
+                  ? GenJsonScalar(elem, get, true)
+                  : GenJsonPointer(elem, get, false, indent + "  ")) + "\n" +
+               indent + "}\n" +
+               indent + "p.EndArray();";
+      }
+      default: assert(0); return "";
+    }
+  }
+
+  static bool IsVectorOfUnion(const Type &type) {
+    return type.base_type == BASE_TYPE_VECTOR &&
+           type.element == BASE_TYPE_UNION;
+  }
+
+  // Generate a function printing a table or struct as JSON, with the same
+  // output as GenerateText().
+  void GenJsonPrinter(const StructDef &struct_def) {
+    code_.SetValue("STRUCT_NAME", struct_def.name);
+    // Fields that can't be printed: deprecated ones have no accessor, and
+    // GenerateText() doesn't handle vectors of unions either.
+    std::vector<const FieldDef *> fields;
+    bool has_scalars = false;
+    for (auto it = struct_def.fields.vec.begin();
+         it != struct_def.fields.vec.end(); ++it) {
+      const auto &field = **it;
+      if (field.deprecated || IsVectorOfUnion(field.value.type)) continue;
+      fields.push_back(&field);
+      has_scalars = has_scalars || IsScalar(field.value.type.base_type);
+    }
+
+    code_.SetValue("PARAM", fields.empty() ? "/*o*/" : "o");
+    code_ += "template<typename Sink>";
+    code_ += "void PrintJson(const {{STRUCT_NAME}} &{{PARAM}}, "
+             "flatbuffers::JsonPrinter<Sink> &p) {";
+    if (!struct_def.fixed && has_scalars) {
+      // Presence of scalars can't be observed through the accessors.
+      code_ += "  auto t = reinterpret_cast<const flatbuffers::Table *>(&o);";
+    }
+    if (!struct_def.fixed && !fields.empty()) code_ += "  int n = 0;";
+    code_ += "  p.StartObject();";
+    int index = 0;
+    for (auto it = fields.begin(); it != fields.end(); ++it, ++index) {
+      const auto &field = **it;
+      const auto &type = field.value.type;
+      code_.SetValue("FIELD_NAME", field.name);
+      code_.SetValue("KEY_INDEX", struct_def.fixed ? NumToString(index)
+                                                   : "n++");
+      code_.SetValue("OFFSET_NAME", GenFieldOffsetName(field));
+      if (struct_def.fixed) {
+        // All fields of a struct are always present.
+        const auto val = "o." + field.name + "()";
+        code_.SetValue("PRINT", IsScalar(type.base_type)
+                                  ? GenJsonScalar(type, val, false)
+                                  : GenJsonPointer(type, val, true, "  "));
+        code_ += "  p.Key({{KEY_INDEX}}, \"{{FIELD_NAME}}\"); {{PRINT}}";
+      } else if (IsScalar(type.base_type)) {
+        code_.SetValue("PRINT",
+                       GenJsonScalar(type, "o." + field.name + "()", false));
+        code_ += "  if (t->CheckField({{STRUCT_NAME}}::{{OFFSET_NAME}})) {";
+        code_ += "    p.Key({{KEY_INDEX}}, \"{{FIELD_NAME}}\");";
+        code_ += "    {{PRINT}}";
+        code_ += "  }";
+      } else if (type.base_type == BASE_TYPE_UNION) {
+        code_ += "  switch (o.{{FIELD_NAME}}_type()) {";
+        const auto &enum_def = *type.enum_def;
+        for (auto uit = enum_def.vals.vec.begin() + 1;
+             uit != enum_def.vals.vec.end(); ++uit) {
+          const auto &ev = **uit;
+          code_.SetValue("U_ELEMENT_TYPE", GetEnumValUse(enum_def, ev));
+          code_.SetValue("U_TYPE", WrapInNameSpace(*ev.struct_def));
+          code_ += "    case {{U_ELEMENT_TYPE}}:";
+          code_ += "      if (auto v = o.{{FIELD_NAME}}()) {";
+          code_ += "        p.Key({{KEY_INDEX}}, \"{{FIELD_NAME}}\");";
+          code_ += "        PrintJson(*static_cast<const {{U_TYPE}} *>(v), p);";
+          code_ += "      }";
+          code_ += "      break;";
+        }
+        code_ += "    default: break;";
+        code_ += "  }";
+      } else {
+        code_.SetValue("PRINT", GenJsonPointer(type, "v", false, "    "));
+        code_ += "  if (auto v = o.{{FIELD_NAME}}()) {";
+        code_ += "    p.Key({{KEY_INDEX}}, \"{{FIELD_NAME}}\");";
+        code_ += "    {{PRINT}}";
+        code_ += "  }";
+      }
+    }
+    code_ += "  p.EndObject();";
+    code_ += "}";
+    code_ += "";
+
+    if (!struct_def.fixed) {
+      code_ += "template<typename Sink>";
+      code_ += "bool ToJson(const {{STRUCT_NAME}} &o, Sink &sink,";
+      code_ += "            const flatbuffers::JsonOptions &opts = "
+               "flatbuffers::JsonOptions()) {";
+      code_ += "  flatbuffers::JsonPrinter<Sink> p(sink, opts);";
+      code_ += "  PrintJson(o, p);";
+      code_ += "  return p.Finish();";
+      code_ += "}";
+      code_ += "";
+    }
+  }
+
+  // Generate a function parsing an enum value from a number or identifiers.
+  void GenEnumJsonParser(const EnumDef &enum_def) {
+    code_.SetValue("ENUM_NAME", enum_def.name);
+    code_.SetValue("BASE_TYPE", GenTypeBasic(enum_def.underlying_type, false));
+    code_ += "inline bool ParseJson({{ENUM_NAME}} *e, "
+             "flatbuffers::JsonReader &r) {";
+    code_ += "  {{BASE_TYPE}} v;";
+    code_ += "  if (!r.Enum(&v, [](const char *name, size_t len, "
+             "int64_t *value) {";
+    std::vector<const std::string *> names;
+    std::map<const std::string *, std::string> values;
+    for (auto it = enum_def.vals.vec.begin(); it != enum_def.vals.vec.end();
+         ++it) {
+      names.push_back(&(*it)->name);
+      values[&(*it)->name] = "*value = static_cast<int64_t>(" +
+                             GetEnumValUse(enum_def, **it) +
+                             "); return true;";
+    }
+    GenJsonNameSwitch(names, values, "        ");
+    code_ += "        return false;";
+    code_ += "      })) {";
+    code_ += "    return false;";
+    code_ += "  }";
+    code_ += "  *e = static_cast<{{ENUM_NAME}}>(v);";
+    code_ += "  return true;";
+    code_ += "}";
+    code_ += "";
+  }
+
+  // Generate a switch on the length of a name, followed by comparisons with
+  // the names of that length, executing the corresponding statements.
+  void GenJsonNameSwitch(const std::vector<const std::string *> &names,
+                         const std::map<const std::string *,
+                                        std::string> &statements,
+                         const std::string &indent) {
+    if (names.empty()) return;
+    std::map<size_t, std::vector<const std::string *>> by_length;
+    for (auto it = names.begin(); it != names.end(); ++it) {
+      by_length[(*it)->length()].push_back(*it);
+    }
+    code_ += indent + "switch (len) {";
+    for (auto it = by_length.begin(); it != by_length.end(); ++it) {
+      code_ += indent + "  case " + NumToString(it->first) + ":";
+      for (auto nit = it->second.begin(); nit != it->second.end(); ++nit) {
+        code_ += indent + "    if (!memcmp(name, \"" + **nit + "\", " +
+                 NumToString(it->first) + ")) {";
+        std::stringstream ss(statements.find(*nit)->second);
+        std::string line;
+        while (std::getline(ss, line)) code_ += indent + "      " + line;
+        code_ += indent + "    }";
+      }
+      code_ += indent + "    break;";
+    }
+    code_ += indent + "}";
+  }
+
+  std::string GenJsonParserSignature(const StructDef &struct_def) {
+    if (struct_def.fixed) {
+      return "inline bool ParseJson(" + struct_def.name + " *out, "
+             "flatbuffers::JsonReader &r)";
+    } else {
+      return "inline bool ParseJson(flatbuffers::Offset<" + struct_def.name +
+             "> *out,\n"
+             "                      flatbuffers::FlatBufferBuilder &fbb,\n"
+             "                      flatbuffers::JsonReader &r)";
+    }
+  }
+
+  // Generate a function parsing a union value, given its type.
+  void GenUnionJsonParser(const EnumDef &enum_def) {
+    code_.SetValue("ENUM_NAME", enum_def.name);
+    code_ += "inline bool ParseJson({{ENUM_NAME}} type, "
+             "flatbuffers::Offset<void> *out,";
+    code_ += "                      flatbuffers::FlatBufferBuilder &fbb, "
+             "flatbuffers::JsonReader &r) {";
+    code_ += "  switch (type) {";
+    for (auto it = enum_def.vals.vec.begin() + 1;
+         it != enum_def.vals.vec.end(); ++it) {
+      const auto &ev = **it;
+      code_.SetValue("U_ELEMENT_TYPE", GetEnumValUse(enum_def, ev));
+      code_.SetValue("U_TYPE", WrapInNameSpace(*ev.struct_def));
+      code_ += "    case {{U_ELEMENT_TYPE}}: {";
+      code_ += "      flatbuffers::Offset<{{U_TYPE}}> o;";
+      code_ += "      if (!ParseJson(&o, fbb, r)) return false;";
+      code_ += "      *out = o.Union();";
+      code_ += "      return true;";
+      code_ += "    }";
+    }
+    code_ += "    default: return r.Error(\"illegal type id for union: "
+             "{{ENUM_NAME}}\");";
+    code_ += "  }";
+    code_ += "}";
+    code_ += "";
+  }
+
+  // Returns the type of the local variable a field is parsed into.
+  std::string GenJsonLocalType(const Type &type) {
+    if (IsScalar(type.base_type)) return GenTypeBasic(type, true);
+    switch (type.base_type) {
+      case BASE_TYPE_STRUCT:
+        if (IsStruct(type)) return WrapInNameSpace(*type.struct_def);
+        // fall through
+      case BASE_TYPE_STRING:
+      case BASE_TYPE_VECTOR:
+        return "flatbuffers::Offset<" + GenTypePointer(type) + ">";
+      default:
+        return "flatbuffers::Offset<void>";
+    }
+  }
+
+  // Returns the statements parsing a single value into the variable val.
+  std::string GenJsonParseValue(const FieldDef *field, const Type &type,
+                                const std::string &val) {
+    auto hash = field ? field->attributes.Lookup("hash") : nullptr;
+    if (hash) {
+      // Strings are hashed, like Parser does.
+      const auto bits = SizeOf(type.base_type) * 8;
+      const auto hash_type = bits == 64 ? "uint64_t" : "uint32_t";
+      const auto fn = hash->constant.find("fnv1a") == 0 ? "HashFnv1a"
+                                                         : "HashFnv1";
+      return std::string("if (r.Peek() == '\"') {\n") +
+             "  const std::string *s;\n"
+             "  if (!r.String(&s)) return false;\n"
+             "  " + val + " = static_cast<" + GenTypeBasic(type, false) +
+             ">(flatbuffers::" + fn + "<" + hash_type + ">(s->c_str()));\n"
+             "} else if (!r.Number(&" + val + ")) {\n"
+             "  return false;\n"
+             "}";
+    }
+    if (type.enum_def && IsScalar(type.base_type)) {
+      return "if (!ParseJson(&" + val + ", r)) return false;";
+    }
+    if (IsScalar(type.base_type)) {
+      return "if (!r.Number(&" + val + ")) return false;";
+    }
+    switch (type.base_type) {
+      case BASE_TYPE_STRING:
+        return "const std::string *s;\n"
+               "if (!r.String(&s)) return false;\n" +
+               val + " = fbb.CreateString(*s);";
+      case BASE_TYPE_STRUCT:
+        return IsStruct(type)
+                 ? "if (!ParseJson(&" + val + ", r)) return false;"
+                 : "if (!ParseJson(&" + val + ", fbb, r)) return false;";
+      case BASE_TYPE_VECTOR: {
+        const auto elem_type = type.VectorType();
+        auto elem_local = GenJsonLocalType(elem_type);
+        auto vec_type = IsScalar(elem_type.base_type)
+                          ? GenTypeBasic(elem_type, false)
+                          : elem_local;
+        auto parse_elem = GenJsonParseValue(nullptr, elem_type, "e");
+        std::string code = "if (!r.Expect('[')) return false;\n"
+                           "std::vector<" + vec_type + "> v;\n"
+                           "for (flatbuffers::uoffset_t i = 0; "
+                           "r.NextElement(i); i++) {\n"
+                           "  " + elem_local + " e;\n";
+        std::stringstream ss(parse_elem);
+        std::string line;
+        while (std::getline(ss, line)) code += "  " + line + "\n";
+        code += "  v.push_back(" +
+                (vec_type == elem_local ? std::string("e")
+                                        : "static_cast<" + vec_type + ">(e)") +
+                ");\n"
+                "}\n"
+                "if (!r.ok()) return false;\n" + val + " = " +
+                (IsStruct(elem_type) ? "fbb.CreateVectorOfStructs(v);"
+                                     : "fbb.CreateVector(v);");
+        return code;
+      }
+      default: assert(0); return "";
+    }
+  }
+
+  // Generate a function parsing a table or struct from JSON. Fields are
+  // parsed into local variables first, since a table can only be started
+  // once all its children have been serialized.
+  void GenJsonParser(const StructDef &struct_def) {
+    code_.SetValue("STRUCT_NAME", struct_def.name);
+    code_ += GenJsonParserSignature(struct_def) + " {";
+    std::vector<const std::string *> names;
+    std::map<const std::string *, std::string> statements;
+    for (auto it = struct_def.fields.vec.begin();
+         it != struct_def.fields.vec.end(); ++it) {
+      const auto &field = **it;
+      const auto &type = field.value.type;
+      names.push_back(&field.name);
+      if (field.deprecated) {
+        // Deprecated fields have no accessors, so drop their values.
+        statements[&field.name] = "if (!r.SkipValue()) return false;\n"
+                                  "continue;";
+        continue;
+      }
+      if (IsVectorOfUnion(type)) {
+        // Not supported, the printer leaves these out too.
+        statements[&field.name] = "return r.Error(\"vectors of unions are "
+                                  "not supported: " + field.name + "\");";
+        continue;
+      }
+      code_.SetValue("FIELD_NAME", field.name);
+      code_.SetValue("LOCAL_TYPE", GenJsonLocalType(type));
+      code_ += "  {{LOCAL_TYPE}} _{{FIELD_NAME}}" +
+               std::string(IsScalar(type.base_type)
+                             ? " = static_cast<{{LOCAL_TYPE}}>(0)" : "") +
+               ";";
+      code_ += "  bool _{{FIELD_NAME}}_set = false;";
+      // Null values leave the field unset, as in Parser.
+      auto once = "if (r.Null()) continue;\n"
+                  "if (!r.Once(&_" + field.name + "_set, \"" + field.name +
+                  "\")) return false;\n";
+      if (type.base_type == BASE_TYPE_UNION) {
+        // The value can only be parsed once its type is known.
+        code_ += "  const char *_{{FIELD_NAME}}_pos = nullptr;";
+        statements[&field.name] = once +
+            "if (!_" + field.name + "_type_set) {\n"
+            "  _" + field.name + "_pos = r.Position();\n"
+            "  if (!r.SkipValue()) return false;\n"
+            "} else if (!ParseJson(_" + field.name + "_type, &_" + field.name +
+            ", fbb, r)) {\n"
+            "  return false;\n"
+            "}\n"
+            "continue;";
+      } else {
+        statements[&field.name] = once +
+                                  GenJsonParseValue(&field, type,
+                                                    "_" + field.name) +
+                                  "\ncontinue;";
+      }
+    }
+    code_ += "  if (!r.Expect('{')) return false;";
+    code_ += "  int n = 0;";
+    code_ += "  const char *name;";
+    code_ += "  size_t len;";
+    code_ += "  while (r.NextField(&n, &name, &len)) {";
+    GenJsonNameSwitch(names, statements, "    ");
+    code_ += "    return r.Error(\"unknown field: \" + "
+             "std::string(name, len));";
+    code_ += "  }";
+    code_ += "  if (!r.ok()) return false;";
+    for (auto it = struct_def.fields.vec.begin();
+         it != struct_def.fields.vec.end(); ++it) {
+      const auto &field = **it;
+      code_.SetValue("FIELD_NAME", field.name);
+      if (field.value.type.base_type == BASE_TYPE_UNION) {
+        code_ += "  if (_{{FIELD_NAME}}_pos) {";
+        code_ += "    auto end = r.Position();";
+        code_ += "    r.Rewind(_{{FIELD_NAME}}_pos);";
+        code_ += "    if (!_{{FIELD_NAME}}_type_set) {";
+        code_ += "      return r.Error(\"missing type field for this union "
+                 "value: {{FIELD_NAME}}\");";
+        code_ += "    }";
+        code_ += "    if (!ParseJson(_{{FIELD_NAME}}_type, &_{{FIELD_NAME}}, "
+                 "fbb, r)) return false;";
+        code_ += "    r.Rewind(end);";
+        code_ += "  }";
+      }
+      if ((field.required || struct_def.fixed) && !field.deprecated &&
+          !IsVectorOfUnion(field.value.type)) {
+        code_ += "  if (!_{{FIELD_NAME}}_set) {";
+        code_ += "    return r.Error(\"" +
+                 std::string(struct_def.fixed
+                   ? "struct: wrong number of initializers: {{STRUCT_NAME}}"
+                   : "required field is missing: {{FIELD_NAME}} in "
+                     "{{STRUCT_NAME}}") + "\");";
+        code_ += "  }";
+      }
+    }
+    if (struct_def.fixed) {
+      std::string args;
+      for (auto it = struct_def.fields.vec.begin();
+           it != struct_def.fields.vec.end(); ++it) {
+        if (!args.empty()) args += ", ";
+        args += "_" + (*it)->name;
+      }
+      code_ += "  *out = {{STRUCT_NAME}}(" + args + ");";
+    } else {
+      // Same order as Create{{STRUCT_NAME}}(), and Parser.
+      code_ += "  {{STRUCT_NAME}}Builder b(fbb);";
+      for (size_t size = struct_def.sortbysize ? sizeof(largest_scalar_t) : 1;
+           size; size /= 2) {
+        for (auto it = struct_def.fields.vec.rbegin();
+             it != struct_def.fields.vec.rend(); ++it) {
+          const auto &field = **it;
+          if (!field.deprecated && !IsVectorOfUnion(field.value.type) &&
+              (!struct_def.sortbysize ||
+              size == SizeOf(field.value.type.base_type))) {
+            code_.SetValue("FIELD_NAME", field.name);
+            code_.SetValue("ADDR", IsStruct(field.value.type) ? "&" : "");
+            code_ += "  if (_{{FIELD_NAME}}_set) "
+                     "b.add_{{FIELD_NAME}}({{ADDR}}_{{FIELD_NAME}});";
+          }
+        }
+      }
+      code_ += "  *out = b.Finish();";
+    }
+    code_ += "  return true;";
+    code_ += "}";
+    code_ += "";
+  }
+
   void GenUnionPost(const EnumDef &enum_def) {
     // Generate a verifier function for this union that can be called by the
     // table verifier functions. It uses a switch case to select a specific
@@ -301,7 +301,7 @@ Type DestinationType(const Type &type, bool vectorelem) {
     case BASE_TYPE_VECTOR:
       if (vectorelem)
         return DestinationType(type.VectorType(), vectorelem);
-      // else fall thru:
+      // else fall through
     default: return type;
   }
 }
@@ -348,7 +348,7 @@ std::string DestinationMask(const Type &type, bool vectorelem) {
     case BASE_TYPE_VECTOR:
       if (vectorelem)
         return DestinationMask(type.VectorType(), vectorelem);
-      // else fall thru:
+      // else fall through
     default: return "";
   }
 }
@@ -1412,6 +1412,18 @@ bool GenerateBinary(const Parser &parser,
            true);
 }
 
+bool GenerateBinary(const Parser &parser,
+                    const uint8_t *flexbuf, size_t size,
+                    const std::string &path,
+                    const std::string &file_name) {
+  return !size ||
+         flatbuffers::SaveFile(
+           BinaryFileName(parser, path, file_name).c_str(),
+           reinterpret_cast<const char *>(flexbuf),
+           size,
+           true);
+}
+
 std::string BinaryMakeRule(const Parser &parser,
                            const std::string &path,
                            const std::string &file_name) {
@@ -16,7 +16,15 @@
 
 // independent from idl_parser, since this code is not needed for most clients
 
+#include <errno.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/flexbuffers.h"
 #include "flatbuffers/idl.h"
 #include "flatbuffers/util.h"
 
@@ -24,7 +32,7 @@ namespace flatbuffers {
 
 static bool GenStruct(const StructDef &struct_def, const Table *table,
                       int indent, const IDLOptions &opts,
-                      std::string *_text);
+                      TextSink *_text);
 
 // If indentation is less than 0, that indicates we don't want any newlines
 // either.
@@ -38,8 +46,8 @@ int Indent(const IDLOptions &opts) {
 
 // Output an identifier with or without quotes depending on strictness.
 void OutputIdentifier(const std::string &name, const IDLOptions &opts,
-                      std::string *_text) {
-  std::string &text = *_text;
+                      TextSink *_text) {
+  TextSink &text = *_text;
   if (opts.strict_json) text += "\"";
   text += name;
   if (opts.strict_json) text += "\"";
@@ -51,10 +59,10 @@ void OutputIdentifier(const std::string &name, const IDLOptions &opts,
 template<typename T> bool Print(T val, Type type, int /*indent*/,
                                 StructDef * /*union_sd*/,
                                 const IDLOptions &opts,
-                                std::string *_text) {
-  std::string &text = *_text;
+                                TextSink *_text) {
+  TextSink &text = *_text;
   if (type.enum_def && opts.output_enum_identifiers) {
-    auto enum_val = type.enum_def->ReverseLookup(static_cast<int>(val));
+    auto enum_val = type.enum_def->ReverseLookup(static_cast<int64_t>(val));
     if (enum_val) {
       OutputIdentifier(enum_val->name, opts, _text);
       return true;
@@ -73,8 +81,8 @@ template<typename T> bool Print(T val, Type type, int /*indent*/,
 // Print a vector a sequence of JSON values, comma separated, wrapped in "[]".
 template<typename T> bool PrintVector(const Vector<T> &v, Type type,
                                       int indent, const IDLOptions &opts,
-                                      std::string *_text) {
-  std::string &text = *_text;
+                                      TextSink *_text) {
+  TextSink &text = *_text;
   text += "[";
   text += NewLine(opts);
   for (uoffset_t i = 0; i < v.size(); i++) {
@@ -82,7 +90,7 @@ template<typename T> bool PrintVector(const Vector<T> &v, Type type,
       text += ",";
       text += NewLine(opts);
     }
-    text.append(indent + Indent(opts), ' ');
+    text.WriteRepeated(indent + Indent(opts), ' ');
     if (IsStruct(type)) {
       if (!Print(v.GetStructFromOffset(i * type.struct_def->bytesize), type,
                  indent + Indent(opts), nullptr, opts, _text)) {
@@ -96,13 +104,13 @@ template<typename T> bool PrintVector(const Vector<T> &v, Type type,
     }
   }
   text += NewLine(opts);
-  text.append(indent, ' ');
+  text.WriteRepeated(indent, ' ');
   text += "]";
   return true;
 }
 
-static bool EscapeString(const String &s, std::string *_text, const IDLOptions& opts) {
-  std::string &text = *_text;
+static bool EscapeString(const String &s, TextSink *_text, const IDLOptions& opts) {
+  TextSink &text = *_text;
   text += "\"";
   for (uoffset_t i = 0; i < s.size(); i++) {
     char c = s[i];
@@ -171,7 +179,7 @@ template<> bool Print<const void *>(const void *val,
                                     Type type, int indent,
                                     StructDef *union_sd,
                                     const IDLOptions &opts,
-                                    std::string *_text) {
+                                    TextSink *_text) {
   switch (type.base_type) {
     case BASE_TYPE_UNION:
       // If this assert hits, you have an corrupt buffer, a union type field
@@ -227,7 +235,7 @@ template<typename T> static bool GenField(const FieldDef &fd,
                                           const Table *table, bool fixed,
                                           const IDLOptions &opts,
                                           int indent,
-                                          std::string *_text) {
+                                          TextSink *_text) {
   return Print(fixed ?
     reinterpret_cast<const Struct *>(table)->GetField<T>(fd.value.offset) :
     table->GetField<T>(fd.value.offset, 0), fd.value.type, indent, nullptr,
@@ -237,7 +245,7 @@ template<typename T> static bool GenField(const FieldDef &fd,
 // Generate text for non-scalar field.
 static bool GenFieldOffset(const FieldDef &fd, const Table *table, bool fixed,
                            int indent, StructDef *union_sd,
-                           const IDLOptions &opts, std::string *_text) {
+                           const IDLOptions &opts, TextSink *_text) {
   const void *val = nullptr;
   if (fixed) {
     // The only non-scalar fields in structs are structs.
@@ -256,8 +264,8 @@ static bool GenFieldOffset(const FieldDef &fd, const Table *table, bool fixed,
 // and bracketed by "{}"
 static bool GenStruct(const StructDef &struct_def, const Table *table,
                       int indent, const IDLOptions &opts,
-                      std::string *_text) {
-  std::string &text = *_text;
+                      TextSink *_text) {
+  TextSink &text = *_text;
   text += "{";
   int fieldout = 0;
   StructDef *union_sd = nullptr;
@@ -274,7 +282,7 @@ static bool GenStruct(const StructDef &struct_def, const Table *table,
         text += ",";
       }
       text += NewLine(opts);
-      text.append(indent + Indent(opts), ' ');
+      text.WriteRepeated(indent + Indent(opts), ' ');
       OutputIdentifier(fd.name, opts, _text);
       text += ": ";
       if (is_present) {
@@ -315,17 +323,70 @@ static bool GenStruct(const StructDef &struct_def, const Table *table,
     }
   }
   text += NewLine(opts);
-  text.append(indent, ' ');
+  text.WriteRepeated(indent, ' ');
   text += "}";
   return true;
 }
 
+void TextSink::Write(const char *data, size_t size) {
+  while (size) {
+    if (used_ == chunk_.size()) Flush();
+    auto n = std::min(size, chunk_.size() - used_);
+    memcpy(&chunk_[used_], data, n);
+    used_ += n;
+    data += n;
+    size -= n;
+  }
+}
+
+void TextSink::WriteRepeated(size_t count, char c) {
+  while (count) {
+    if (used_ == chunk_.size()) Flush();
+    auto n = std::min(count, chunk_.size() - used_);
+    memset(&chunk_[used_], c, n);
+    used_ += n;
+    count -= n;
+  }
+}
+
+bool TextSink::Flush() {
+  // After a failed write, output is dropped but we keep accepting it, so the
+  // generator doesn't need to check after every append.
+  if (used_ && ok_) ok_ = writer_(chunk_.data(), used_);
+  used_ = 0;
+  return ok_;
+}
+
+TextSink::Writer TextSink::FileWriter(FILE *file) {
+  return [file](const char *data, size_t size) {
+    return fwrite(data, 1, size, file) == size;
+  };
+}
+
+TextSink::Writer TextSink::FileDescriptorWriter(int fd) {
+  return [fd](const char *data, size_t size) {
+    while (size) {
+      #ifdef _WIN32
+        auto written = _write(fd, data, static_cast<unsigned int>(size));
+      #else
+        auto written = write(fd, data, size);
+      #endif
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      data += written;
+      size -= static_cast<size_t>(written);
+    }
+    return true;
+  };
+}
+
 // Generate a text representation of a flatbuffer in JSON format.
 bool GenerateText(const Parser &parser, const void *flatbuffer,
-                  std::string *_text) {
-  std::string &text = *_text;
+                  TextSink *_text) {
+  TextSink &text = *_text;
   assert(parser.root_struct_def_);  // call SetRootType()
-  text.reserve(1024);   // Reduce amount of inevitable reallocs.
   if (!GenStruct(*parser.root_struct_def_,
                  GetRoot<Table>(flatbuffer),
                  0,
@@ -334,7 +395,18 @@ bool GenerateText(const Parser &parser, const void *flatbuffer,
     return false;
   }
   text += NewLine(parser.opts);
-  return true;
+  return text.Flush();
+}
+
+bool GenerateText(const Parser &parser, const void *flatbuffer,
+                  std::string *_text) {
+  std::string &text = *_text;
+  text.reserve(1024);   // Reduce amount of inevitable reallocs.
+  TextSink sink([&text](const char *data, size_t size) {
+    text.append(data, size);
+    return true;
+  });
+  return GenerateText(parser, flatbuffer, &sink);
 }
 
 std::string TextFileName(const std::string &path,
@@ -346,13 +418,35 @@ bool GenerateTextFile(const Parser &parser,
                       const std::string &path,
                       const std::string &file_name) {
   if (!parser.builder_.GetSize() || !parser.root_struct_def_) return true;
-  std::string text;
-  if (!GenerateText(parser, parser.builder_.GetBufferPointer(), &text)) {
-    return false;
-  }
-  return flatbuffers::SaveFile(TextFileName(path, file_name).c_str(),
-                               text,
-                               false);
+  // Stream straight to the file, rather than building the text in memory.
+  auto filename = TextFileName(path, file_name);
+  FILE *file = fopen(filename.c_str(), "w");
+  if (!file) return false;
+  TextSink sink(TextSink::FileWriter(file));
+  auto ok = GenerateText(parser, parser.builder_.GetBufferPointer(), &sink);
+  if (fclose(file) != 0) ok = false;
+  if (!ok) remove(filename.c_str());
+  return ok;
+}
+
+bool GenerateTextFile(const Parser &parser,
+                      const uint8_t *flexbuf, size_t size,
+                      const std::string &path,
+                      const std::string &file_name) {
+  if (!size) return true;
+  auto filename = TextFileName(path, file_name);
+  FILE *file = fopen(filename.c_str(), "w");
+  if (!file) return false;
+  TextSink sink(TextSink::FileWriter(file));
+  JsonOptions opts;
+  opts.indent_step = parser.opts.indent_step;
+  opts.strict_json = parser.opts.strict_json;
+  opts.allow_non_utf8 = parser.opts.allow_non_utf8;
+  auto ok = flexbuffers::GetRoot(flexbuf, size).ToJson(sink, opts) &&
+            sink.Flush();
+  if (fclose(file) != 0) ok = false;
+  if (!ok) remove(filename.c_str());
+  return ok;
 }
 
 std::string TextMakeRule(const Parser &parser,
@@ -221,7 +221,7 @@ std::string Parser::TokenToStringId(int t) {
 // Parses exactly nibbles worth of hex digits into a number, or error.
 CheckedError Parser::ParseHexNum(int nibbles, uint64_t *val) {
   for (int i = 0; i < nibbles; i++)
-    if (!isxdigit(static_cast<const unsigned char>(cursor_[i])))
+    if (!isxdigit(static_cast<unsigned char>(cursor_[i])))
       return Error("escape code must be followed by " + NumToString(nibbles) +
                    " hex digits");
   std::string target(cursor_, cursor_ + nibbles);
@@ -258,7 +258,7 @@ CheckedError Parser::Next() {
       case '{': case '}': case '(': case ')': case '[': case ']':
       case ',': case ':': case ';': case '=': return NoError();
       case '.':
-        if(!isdigit(static_cast<const unsigned char>(*cursor_))) return NoError();
+        if(!isdigit(static_cast<unsigned char>(*cursor_))) return NoError();
         return Error("floating point constant can\'t start with \".\"");
       case '\"':
       case '\'': {
@@ -646,8 +646,8 @@ CheckedError Parser::ParseField(StructDef &struct_def) {
       IsScalar(type.base_type) &&
       !struct_def.fixed &&
       !type.enum_def->attributes.Lookup("bit_flags") &&
-      !type.enum_def->ReverseLookup(static_cast<int>(
-                         StringToInt(field->value.constant.c_str()))))
+      !type.enum_def->ReverseLookup(
+                         StringToInt(field->value.constant.c_str())))
     return Error("enum " + type.enum_def->name +
           " does not have a declaration for this field\'s default of " +
           field->value.constant);
@@ -793,7 +793,7 @@ CheckedError Parser::ParseAnyValue(Value &val, FieldDef *field,
     case BASE_TYPE_STRING: {
       auto s = attribute_;
       EXPECT(kTokenStringConstant);
-      val.constant = NumToString(builder_.CreateString(s).o);
+      val.constant = NumToString(json_builder_->CreateString(s).o);
       break;
     }
     case BASE_TYPE_VECTOR: {
@@ -824,10 +824,11 @@ CheckedError Parser::ParseAnyValue(Value &val, FieldDef *field,
 
 void Parser::SerializeStruct(const StructDef &struct_def, const Value &val) {
   assert(val.constant.length() == struct_def.bytesize);
-  builder_.Align(struct_def.minalign);
-  builder_.PushBytes(reinterpret_cast<const uint8_t *>(val.constant.c_str()),
-                     struct_def.bytesize);
-  builder_.AddStructOffset(val.offset, builder_.GetSize());
+  json_builder_->Align(struct_def.minalign);
+  json_builder_->PushBytes(
+      reinterpret_cast<const uint8_t *>(val.constant.c_str()),
+      struct_def.bytesize);
+  json_builder_->AddStructOffset(val.offset, json_builder_->GetSize());
 }
 
 CheckedError Parser::ParseTable(const StructDef &struct_def, std::string *value,
@@ -836,20 +837,19 @@ CheckedError Parser::ParseTable(const StructDef &struct_def, std::string *value,
   size_t fieldn = 0;
   for (;;) {
     if ((!opts.strict_json || !fieldn) && Is('}')) { NEXT(); break; }
-    std::string name = attribute_;
-    if (Is(kTokenStringConstant)) {
-      NEXT();
-    } else {
+    if (!Is(kTokenStringConstant) &&
+        (opts.strict_json || !Is(kTokenIdentifier))) {
       EXPECT(opts.strict_json ? kTokenStringConstant : kTokenIdentifier);
     }
-    auto field = struct_def.fields.Lookup(name);
+    // Look the key up before NEXT() overwrites it, so it needn't be copied.
+    auto field = struct_def.fields.Lookup(attribute_.c_str(),
+                                          attribute_.length());
+    if (!field && !opts.skip_unexpected_fields_in_json)
+      return Error("unknown field: " + attribute_);
+    NEXT();
     if (!field) {
-      if (!opts.skip_unexpected_fields_in_json) {
-        return Error("unknown field: " + name);
-      } else {
-        EXPECT(':');
-        ECHECK(SkipAnyJsonValue());
-      }
+      EXPECT(':');
+      ECHECK(SkipAnyJsonValue());
     } else {
       EXPECT(':');
       if (Is(kTokenNull)) {
@@ -880,8 +880,8 @@ CheckedError Parser::ParseTable(const StructDef &struct_def, std::string *value,
     return Error("struct: wrong number of initializers: " + struct_def.name);
 
   auto start = struct_def.fixed
-                 ? builder_.StartStruct(struct_def.minalign)
-                 : builder_.StartTable();
+                 ? json_builder_->StartStruct(struct_def.minalign)
+                 : json_builder_->StartTable();
 
   for (size_t size = struct_def.sortbysize ? sizeof(largest_scalar_t) : 1;
        size;
@@ -897,16 +897,16 @@ CheckedError Parser::ParseTable(const StructDef &struct_def, std::string *value,
           #define FLATBUFFERS_TD(ENUM, IDLTYPE, CTYPE, JTYPE, GTYPE, NTYPE, \
             PTYPE, STYPE) \
             case BASE_TYPE_ ## ENUM: \
-              builder_.Pad(field->padding); \
+              json_builder_->Pad(field->padding); \
               if (struct_def.fixed) { \
                 CTYPE val; \
                 ECHECK(atot(field_value.constant.c_str(), *this, &val)); \
-                builder_.PushElement(val); \
+                json_builder_->PushElement(val); \
               } else { \
                 CTYPE val, valdef; \
                 ECHECK(atot(field_value.constant.c_str(), *this, &val)); \
                 ECHECK(atot(field->value.constant.c_str(), *this, &valdef)); \
-                builder_.AddElement(field_value.offset, val, valdef); \
+                json_builder_->AddElement(field_value.offset, val, valdef); \
               } \
               break;
             FLATBUFFERS_GEN_TYPES_SCALAR(FLATBUFFERS_TD);
@@ -914,13 +914,13 @@ CheckedError Parser::ParseTable(const StructDef &struct_def, std::string *value,
           #define FLATBUFFERS_TD(ENUM, IDLTYPE, CTYPE, JTYPE, GTYPE, NTYPE, \
             PTYPE, STYPE) \
             case BASE_TYPE_ ## ENUM: \
-              builder_.Pad(field->padding); \
+              json_builder_->Pad(field->padding); \
               if (IsStruct(field->value.type)) { \
                 SerializeStruct(*field->value.type.struct_def, field_value); \
               } else { \
                 CTYPE val; \
                 ECHECK(atot(field_value.constant.c_str(), *this, &val)); \
-                builder_.AddOffset(field_value.offset, val); \
+                json_builder_->AddOffset(field_value.offset, val); \
               } \
               break;
             FLATBUFFERS_GEN_TYPES_POINTER(FLATBUFFERS_TD);
@@ -932,19 +932,19 @@ CheckedError Parser::ParseTable(const StructDef &struct_def, std::string *value,
   for (size_t i = 0; i < fieldn; i++) field_stack_.pop_back();
 
   if (struct_def.fixed) {
-    builder_.ClearOffsets();
-    builder_.EndStruct();
+    json_builder_->ClearOffsets();
+    json_builder_->EndStruct();
     assert(value);
     // Temporarily store this struct in the value string, since it is to
     // be serialized in-place elsewhere.
-    value->assign(
-          reinterpret_cast<const char *>(builder_.GetCurrentBufferPointer()),
-          struct_def.bytesize);
-    builder_.PopBytes(struct_def.bytesize);
+    value->assign(reinterpret_cast<const char *>(
+                    json_builder_->GetCurrentBufferPointer()),
+                  struct_def.bytesize);
+    json_builder_->PopBytes(struct_def.bytesize);
     assert(!ovalue);
   } else {
-    auto val = builder_.EndTable(start,
-                          static_cast<voffset_t>(struct_def.fields.vec.size()));
+    auto val = json_builder_->EndTable(start,
+                 static_cast<voffset_t>(struct_def.fields.vec.size()));
     if (ovalue) *ovalue = val;
     if (value) *value = NumToString(val);
   }
@@ -964,8 +964,8 @@ CheckedError Parser::ParseVector(const Type &type, uoffset_t *ovalue) {
     EXPECT(',');
   }
 
-  builder_.StartVector(count * InlineSize(type) / InlineAlignment(type),
-                       InlineAlignment(type));
+  json_builder_->StartVector(
+      count * InlineSize(type) / InlineAlignment(type), InlineAlignment(type));
   for (int i = 0; i < count; i++) {
     // start at the back, since we're building the data backwards.
     auto &val = field_stack_.back().first;
@@ -976,7 +976,7 @@ CheckedError Parser::ParseVector(const Type &type, uoffset_t *ovalue) {
           else { \
              CTYPE elem; \
              ECHECK(atot(val.constant.c_str(), *this, &elem)); \
-             builder_.PushElement(elem); \
+             json_builder_->PushElement(elem); \
           } \
           break;
         FLATBUFFERS_GEN_TYPES(FLATBUFFERS_TD)
@@ -985,8 +985,8 @@ CheckedError Parser::ParseVector(const Type &type, uoffset_t *ovalue) {
     field_stack_.pop_back();
   }
 
-  builder_.ClearOffsets();
-  *ovalue = builder_.EndVector(count);
+  json_builder_->ClearOffsets();
+  *ovalue = json_builder_->EndVector(count);
   return NoError();
 }
 
@@ -1039,21 +1039,24 @@ CheckedError Parser::ParseEnumFromString(Type &type, int64_t *result) {
   const char *next = attribute_.c_str();
   do {
     const char *divider = strchr(next, ' ');
-    std::string word;
+    const char *word_start = next;
+    size_t word_len;
     if (divider) {
-      word = std::string(next, divider);
+      word_len = static_cast<size_t>(divider - next);
       next = divider + strspn(divider, " ");
     } else {
-      word = next;
-      next += word.length();
+      word_len = strlen(next);
+      next += word_len;
     }
     if (type.enum_def) {  // The field has an enum type
-      auto enum_val = type.enum_def->vals.Lookup(word);
+      auto enum_val = type.enum_def->vals.Lookup(word_start, word_len);
       if (!enum_val)
-        return Error("unknown enum value: " + word +
+        return Error("unknown enum value: " +
+              std::string(word_start, word_len) +
               ", for enum: " + type.enum_def->name);
       *result |= enum_val->value;
     } else {  // No enum type, probably integral field.
+      std::string word(word_start, word_len);
       if (!IsInteger(type.base_type))
         return Error("not a valid value for this field: " + word);
       // TODO: could check if its a valid number constant here.
@@ -1850,7 +1853,114 @@ CheckedError Parser::SkipJsonString() {
 
 bool Parser::Parse(const char *source, const char **include_paths,
                    const char *source_filename) {
-  return !DoParse(source, include_paths, source_filename).Check();
+  if (DoParse(source, include_paths, source_filename).Check()) return false;
+  FreezeSymbolTables();
+  return true;
+}
+
+bool Parser::ParseJsonStream(const char *source,
+                             const std::function<void(const uint8_t *buf,
+                                                      size_t size)> &sink,
+                             const char *source_filename) {
+  return !DoParseJsonStream(source, sink, source_filename).Check();
+}
+
+CheckedError Parser::DoParseJsonStream(
+    const char *source,
+    const std::function<void(const uint8_t *buf, size_t size)> &sink,
+    const char *source_filename) {
+  // Unlike DoParse(), this leaves the schema (and namespaces_) untouched, so
+  // all state reset here is reused capacity.
+  file_being_parsed_ = source_filename ? source_filename : "";
+  source_ = cursor_ = source;
+  line_ = 1;
+  error_.clear();
+  field_stack_.clear();
+  if (!root_struct_def_) return Error("no root type set to parse json with");
+  FreezeSymbolTables();
+  ECHECK(SkipByteOrderMark());
+  NEXT();
+  while (!Is(kTokenEof)) {
+    if (!Is('{')) EXPECT('{');  // Error.
+    builder_.Clear();
+    uoffset_t toff;
+    ECHECK(ParseTable(*root_struct_def_, nullptr, &toff));
+    builder_.FinishSizePrefixed(Offset<Table>(toff),
+                file_identifier_.length() ? file_identifier_.c_str() : nullptr);
+    sink(builder_.GetBufferPointer(), builder_.GetSize());
+  }
+  return NoError();
+}
+
+bool Parser::ParseJsonInto(FlatBufferBuilder &fbb, const StructDef &struct_def,
+                           const char *json, size_t len, Offset<void> *out) {
+  // The tokenizer relies on a terminator, so keep a zero terminated copy of
+  // the text. Its capacity is reused across calls.
+  json_source_.assign(json, len);
+  json_builder_ = &fbb;
+  auto ce = DoParseJsonInto(struct_def, out);
+  json_builder_ = &builder_;
+  return !ce.Check();
+}
+
+CheckedError Parser::DoParseJsonInto(const StructDef &struct_def,
+                                     Offset<void> *out) {
+  file_being_parsed_.clear();
+  source_ = cursor_ = json_source_.c_str();
+  line_ = 1;
+  error_.clear();
+  field_stack_.clear();
+  if (struct_def.fixed)
+    return Error("json can only be parsed into a table: " + struct_def.name);
+  FreezeSymbolTables();
+  ECHECK(SkipByteOrderMark());
+  NEXT();
+  uoffset_t toff;
+  ECHECK(ParseTable(struct_def, nullptr, &toff));
+  EXPECT(kTokenEof);
+  *out = Offset<void>(toff);
+  return NoError();
+}
+
+void Parser::FreezeSymbolTables() {
+  for (auto it = structs_.vec.begin(); it != structs_.vec.end(); ++it) {
+    (*it)->fields.Freeze();
+  }
+  for (auto it = enums_.vec.begin(); it != enums_.vec.end(); ++it) {
+    (*it)->Freeze();
+  }
+}
+
+void EnumDef::Freeze() {
+  // vals.Add() unfreezes vals, so the index is only rebuilt after new values
+  // were added.
+  if (reverse_indexed_ && vals.IsFrozen()) return;
+  vals.Freeze();
+  reverse_dense_.clear();
+  reverse_sparse_.clear();
+  reverse_indexed_ = true;
+  if (vals.vec.empty()) return;
+  auto min = vals.vec.front()->value, max = min;
+  for (auto it = vals.vec.begin(); it != vals.vec.end(); ++it) {
+    min = std::min(min, (*it)->value);
+    max = std::max(max, (*it)->value);
+  }
+  // Same sparseness threshold as the generated EnumNames() tables.
+  static const uint64_t kMaxSparseness = 5;
+  auto range = static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+  if (range && range / vals.vec.size() < kMaxSparseness) {
+    reverse_min_ = min;
+    reverse_dense_.resize(static_cast<size_t>(range), nullptr);
+    for (auto it = vals.vec.begin(); it != vals.vec.end(); ++it) {
+      // Keep the first of any aliases, like the linear search does.
+      auto &ev = reverse_dense_[static_cast<size_t>((*it)->value - min)];
+      if (!ev) ev = *it;
+    }
+  } else {
+    for (auto it = vals.vec.begin(); it != vals.vec.end(); ++it) {
+      reverse_sparse_.insert(std::make_pair((*it)->value, *it));
+    }
+  }
 }
 
 CheckedError Parser::DoParse(const char *source, const char **include_paths,
@@ -1938,6 +2048,7 @@ CheckedError Parser::DoParse(const char *source, const char **include_paths,
       if (builder_.GetSize()) {
         return Error("cannot have more than one json object in a file");
       }
+      FreezeSymbolTables();
       uoffset_t toff;
       ECHECK(ParseTable(*root_struct_def_, nullptr, &toff));
       builder_.Finish(Offset<Table>(toff),
@@ -2162,7 +2273,7 @@ flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<
   for (auto kv = attributes.dict.begin(); kv != attributes.dict.end(); ++kv) {
     auto it = parser.known_attributes_.find(kv->first);
     assert(it != parser.known_attributes_.end());
-    if (!it->second) {  // Custom attribute.
+    if (parser.opts.binary_schema_builtins || !it->second) {
       attrs.push_back(
           reflection::CreateKeyValue(*builder, builder->CreateString(kv->first),
                                      builder->CreateString(
@@ -2176,6 +2287,241 @@ flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<
   }
 }
 
+bool Definition::DeserializeAttributes(
+    Parser &parser, const Vector<Offset<reflection::KeyValue>> *attrs) {
+  if (attrs == nullptr) return true;
+  for (uoffset_t i = 0; i < attrs->size(); ++i) {
+    auto kv = attrs->Get(i);
+    auto value = new Value();
+    if (kv->value()) value->constant = kv->value()->str();
+    if (attributes.Add(kv->key()->str(), value)) {
+      delete value;
+      return false;
+    }
+    // Custom attributes must be known for ConformTo() and re-serialization.
+    if (parser.known_attributes_.find(kv->key()->str()) ==
+        parser.known_attributes_.end())
+      parser.known_attributes_[kv->key()->str()] = false;
+  }
+  return true;
+}
+
+// Schema deserialization functionality:
+
+static void DeserializeDocComment(
+    std::vector<std::string> *doc_comment,
+    const Vector<Offset<String>> *documentation) {
+  if (documentation == nullptr) return;
+  for (uoffset_t i = 0; i < documentation->size(); ++i)
+    doc_comment->push_back(documentation->Get(i)->str());
+}
+
+// Splits "A.B.C" into a namespace for "A.B" (shared between definitions) and
+// returns "C".
+static std::string DeserializeQualifiedName(
+    Parser &parser, std::map<std::string, Namespace *> &namespaces,
+    const std::string &qualified_name, Namespace **ns) {
+  auto dot = qualified_name.find_last_of('.');
+  auto prefix = dot == std::string::npos ? std::string()
+                                         : qualified_name.substr(0, dot);
+  auto it = namespaces.find(prefix);
+  if (it != namespaces.end()) {
+    *ns = it->second;
+  } else {
+    *ns = new Namespace();
+    size_t start = 0;
+    while (start < prefix.length()) {
+      auto end = prefix.find('.', start);
+      if (end == std::string::npos) end = prefix.length();
+      (*ns)->components.push_back(prefix.substr(start, end - start));
+      start = end + 1;
+    }
+    parser.namespaces_.push_back(*ns);
+    namespaces[prefix] = *ns;
+  }
+  return dot == std::string::npos ? qualified_name
+                                  : qualified_name.substr(dot + 1);
+}
+
+bool Parser::Deserialize(const uint8_t *buf, size_t size) {
+  Verifier verifier(buf, size);
+  if (!reflection::VerifySchemaBuffer(verifier)) {
+    error_ = "binary schema failed verification";
+    return false;
+  }
+  return Deserialize(*reflection::GetSchema(buf));
+}
+
+bool Parser::Deserialize(const reflection::Schema &schema) {
+  error_.clear();
+  if (structs_.vec.size() || enums_.vec.size()) {
+    error_ = "binary schemas can only be loaded into an empty parser";
+    return false;
+  }
+  std::map<std::string, Namespace *> namespaces;
+  // First create all definitions, such that types can refer to them by index
+  // (which is the position in the name-sorted schema vectors).
+  auto objects = schema.objects();
+  for (uoffset_t i = 0; i < objects->size(); ++i) {
+    auto object = objects->Get(i);
+    auto struct_def = new StructDef();
+    struct_def->name = DeserializeQualifiedName(*this, namespaces,
+                                                object->name()->str(),
+                                                &struct_def->defined_namespace);
+    struct_def->index = static_cast<int>(i);
+    if (structs_.Add(object->name()->str(), struct_def)) {
+      delete struct_def;
+      error_ = "datatype already exists: " + object->name()->str();
+      return false;
+    }
+    types_.Add(object->name()->str(),
+               new Type(BASE_TYPE_STRUCT, struct_def, nullptr));
+  }
+  auto enums = schema.enums();
+  for (uoffset_t i = 0; i < enums->size(); ++i) {
+    auto _enum = enums->Get(i);
+    auto enum_def = new EnumDef();
+    enum_def->name = DeserializeQualifiedName(*this, namespaces,
+                                              _enum->name()->str(),
+                                              &enum_def->defined_namespace);
+    enum_def->index = static_cast<int>(i);
+    if (enums_.Add(_enum->name()->str(), enum_def)) {
+      delete enum_def;
+      error_ = "enum already exists: " + _enum->name()->str();
+      return false;
+    }
+    types_.Add(_enum->name()->str(),
+               new Type(BASE_TYPE_UNION, nullptr, enum_def));
+  }
+  // Then fill them in.
+  for (uoffset_t i = 0; i < objects->size(); ++i) {
+    if (!structs_.vec[i]->Deserialize(*this, objects->Get(i))) {
+      if (error_.empty())
+        error_ = "malformed binary schema object: " +
+                 objects->Get(i)->name()->str();
+      return false;
+    }
+    if (schema.root_table() == objects->Get(i))
+      root_struct_def_ = structs_.vec[i];
+  }
+  for (uoffset_t i = 0; i < enums->size(); ++i) {
+    if (!enums_.vec[i]->Deserialize(*this, enums->Get(i))) {
+      if (error_.empty())
+        error_ = "malformed binary schema enum: " +
+                 enums->Get(i)->name()->str();
+      return false;
+    }
+  }
+  if (schema.file_ident()) file_identifier_ = schema.file_ident()->str();
+  if (schema.file_ext()) file_extension_ = schema.file_ext()->str();
+  FreezeSymbolTables();
+  return true;
+}
+
+bool StructDef::Deserialize(Parser &parser, const reflection::Object *object) {
+  fixed = object->is_struct();
+  predecl = false;
+  minalign = static_cast<size_t>(object->minalign());
+  bytesize = static_cast<size_t>(object->bytesize());
+  if (!DeserializeAttributes(parser, object->attributes())) return false;
+  DeserializeDocComment(&doc_comment, object->documentation());
+  // The schema stores fields sorted by name, restore declaration order.
+  std::vector<const reflection::Field *> ordered(object->fields()->size());
+  for (uoffset_t i = 0; i < object->fields()->size(); ++i) {
+    auto field = object->fields()->Get(i);
+    if (field->id() >= ordered.size() || ordered[field->id()]) return false;
+    ordered[field->id()] = field;
+  }
+  for (auto it = ordered.begin(); it != ordered.end(); ++it) {
+    auto field_def = new FieldDef();
+    if (!field_def->Deserialize(parser, *this, *it) ||
+        fields.Add(field_def->name, field_def)) {
+      delete field_def;
+      return false;
+    }
+    if (field_def->key) has_key = true;
+  }
+  if (fixed) {
+    // Padding isn't stored, but follows from the offsets of the next field.
+    for (auto it = fields.vec.begin(); it != fields.vec.end(); ++it) {
+      auto end = (*it)->value.offset + InlineSize((*it)->value.type);
+      auto next = it + 1 != fields.vec.end() ? (*(it + 1))->value.offset
+                                              : bytesize;
+      if (next < end) return false;
+      (*it)->padding = next - end;
+    }
+  }
+  sortbysize = attributes.Lookup("original_order") == nullptr && !fixed;
+  return true;
+}
+
+bool FieldDef::Deserialize(Parser &parser, const StructDef &struct_def,
+                           const reflection::Field *field) {
+  name = field->name()->str();
+  defined_namespace = struct_def.defined_namespace;
+  if (!value.type.Deserialize(parser, field->type())) return false;
+  value.offset = field->offset();
+  if (IsInteger(value.type.base_type)) {
+    value.constant = NumToString(field->default_integer());
+  } else if (IsFloat(value.type.base_type)) {
+    value.constant = NumToString(field->default_real());
+  }
+  deprecated = field->deprecated();
+  required = field->required();
+  key = field->key();
+  if (!DeserializeAttributes(parser, field->attributes())) return false;
+  native_inline = attributes.Lookup("native_inline") != nullptr;
+  DeserializeDocComment(&doc_comment, field->documentation());
+  return true;
+}
+
+bool EnumDef::Deserialize(Parser &parser, const reflection::Enum *_enum) {
+  is_union = _enum->is_union();
+  if (!underlying_type.Deserialize(parser, _enum->underlying_type()))
+    return false;
+  // The underlying type refers back to the enum itself.
+  underlying_type.enum_def = this;
+  if (!DeserializeAttributes(parser, _enum->attributes())) return false;
+  DeserializeDocComment(&doc_comment, _enum->documentation());
+  for (uoffset_t i = 0; i < _enum->values()->size(); ++i) {
+    auto val = new EnumVal("", 0);
+    if (!val->Deserialize(parser, _enum->values()->Get(i)) ||
+        vals.Add(val->name, val)) {
+      delete val;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EnumVal::Deserialize(const Parser &parser,
+                          const reflection::EnumVal *val) {
+  name = val->name()->str();
+  value = val->value();
+  if (val->object()) {
+    struct_def = parser.structs_.Lookup(val->object()->name()->str());
+    if (struct_def == nullptr) return false;
+  }
+  return true;
+}
+
+bool Type::Deserialize(const Parser &parser, const reflection::Type *type) {
+  if (type == nullptr) return true;
+  base_type = static_cast<BaseType>(type->base_type());
+  element = static_cast<BaseType>(type->element());
+  auto index = type->index();
+  if (index < 0) return true;
+  if (base_type == BASE_TYPE_STRUCT ||
+      (base_type == BASE_TYPE_VECTOR && element == BASE_TYPE_STRUCT)) {
+    if (static_cast<size_t>(index) >= parser.structs_.vec.size()) return false;
+    struct_def = parser.structs_.vec[index];
+  } else {
+    if (static_cast<size_t>(index) >= parser.enums_.vec.size()) return false;
+    enum_def = parser.enums_.vec[index];
+  }
+  return true;
+}
+
 std::string Parser::ConformTo(const Parser &base) {
   for (auto sit = structs_.vec.begin(); sit != structs_.vec.end(); ++sit) {
     auto &struct_def = **sit;
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2017 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flatbuffers/query.h"
+#include "flatbuffers/util.h"
+
+namespace flatbuffers {
+
+// A recursive descent parser that emits postfix code as it goes.
+class Query::Compiler {
+ public:
+  Compiler(Query &query, const reflection::Object &objectdef,
+           const std::string &expr)
+    : query_(query), objectdef_(objectdef), expr_(expr), pos_(0),
+      depth_(0), nesting_(0) {}
+
+  bool Compile() {
+    if (!ParseOr()) return false;
+    SkipSpace();
+    if (pos_ != expr_.size()) return Error("unexpected text");
+    return true;
+  }
+
+  void operator=(const Compiler &);
+
+ private:
+  bool Error(const std::string &msg) {
+    query_.error_ = msg + " at offset " + NumToString(pos_) + ": " + expr_;
+    return false;
+  }
+
+  void SkipSpace() {
+    while (pos_ < expr_.size() && isspace(static_cast<uint8_t>(expr_[pos_])))
+      pos_++;
+  }
+
+  // Skips "token" if it is next.
+  bool Accept(const char *token) {
+    SkipSpace();
+    auto len = strlen(token);
+    if (expr_.compare(pos_, len, token)) return false;
+    pos_ += len;
+    return true;
+  }
+
+  static bool IsIdentChar(char c) {
+    return isalnum(static_cast<uint8_t>(c)) || c == '_' || c == '.';
+  }
+
+  std::string ParseIdent() {
+    SkipSpace();
+    auto start = pos_;
+    while (pos_ < expr_.size() && IsIdentChar(expr_[pos_])) pos_++;
+    return expr_.substr(start, pos_ - start);
+  }
+
+  void Emit(Opcode op, Comparison cmp = kEq, size_t path = 0,
+            size_t constant = 0) {
+    Instruction ins = { op, cmp, static_cast<uint32_t>(path),
+                        static_cast<uint32_t>(constant) };
+    query_.code_.push_back(ins);
+  }
+
+  // Leaves push a value on the evaluation stack, && and || pop one.
+  bool Push() {
+    if (++depth_ > kMaxDepth) return Error("expression too deep");
+    return true;
+  }
+
+  bool ParseOr() {
+    if (!ParseAnd()) return false;
+    while (Accept("||")) {
+      if (!ParseAnd()) return false;
+      Emit(kOr);
+      depth_--;
+    }
+    return true;
+  }
+
+  bool ParseAnd() {
+    if (!ParseUnary()) return false;
+    while (Accept("&&")) {
+      if (!ParseUnary()) return false;
+      Emit(kAnd);
+      depth_--;
+    }
+    return true;
+  }
+
+  // Every ! and ( recurses through here, so this bounds the recursion on
+  // hostile input, as for JSON.
+  bool ParseUnary() {
+    const size_t kMaxNesting = 64;
+    if (++nesting_ > kMaxNesting) return Error("expression too deep");
+    auto ok = ParseUnaryOperand();
+    nesting_--;
+    return ok;
+  }
+
+  bool ParseUnaryOperand() {
+    if (Accept("!")) {
+      if (!ParseUnary()) return false;
+      Emit(kNot);
+      return true;
+    }
+    if (Accept("(")) {
+      if (!ParseOr()) return false;
+      if (!Accept(")")) return Error("expected )");
+      return true;
+    }
+    return ParseComparison();
+  }
+
+  bool ParseComparison() {
+    auto name = ParseIdent();
+    if (name.empty()) return Error("expected a field");
+    CompiledPath path;
+    if (!query_.schema_.Compile(objectdef_, name, &path))
+      return Error("unknown field: " + name);
+    auto type = path.type();
+    auto path_index = query_.paths_.size();
+    query_.paths_.push_back(path);
+    if (!Push()) return false;
+    // The order matters, as some operators are prefixes of others.
+    static const struct { const char *token; Comparison cmp; } ops[] = {
+      { "==", kEq }, { "!=", kNe }, { "<=", kLe }, { ">=", kGe },
+      { "<", kLt }, { ">", kGt }, { "startswith", kStartsWith }
+    };
+    const Comparison *cmp = nullptr;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]) && !cmp; i++) {
+      if (Accept(ops[i].token)) cmp = &ops[i].cmp;
+    }
+    if (!cmp) {
+      Emit(kIsSet, kEq, path_index);
+      return true;
+    }
+    SkipSpace();
+    if (type == reflection::String) {
+      if (!Accept("\"")) return Error("expected a string for " + name);
+      std::string str;
+      for (;;) {
+        if (pos_ >= expr_.size()) return Error("unterminated string");
+        auto c = expr_[pos_++];
+        if (c == '"') break;
+        if (c == '\\') {
+          if (pos_ >= expr_.size()) return Error("unterminated string");
+          c = expr_[pos_++];
+          if (c != '"' && c != '\\')
+            return Error("unknown escape code in string constant");
+        }
+        str += c;
+      }
+      Emit(kCompareString, *cmp, path_index, query_.strings_.size());
+      query_.strings_.push_back(str);
+      return true;
+    }
+    if (type > reflection::Double)
+      return Error("can only compare scalars and strings: " + name);
+    if (*cmp == kStartsWith)
+      return Error("startswith needs a string field: " + name);
+    auto constant = expr_.c_str() + pos_;
+    if (isdigit(static_cast<uint8_t>(*constant)) || *constant == '-' ||
+        *constant == '+') {
+      char *end = nullptr;
+      // Unsigned 64-bit fields can hold values above INT64_MAX, so they are
+      // compared as unsigned, or as floats with negative constants.
+      auto is_unsigned = type == reflection::ULong;
+      auto i = is_unsigned && *constant != '-'
+               ? static_cast<int64_t>(StringToUInt(constant, &end))
+               : StringToInt(constant, &end);
+      if (type == reflection::Float || type == reflection::Double ||
+          (is_unsigned && *constant == '-') ||
+          *end == '.' || *end == 'e' || *end == 'E') {
+        auto f = strtod(constant, &end);
+        Emit(kCompareFloat, *cmp, path_index, query_.floats_.size());
+        query_.floats_.push_back(f);
+      } else {
+        Emit(is_unsigned ? kCompareUInt : kCompareInt, *cmp, path_index,
+             query_.ints_.size());
+        query_.ints_.push_back(i);
+      }
+      if (end == constant) return Error("expected a number");
+      pos_ += end - constant;
+      return true;
+    }
+    auto ident = ParseIdent();
+    int64_t value = 0;
+    if (ident == "true") {
+      value = 1;
+    } else if (ident != "false") {
+      auto index = path.field().type()->index();
+      if (index < 0) return Error("expected a number for " + name);
+      auto values = query_.schema_.schema().enums()->Get(index)->values();
+      auto it = values->begin();
+      while (it != values->end() && ident != it->name()->c_str()) ++it;
+      if (it == values->end()) return Error("unknown enum value: " + ident);
+      value = it->value();
+    }
+    if (type == reflection::Float || type == reflection::Double) {
+      Emit(kCompareFloat, *cmp, path_index, query_.floats_.size());
+      query_.floats_.push_back(static_cast<double>(value));
+    } else {
+      Emit(type == reflection::ULong ? kCompareUInt : kCompareInt, *cmp,
+           path_index, query_.ints_.size());
+      query_.ints_.push_back(value);
+    }
+    return true;
+  }
+
+  Query &query_;
+  const reflection::Object &objectdef_;
+  const std::string &expr_;
+  size_t pos_;
+  size_t depth_;    // Of the evaluation stack.
+  size_t nesting_;  // Of ParseUnary() calls.
+};
+
+bool Query::Compile(const reflection::Object &objectdef,
+                    const std::string &expr) {
+  code_.clear();
+  paths_.clear();
+  ints_.clear();
+  floats_.clear();
+  strings_.clear();
+  error_.clear();
+  Compiler compiler(*this, objectdef, expr);
+  if (compiler.Compile()) return true;
+  code_.clear();
+  return false;
+}
+
+template<typename T> static bool Compare(Query::Comparison cmp, T a, T b) {
+  switch (cmp) {
+    case Query::kEq: return a == b;
+    case Query::kNe: return a != b;
+    case Query::kLt: return a < b;
+    case Query::kLe: return a <= b;
+    case Query::kGt: return a > b;
+    case Query::kGe: return a >= b;
+    default: return false;  // kStartsWith is for strings only.
+  }
+}
+
+// Compares "str" with "constant", returning false if "str" is not set
+// (true for !=).
+static bool CompareString(Query::Comparison cmp, const String *str,
+                          const std::string &constant) {
+  if (!str) return cmp == Query::kNe;
+  auto len = std::min<size_t>(str->size(), constant.size());
+  if (cmp == Query::kStartsWith) {
+    return str->size() >= constant.size() &&
+           !memcmp(str->c_str(), constant.c_str(), constant.size());
+  }
+  auto diff = memcmp(str->c_str(), constant.c_str(), len);
+  if (!diff) {
+    diff = str->size() < constant.size() ? -1 : str->size() > len;
+  }
+  return Compare(cmp, diff, 0);
+}
+
+bool Query::Evaluate(const Table &table) const {
+  if (code_.empty()) return true;
+  uint8_t stack[kMaxDepth];
+  size_t sp = 0;
+  for (auto it = code_.begin(); it != code_.end(); ++it) {
+    switch (it->op) {
+      case kCompareInt:
+        stack[sp++] = Compare(it->cmp, paths_[it->path].GetI(table),
+                              ints_[it->constant]);
+        break;
+      case kCompareUInt:
+        stack[sp++] = Compare(
+          it->cmp, static_cast<uint64_t>(paths_[it->path].GetI(table)),
+          static_cast<uint64_t>(ints_[it->constant]));
+        break;
+      case kCompareFloat:
+        stack[sp++] = Compare(it->cmp, paths_[it->path].GetF(table),
+                              floats_[it->constant]);
+        break;
+      case kCompareString:
+        stack[sp++] = CompareString(it->cmp,
+                                    paths_[it->path].GetString(table),
+                                    strings_[it->constant]);
+        break;
+      case kIsSet:
+        stack[sp++] = paths_[it->path].GetAddress(table) != nullptr;
+        break;
+      case kAnd: sp--; stack[sp - 1] &= stack[sp]; break;
+      case kOr:  sp--; stack[sp - 1] |= stack[sp]; break;
+      case kNot: stack[sp - 1] = !stack[sp - 1]; break;
+    }
+  }
+  return stack[0] != 0;
+}
+
+// Compares the values "read" from "n" tables with "constant". The comparison
+// is picked once, outside the loop.
+template<typename T, typename F>
+static void CompareBlock(Query::Comparison cmp, F read, T constant, size_t n,
+                         uint8_t *out) {
+  #define FLATBUFFERS_COMPARE_BLOCK(CMP, OP) \
+    case CMP: \
+      for (size_t i = 0; i < n; i++) out[i] = read(i) OP constant; \
+      break;
+  switch (cmp) {
+    FLATBUFFERS_COMPARE_BLOCK(Query::kEq, ==)
+    FLATBUFFERS_COMPARE_BLOCK(Query::kNe, !=)
+    FLATBUFFERS_COMPARE_BLOCK(Query::kLt, <)
+    FLATBUFFERS_COMPARE_BLOCK(Query::kLe, <=)
+    FLATBUFFERS_COMPARE_BLOCK(Query::kGt, >)
+    FLATBUFFERS_COMPARE_BLOCK(Query::kGe, >=)
+    default: memset(out, 0, n); break;
+  }
+  #undef FLATBUFFERS_COMPARE_BLOCK
+}
+
+void Query::Evaluate(const uint8_t *const *buffers, size_t count,
+                     uint8_t *results) const {
+  if (code_.empty()) {
+    memset(results, 1, count);
+    return;
+  }
+  const Table *tables[kBlockSize];
+  uint8_t stack[kMaxDepth][kBlockSize];
+  for (size_t start = 0; start < count; start += kBlockSize) {
+    auto n = std::min(count - start, static_cast<size_t>(kBlockSize));
+    for (size_t i = 0; i < n; i++) tables[i] = GetAnyRoot(buffers[start + i]);
+    size_t sp = 0;
+    for (auto it = code_.begin(); it != code_.end(); ++it) {
+      auto &path = paths_[it->path];
+      switch (it->op) {
+        case kCompareInt:
+          CompareBlock(it->cmp,
+                       [&](size_t i) { return path.GetI(*tables[i]); },
+                       ints_[it->constant], n, stack[sp++]);
+          break;
+        case kCompareUInt:
+          CompareBlock(it->cmp,
+                       [&](size_t i) {
+                         return static_cast<uint64_t>(path.GetI(*tables[i]));
+                       },
+                       static_cast<uint64_t>(ints_[it->constant]), n,
+                       stack[sp++]);
+          break;
+        case kCompareFloat:
+          CompareBlock(it->cmp,
+                       [&](size_t i) { return path.GetF(*tables[i]); },
+                       floats_[it->constant], n, stack[sp++]);
+          break;
+        case kCompareString: {
+          auto &constant = strings_[it->constant];
+          auto out = stack[sp++];
+          for (size_t i = 0; i < n; i++) {
+            out[i] = CompareString(it->cmp, path.GetString(*tables[i]),
+                                   constant);
+          }
+          break;
+        }
+        case kIsSet: {
+          auto out = stack[sp++];
+          for (size_t i = 0; i < n; i++) {
+            out[i] = path.GetAddress(*tables[i]) != nullptr;
+          }
+          break;
+        }
+        case kAnd:
+          sp--;
+          for (size_t i = 0; i < n; i++) stack[sp - 1][i] &= stack[sp][i];
+          break;
+        case kOr:
+          sp--;
+          for (size_t i = 0; i < n; i++) stack[sp - 1][i] |= stack[sp][i];
+          break;
+        case kNot:
+          for (size_t i = 0; i < n; i++) stack[sp - 1][i] = !stack[sp - 1][i];
+          break;
+      }
+    }
+    memcpy(results + start, stack[0], n);
+  }
+}
+
+}  // namespace flatbuffers
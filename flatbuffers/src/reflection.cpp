@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <limits>
+
+#include "flatbuffers/flexbuffers.h"
 #include "flatbuffers/reflection.h"
 #include "flatbuffers/util.h"
 
@@ -334,6 +337,222 @@ uint8_t *ResizeAnyVector(const reflection::Schema &schema, uoffset_t newsize,
   return flatbuf->data() + start;
 }
 
+// Rounds a byte delta up to a multiple of the largest alignment, the same way
+// ResizeContext does, so all data after an edit stays aligned.
+static int RoundResizeDelta(int delta) {
+  auto mask = static_cast<int>(sizeof(largest_scalar_t) - 1);
+  return (delta + mask) & ~mask;
+}
+
+void MutationBatch::SetString(const String *str, const std::string &val) {
+  Edit edit;
+  edit.object = static_cast<uoffset_t>(
+                  reinterpret_cast<const uint8_t *>(str) - buf_.data());
+  edit.old_size = str->size();
+  edit.new_size = static_cast<uoffset_t>(val.size());
+  edit.elem_size = 1;
+  edit.is_string = true;
+  edit.data = val;
+  AddEdit(edit);
+}
+
+void MutationBatch::ResizeAnyVector(const VectorOfAny *vec, uoffset_t newsize,
+                                    uoffset_t num_elems, uoffset_t elem_size,
+                                    const uint8_t *fill) {
+  Edit edit;
+  edit.object = static_cast<uoffset_t>(
+                  reinterpret_cast<const uint8_t *>(vec) - buf_.data());
+  edit.old_size = num_elems;
+  edit.new_size = newsize;
+  edit.elem_size = elem_size;
+  edit.is_string = false;
+  if (fill) edit.data.assign(reinterpret_cast<const char *>(fill), elem_size);
+  AddEdit(edit);
+}
+
+void MutationBatch::AddEdit(Edit &edit) {
+  assert(edit.object < buf_.size());
+  edit.start = edit.object + static_cast<uoffset_t>(sizeof(uoffset_t)) +
+               edit.old_size * edit.elem_size;
+  edit.delta = RoundResizeDelta(
+                 (static_cast<int>(edit.new_size) -
+                  static_cast<int>(edit.old_size)) *
+                 static_cast<int>(edit.elem_size));
+  edits_.push_back(edit);
+}
+
+// Where a byte at "pos" in the old buffer ends up: bytes at or past the start
+// of an edit move along with it.
+uoffset_t MutationBatch::NewPos(uoffset_t pos) const {
+  auto it = std::upper_bound(starts_.begin(), starts_.end(), pos);
+  if (it == starts_.begin()) return pos;
+  return static_cast<uoffset_t>(pos + shifts_[it - starts_.begin() - 1]);
+}
+
+const MutationBatch::Edit *MutationBatch::FindEdit(uoffset_t start) const {
+  auto it = std::lower_bound(starts_.begin(), starts_.end(), start);
+  return it != starts_.end() && *it == start
+         ? &edits_[it - starts_.begin()]
+         : nullptr;
+}
+
+// Offsets are read from the old buffer, which is never modified, so unlike
+// ResizeContext we don't need to track which ones have been changed already.
+void MutationBatch::FixOffset(uoffset_t offsetloc) {
+  auto ref = offsetloc + ReadScalar<uoffset_t>(buf_.data() + offsetloc);
+  auto newloc = NewPos(offsetloc);
+  auto newoffset = NewPos(ref) - newloc;
+  if (newoffset != ref - offsetloc)
+    WriteScalar(newbuf_.data() + newloc, newoffset);
+}
+
+void MutationBatch::FixTable(const reflection::Object &objectdef,
+                             uoffset_t tableloc) {
+  auto visited_idx = tableloc / sizeof(uoffset_t);
+  if (visited_[visited_idx]) return;  // Table already visited.
+  visited_[visited_idx] = true;
+  auto table = reinterpret_cast<const Table *>(buf_.data() + tableloc);
+  auto vtableloc = static_cast<uoffset_t>(
+                     tableloc - ReadScalar<soffset_t>(buf_.data() + tableloc));
+  auto newtableloc = NewPos(tableloc);
+  auto newvtable = static_cast<soffset_t>(newtableloc - NewPos(vtableloc));
+  if (newvtable != static_cast<soffset_t>(tableloc - vtableloc))
+    WriteScalar(newbuf_.data() + newtableloc, newvtable);
+  // Early out: since all fields inside the table must point forwards in
+  // memory, if there are no edits past the table we can stop here.
+  if (tableloc >= starts_.back()) return;
+  auto fielddefs = objectdef.fields();
+  for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+    auto &fielddef = **it;
+    auto base_type = fielddef.type()->base_type();
+    // Ignore scalars.
+    if (base_type <= reflection::Double) continue;
+    // Ignore fields that are not stored.
+    auto offset = table->GetOptionalFieldOffset(fielddef.offset());
+    if (!offset) continue;
+    // Ignore structs.
+    auto subobjectdef = base_type == reflection::Obj ?
+      schema_.objects()->Get(fielddef.type()->index()) : nullptr;
+    if (subobjectdef && subobjectdef->is_struct()) continue;
+    auto offsetloc = tableloc + offset;
+    FixOffset(offsetloc);
+    auto ref = offsetloc + ReadScalar<uoffset_t>(buf_.data() + offsetloc);
+    switch (base_type) {
+      case reflection::Obj: {
+        FixTable(*subobjectdef, ref);
+        break;
+      }
+      case reflection::Vector: {
+        auto elem_type = fielddef.type()->element();
+        if (elem_type != reflection::Obj && elem_type != reflection::String)
+          break;
+        auto elemobjectdef = elem_type == reflection::Obj
+          ? schema_.objects()->Get(fielddef.type()->index())
+          : nullptr;
+        if (elemobjectdef && elemobjectdef->is_struct()) break;
+        auto size = ReadScalar<uoffset_t>(buf_.data() + ref);
+        auto data = ref + static_cast<uoffset_t>(sizeof(uoffset_t));
+        // Elements dropped by a resize of this vector may lie in bytes that
+        // are about to be removed, so leave them alone.
+        auto edit = FindEdit(data + size * static_cast<uoffset_t>(
+                                                           sizeof(uoffset_t)));
+        if (edit && edit->object == ref && edit->new_size < size)
+          size = edit->new_size;
+        for (uoffset_t i = 0; i < size; i++) {
+          auto loc = data + i * static_cast<uoffset_t>(sizeof(uoffset_t));
+          FixOffset(loc);
+          if (elemobjectdef)
+            FixTable(*elemobjectdef,
+                     loc + ReadScalar<uoffset_t>(buf_.data() + loc));
+        }
+        break;
+      }
+      case reflection::Union: {
+        FixTable(GetUnionType(schema_, objectdef, fielddef, *table), ref);
+        break;
+      }
+      case reflection::String:
+        break;
+      default:
+        assert(false);
+    }
+  }
+}
+
+void MutationBatch::Apply() {
+  if (edits_.empty()) return;
+  // Order edits by position. Edits of the same object share a start, and
+  // of those only the last one recorded is kept.
+  std::stable_sort(edits_.begin(), edits_.end(),
+                   [](const Edit &a, const Edit &b) {
+    return a.start < b.start;
+  });
+  size_t num_edits = 0;
+  for (size_t i = 0; i < edits_.size(); i++) {
+    if (num_edits && edits_[num_edits - 1].start == edits_[i].start) {
+      num_edits--;
+    }
+    if (num_edits != i) edits_[num_edits] = std::move(edits_[i]);
+    num_edits++;
+  }
+  edits_.resize(num_edits);
+  int64_t shift = 0;
+  for (auto it = edits_.begin(); it != edits_.end(); ++it) {
+    shift += it->delta;
+    starts_.push_back(it->start);
+    shifts_.push_back(shift);
+  }
+  // Build the resized buffer with a single copy. Shrinking removes bytes from
+  // the end of the old data, growing inserts zeroes there.
+  newbuf_.resize(static_cast<size_t>(buf_.size() + shift));
+  auto dst = newbuf_.data();
+  size_t src = 0;
+  for (auto it = edits_.begin(); it != edits_.end(); ++it) {
+    auto keep = static_cast<size_t>(it->start + std::min(it->delta, 0));
+    assert(keep >= src);
+    memcpy(dst, buf_.data() + src, keep - src);
+    dst += keep - src;
+    if (it->delta > 0) {
+      memset(dst, 0, it->delta);
+      dst += it->delta;
+    }
+    src = it->start;
+  }
+  memcpy(dst, buf_.data() + src, buf_.size() - src);
+  // Now change all the offsets in a single walk over the old buffer.
+  visited_.assign(buf_.size() / sizeof(uoffset_t) + 1, false);
+  FixOffset(0);
+  FixTable(root_table_ ? *root_table_ : *schema_.root_table(),
+           ReadScalar<uoffset_t>(buf_.data()));
+  // Finally, write the new sizes and contents.
+  for (auto it = edits_.begin(); it != edits_.end(); ++it) {
+    auto object = NewPos(it->object);
+    WriteScalar(newbuf_.data() + object, it->new_size);
+    auto data = newbuf_.data() + object + sizeof(uoffset_t);
+    // The old data (and string terminator) now ends at the moved start.
+    auto end = newbuf_.data() + NewPos(it->start) + (it->is_string ? 1 : 0);
+    auto used = it->is_string ? it->new_size
+                              : std::min(it->old_size, it->new_size) *
+                                it->elem_size;
+    // Clear what is left of the old data, since we don't want parts of it
+    // remaining.
+    memset(data + used, 0, end - data - used);
+    if (it->is_string) {
+      memcpy(data, it->data.c_str(), it->new_size);
+    } else if (!it->data.empty()) {
+      for (auto i = it->old_size; i < it->new_size; i++) {
+        memcpy(data + i * it->elem_size, it->data.data(), it->elem_size);
+      }
+    }
+  }
+  buf_.swap(newbuf_);
+  edits_.clear();
+  starts_.clear();
+  shifts_.clear();
+  newbuf_.clear();
+  visited_.clear();
+}
+
 const uint8_t *AddFlatBuffer(std::vector<uint8_t> &flatbuf,
                              const uint8_t *newbuf, size_t newlen) {
   // Align to sizeof(uoffset_t) past sizeof(largest_scalar_t) since we're
@@ -349,136 +568,2479 @@ const uint8_t *AddFlatBuffer(std::vector<uint8_t> &flatbuf,
   return flatbuf.data() + insertion_point + root_offset;
 }
 
-void CopyInline(FlatBufferBuilder &fbb, const reflection::Field &fielddef,
-                const Table &table, size_t align, size_t size) {
-  fbb.Align(align);
-  fbb.PushBytes(table.GetStruct<const uint8_t *>(fielddef.offset()), size);
-  fbb.TrackField(fielddef.offset(), fbb.GetSize());
+FieldMask::FieldMask(const reflection::Schema &schema,
+                     const reflection::Object &objectdef)
+  : schema_(schema) {
+  AddNode(objectdef);
 }
 
-Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
-                                const reflection::Schema &schema,
-                                const reflection::Object &objectdef,
-                                const Table &table,
-                                bool use_string_pooling) {
-  // Before we can construct the table, we have to first generate any
-  // subobjects, and collect their offsets.
-  std::vector<uoffset_t> offsets;
+size_t FieldMask::AddNode(const reflection::Object &objectdef) {
+  Node node;
+  node.objectdef = &objectdef;
+  size_t numfields = 0;
   auto fielddefs = objectdef.fields();
   for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
-    auto &fielddef = **it;
-    // Skip if field is not present in the source.
-    if (!table.CheckField(fielddef.offset())) continue;
-    uoffset_t offset = 0;
-    switch (fielddef.type()->base_type()) {
-      case reflection::String: {
-        offset = use_string_pooling
-                 ? fbb.CreateSharedString(GetFieldS(table, fielddef)).o
-                 : fbb.CreateString(GetFieldS(table, fielddef)).o;
-        break;
+    numfields = std::max(numfields, static_cast<size_t>(it->id()) + 1);
+  }
+  node.selected.resize((numfields + 63) / 64, 0);
+  node.children.resize(numfields, 0);
+  nodes_.push_back(node);
+  return nodes_.size() - 1;
+}
+
+void FieldMask::Select(size_t node, voffset_t id) {
+  nodes_[node].selected[id / 64] |= static_cast<uint64_t>(1) << (id % 64);
+}
+
+bool FieldMask::Add(const std::string &path) {
+  size_t node = 0;
+  size_t start = 0;
+  for (;;) {
+    auto end = path.find('.', start);
+    auto name = path.substr(start, end == std::string::npos
+                                   ? std::string::npos
+                                   : end - start);
+    auto fielddef = nodes_[node].objectdef->fields()->LookupByKey(
+                                                                name.c_str());
+    if (!fielddef) return false;
+    auto id = fielddef->id();
+    auto base_type = fielddef->type()->base_type();
+    auto element = fielddef->type()->element();
+    if (end == std::string::npos) {
+      // Selecting the whole field overrides any of its sub-fields.
+      Select(node, id);
+      nodes_[node].children[id] = 0;
+      if (base_type == reflection::Union ||
+          (base_type == reflection::Vector && element == reflection::Union)) {
+        Select(node, id - 1);  // The type field.
       }
+      return true;
+    }
+    auto subobjectdef =
+      base_type == reflection::Obj ||
+      (base_type == reflection::Vector && element == reflection::Obj)
+        ? schema_.objects()->Get(fielddef->type()->index())
+        : nullptr;
+    if (!subobjectdef || subobjectdef->is_struct()) return false;
+    auto child = nodes_[node].children[id];
+    if (!child) {
+      // Nothing to add if the whole field is already selected.
+      if (nodes_[node].IsSelected(id)) return true;
+      child = AddNode(*subobjectdef);
+      nodes_[node].children[id] = child;
+      Select(node, id);
+    }
+    node = child;
+    start = end + 1;
+  }
+}
+
+TableCopier::TableCopier(FlatBufferBuilder &fbb,
+                         const reflection::Schema &schema,
+                         bool use_string_pooling,
+                         const uint8_t *buf, size_t size)
+  : fbb_(fbb), schema_(schema), use_string_pooling_(use_string_pooling),
+    buf_(buf), size_(size), mask_(nullptr) {
+  Reset();
+}
+
+void TableCopier::Reset() {
+  copied_.assign(buf_ ? size_ / sizeof(uoffset_t) : 0, 0);
+  copied_map_.clear();
+}
+
+const TableCopier::ObjectPlan *TableCopier::GetPlan(
+                                        const reflection::Object &objectdef) {
+  assert(!objectdef.is_struct());
+  auto it = plans_.find(&objectdef);
+  if (it != plans_.end()) return &it->second;
+  // Insert the plan before filling it in, so recursive types find it.
+  auto &plan = plans_[&objectdef];
+  std::vector<FieldPlan> fields;
+  auto fielddefs = objectdef.fields();
+  for (auto fit = fielddefs->begin(); fit != fielddefs->end(); ++fit) {
+    auto &fielddef = **fit;
+    FieldPlan field;
+    field.id = fielddef.id();
+    field.offset = fielddef.offset();
+    field.base_type = fielddef.type()->base_type();
+    field.element = fielddef.type()->element();
+    field.size = GetTypeSize(field.base_type);
+    field.align = field.size;
+    field.is_offset = field.base_type > reflection::Double;
+    field.elem_size = GetTypeSize(field.element);
+    field.elem_align = field.elem_size;
+    field.object = nullptr;
+    field.union_types = nullptr;
+    auto index = fielddef.type()->index();
+    switch (field.base_type) {
       case reflection::Obj: {
-        auto &subobjectdef = *schema.objects()->Get(fielddef.type()->index());
-        if (!subobjectdef.is_struct()) {
-          offset = CopyTable(fbb, schema, subobjectdef,
-                             *GetFieldT(table, fielddef)).o;
+        auto &subobjectdef = *schema_.objects()->Get(index);
+        if (subobjectdef.is_struct()) {
+          field.is_offset = false;
+          field.size = subobjectdef.bytesize();
+          field.align = subobjectdef.minalign();
+        } else {
+          field.object = GetPlan(subobjectdef);
         }
         break;
       }
-      case reflection::Union: {
-        auto &subobjectdef = GetUnionType(schema, objectdef, fielddef, table);
-        offset = CopyTable(fbb, schema, subobjectdef,
-                           *GetFieldT(table, fielddef)).o;
+      case reflection::Union:
+        field.union_types = GetUnionPlans(*schema_.enums()->Get(index));
         break;
-      }
-      case reflection::Vector: {
-        auto vec = table.GetPointer<const Vector<Offset<Table>> *>(
-                                                             fielddef.offset());
-        auto element_base_type = fielddef.type()->element();
-        auto elemobjectdef = element_base_type == reflection::Obj
-                             ? schema.objects()->Get(fielddef.type()->index())
-                             : nullptr;
-        switch (element_base_type) {
-          case reflection::String: {
-            std::vector<Offset<const String *>> elements(vec->size());
-            auto vec_s = reinterpret_cast<const Vector<Offset<String>> *>(vec);
-            for (uoffset_t i = 0; i < vec_s->size(); i++) {
-              elements[i] = use_string_pooling
-                            ? fbb.CreateSharedString(vec_s->Get(i)).o
-                            : fbb.CreateString(vec_s->Get(i)).o;
-            }
-            offset = fbb.CreateVector(elements).o;
-            break;
-          }
-          case reflection::Obj: {
-            if (!elemobjectdef->is_struct()) {
-              std::vector<Offset<const Table *>> elements(vec->size());
-              for (uoffset_t i = 0; i < vec->size(); i++) {
-                elements[i] =
-                  CopyTable(fbb, schema, *elemobjectdef, *vec->Get(i));
-              }
-              offset = fbb.CreateVector(elements).o;
-              break;
-            }
-            // FALL-THRU:
-          }
-          default: {  // Scalars and structs.
-            auto element_size = GetTypeSize(element_base_type);
-            if (elemobjectdef && elemobjectdef->is_struct())
-              element_size = elemobjectdef->bytesize();
-            fbb.StartVector(element_size, vec->size());
-            fbb.PushBytes(vec->Data(), element_size * vec->size());
-            offset = fbb.EndVector(vec->size());
-            break;
+      case reflection::Vector:
+        if (field.element == reflection::Union) {
+          field.union_types = GetUnionPlans(*schema_.enums()->Get(index));
+        } else if (field.element == reflection::Obj) {
+          auto &elemobjectdef = *schema_.objects()->Get(index);
+          if (elemobjectdef.is_struct()) {
+            field.elem_size = elemobjectdef.bytesize();
+            field.elem_align = elemobjectdef.minalign();
+          } else {
+            field.object = GetPlan(elemobjectdef);
           }
         }
         break;
+      default:
+        break;
+    }
+    fields.push_back(field);
+  }
+  // Add fields with the largest alignment first, so there is as little
+  // padding between them as possible.
+  std::stable_sort(fields.begin(), fields.end(),
+                   [](const FieldPlan &a, const FieldPlan &b) {
+    return a.align > b.align;
+  });
+  plan.fields.swap(fields);
+  plan.numfields = static_cast<voffset_t>(fielddefs->size());
+  return &plan;
+}
+
+const std::vector<const TableCopier::ObjectPlan *> *TableCopier::GetUnionPlans(
+                                             const reflection::Enum &enumdef) {
+  auto it = union_plans_.find(&enumdef);
+  if (it != union_plans_.end()) return &it->second;
+  auto &types = union_plans_[&enumdef];
+  std::vector<const ObjectPlan *> plans;
+  auto values = enumdef.values();
+  for (auto vit = values->begin(); vit != values->end(); ++vit) {
+    auto union_type = static_cast<size_t>(vit->value());
+    if (union_type >= plans.size()) plans.resize(union_type + 1, nullptr);
+    if (vit->object()) plans[union_type] = GetPlan(*vit->object());
+  }
+  types.swap(plans);
+  return &types;
+}
+
+// The offset of the copy of the object at "obj", or 0 if not copied yet.
+uoffset_t &TableCopier::Copied(const void *obj) {
+  if (!buf_) return copied_map_[obj];
+  // Tables, strings and vectors all start on a uoffset_t boundary.
+  auto idx = reinterpret_cast<const uoffset_t *>(obj) -
+             reinterpret_cast<const uoffset_t *>(buf_);
+  assert(idx >= 0 && static_cast<size_t>(idx) < copied_.size());
+  return copied_[idx];
+}
+
+Offset<const Table *> TableCopier::CopyTable(
+                  const reflection::Object &objectdef, const Table &table) {
+  if (objectdef.is_struct()) return 0;
+  return CopyObject(*GetPlan(objectdef), table, nullptr);
+}
+
+Offset<const Table *> TableCopier::CopyTable(
+                  const reflection::Object &objectdef, const Table &table,
+                  const FieldMask &mask) {
+  assert(&mask.object() == &objectdef);
+  if (objectdef.is_struct()) return 0;
+  mask_ = &mask;
+  auto offset = CopyObject(*GetPlan(objectdef), table, &mask.nodes_[0]);
+  mask_ = nullptr;
+  return offset;
+}
+
+uoffset_t TableCopier::CopyObject(const ObjectPlan &plan, const Table &table,
+                                  const FieldMask::Node *node) {
+  // Only whole copies can be shared.
+  uoffset_t unshared = 0;
+  auto &copied = node ? unshared : Copied(&table);
+  if (copied) return copied;
+  // Before we can construct the table, we have to first copy any
+  // subobjects, and collect their offsets.
+  auto mark = offsets_.size();
+  for (auto it = plan.fields.begin(); it != plan.fields.end(); ++it) {
+    if (!it->is_offset) continue;
+    if (node && !node->IsSelected(it->id)) continue;
+    auto ref = table.GetPointer<const uint8_t *>(it->offset);
+    if (!ref) continue;
+    auto child = node && node->children[it->id]
+                 ? &mask_->nodes_[node->children[it->id]]
+                 : nullptr;
+    offsets_.push_back(Offset<void>(CopyOffsetField(*it, table, ref, child)));
+  }
+  // Now we can build the actual table from either offsets or scalar data.
+  auto start = fbb_.StartTable();
+  auto offset_idx = mark;
+  for (auto it = plan.fields.begin(); it != plan.fields.end(); ++it) {
+    if (node && !node->IsSelected(it->id)) continue;
+    if (it->is_offset) {
+      if (!table.GetOptionalFieldOffset(it->offset)) continue;
+      auto offset = offsets_[offset_idx++];
+      if (offset.o) fbb_.AddOffset(it->offset, offset);
+    } else if (table.CheckField(it->offset)) {
+      fbb_.Align(it->align);
+      fbb_.PushBytes(table.GetStruct<const uint8_t *>(it->offset), it->size);
+      fbb_.TrackField(it->offset, fbb_.GetSize());
+    }
+  }
+  assert(offset_idx == offsets_.size());
+  offsets_.resize(mark);
+  copied = fbb_.EndTable(start, plan.numfields);
+  return copied;
+}
+
+uoffset_t TableCopier::CopyOffsetField(const FieldPlan &field,
+                                       const Table &table, const uint8_t *ref,
+                                       const FieldMask::Node *node) {
+  switch (field.base_type) {
+    case reflection::String:
+      return CopyString(*reinterpret_cast<const String *>(ref));
+    case reflection::Obj:
+      return CopyObject(*field.object, *reinterpret_cast<const Table *>(ref),
+                        node);
+    case reflection::Union: {
+      // The type is stored in the field right before the union.
+      auto union_type = table.GetField<uint8_t>(
+                     static_cast<voffset_t>(field.offset - sizeof(voffset_t)),
+                     0);
+      auto subplan = union_type < field.union_types->size()
+                     ? (*field.union_types)[union_type]
+                     : nullptr;
+      // Leave out values of types we don't know about.
+      return subplan
+             ? CopyObject(*subplan, *reinterpret_cast<const Table *>(ref),
+                          nullptr)
+             : 0;
+    }
+    case reflection::Vector:
+      return CopyVector(field, table,
+                        *reinterpret_cast<const VectorOfAny *>(ref), node);
+    default:
+      assert(false);
+      return 0;
+  }
+}
+
+uoffset_t TableCopier::CopyField(const reflection::Object &objectdef,
+                                 const reflection::Field &fielddef,
+                                 const Table &table) {
+  auto ref = table.GetPointer<const uint8_t *>(fielddef.offset());
+  if (!ref) return 0;
+  auto plan = GetPlan(objectdef);
+  for (auto it = plan->fields.begin(); it != plan->fields.end(); ++it) {
+    if (it->id == fielddef.id())
+      return CopyOffsetField(*it, table, ref, nullptr);
+  }
+  assert(false);
+  return 0;
+}
+
+uoffset_t TableCopier::CopyString(const String &str) {
+  auto &copied = Copied(&str);
+  if (!copied) {
+    copied = use_string_pooling_
+             ? fbb_.CreateSharedString(str.c_str(), str.size()).o
+             : fbb_.CreateString(str.c_str(), str.size()).o;
+  }
+  return copied;
+}
+
+uoffset_t TableCopier::CopyVector(const FieldPlan &field, const Table &table,
+                                  const VectorOfAny &vec,
+                                  const FieldMask::Node *node) {
+  uoffset_t unshared = 0;
+  auto &copied = node ? unshared : Copied(&vec);
+  if (copied) return copied;
+  auto mark = offsets_.size();
+  switch (field.element) {
+    case reflection::String:
+      for (uoffset_t i = 0; i < vec.size(); i++) {
+        offsets_.push_back(Offset<void>(CopyString(
+          *GetAnyVectorElemPointer<const String>(&vec, i))));
+      }
+      break;
+    case reflection::Union: {
+      auto types = table.GetPointer<const Vector<uint8_t> *>(
+                     static_cast<voffset_t>(field.offset - sizeof(voffset_t)));
+      assert(types && types->size() == vec.size());
+      for (uoffset_t i = 0; i < vec.size(); i++) {
+        auto union_type = types->Get(i);
+        auto subplan = union_type < field.union_types->size()
+                       ? (*field.union_types)[union_type]
+                       : nullptr;
+        assert(subplan);
+        offsets_.push_back(Offset<void>(CopyObject(
+          *subplan, *GetAnyVectorElemPointer<const Table>(&vec, i), nullptr)));
       }
-      default:  // Scalars.
+      break;
+    }
+    case reflection::Obj:
+      if (field.object) {
+        for (uoffset_t i = 0; i < vec.size(); i++) {
+          offsets_.push_back(Offset<void>(CopyObject(
+            *field.object, *GetAnyVectorElemPointer<const Table>(&vec, i),
+            node)));
+        }
         break;
+      }
+      // fall through
+    default: {  // Scalars and structs.
+      fbb_.StartVector(vec.size() * field.elem_size / field.elem_align,
+                       field.elem_align);
+      fbb_.PushBytes(vec.Data(), vec.size() * field.elem_size);
+      copied = fbb_.EndVector(vec.size());
+      return copied;
+    }
+  }
+  copied = fbb_.CreateVector(offsets_.data() + mark, vec.size()).o;
+  offsets_.resize(mark);
+  return copied;
+}
+
+Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
+                                const reflection::Schema &schema,
+                                const reflection::Object &objectdef,
+                                const Table &table,
+                                bool use_string_pooling) {
+  TableCopier copier(fbb, schema, use_string_pooling);
+  return copier.CopyTable(objectdef, table);
+}
+
+Offset<const Table *> ProjectTable(FlatBufferBuilder &fbb,
+                                   const reflection::Schema &schema,
+                                   const reflection::Object &objectdef,
+                                   const Table &table,
+                                   const FieldMask &mask) {
+  TableCopier copier(fbb, schema);
+  return copier.CopyTable(objectdef, table, mask);
+}
+
+// The schema's file identifier, if "buf" has it.
+static const char *FileIdentifierOf(const reflection::Schema &schema,
+                                    const uint8_t *buf) {
+  auto file_ident = schema.file_ident();
+  return file_ident && file_ident->size() &&
+         BufferHasIdentifier(buf, file_ident->c_str())
+         ? file_ident->c_str()
+         : nullptr;
+}
+
+size_t Compact(const reflection::Schema &schema,
+               std::vector<uint8_t> *flatbuf,
+               const reflection::Object *root_table) {
+  FlatBufferBuilder fbb(flatbuf->size());
+  TableCopier copier(fbb, schema, false, flatbuf->data(), flatbuf->size());
+  auto root = copier.CopyTable(root_table ? *root_table : *schema.root_table(),
+                               *GetAnyRoot(flatbuf->data()));
+  fbb.Finish(root, FileIdentifierOf(schema, flatbuf->data()));
+  if (fbb.GetSize() >= flatbuf->size()) return 0;
+  auto reclaimed = flatbuf->size() - fbb.GetSize();
+  flatbuf->assign(fbb.GetBufferPointer(),
+                  fbb.GetBufferPointer() + fbb.GetSize());
+  return reclaimed;
+}
+
+static const reflection::Object *UnionObject(const reflection::Schema &schema,
+                                             const reflection::Field &fielddef,
+                                             uint8_t union_type) {
+  auto enumdef = schema.enums()->Get(fielddef.type()->index());
+  auto enumval = enumdef->values()->LookupByKey(union_type);
+  return enumval ? enumval->object() : nullptr;
+}
+
+// The type field of a union (or vector of unions) is stored right before it.
+static voffset_t UnionTypeOffset(const reflection::Field &fielddef) {
+  return static_cast<voffset_t>(fielddef.offset() - sizeof(voffset_t));
+}
+
+static bool EqualStrings(const String &a, const String &b) {
+  return a.size() == b.size() && !memcmp(a.Data(), b.Data(), a.size());
+}
+
+static bool EqualTables(const reflection::Schema &schema,
+                        const reflection::Object &objectdef,
+                        const Table &a, const Table &b);
+
+// Compares element "i" of "a" with element "j" of "b", which are vectors
+// stored in field "fielddef" of tables "ta" and "tb".
+static bool EqualElements(const reflection::Schema &schema,
+                          const reflection::Field &fielddef,
+                          const Table &ta, const VectorOfAny &a, size_t i,
+                          const Table &tb, const VectorOfAny &b, size_t j) {
+  auto element = fielddef.type()->element();
+  switch (element) {
+    case reflection::String:
+      return EqualStrings(*GetAnyVectorElemPointer<const String>(&a, i),
+                          *GetAnyVectorElemPointer<const String>(&b, j));
+    case reflection::Union: {
+      auto types_a = ta.GetPointer<const Vector<uint8_t> *>(
+                                                   UnionTypeOffset(fielddef));
+      auto types_b = tb.GetPointer<const Vector<uint8_t> *>(
+                                                   UnionTypeOffset(fielddef));
+      if (types_a->Get(i) != types_b->Get(j)) return false;
+      auto objectdef = UnionObject(schema, fielddef, types_a->Get(i));
+      return objectdef &&
+             EqualTables(schema, *objectdef,
+                         *GetAnyVectorElemPointer<const Table>(&a, i),
+                         *GetAnyVectorElemPointer<const Table>(&b, j));
     }
-    if (offset) {
-      offsets.push_back(offset);
+    default: {
+      auto elemobjectdef = element == reflection::Obj
+                           ? schema.objects()->Get(fielddef.type()->index())
+                           : nullptr;
+      if (elemobjectdef && !elemobjectdef->is_struct()) {
+        return EqualTables(schema, *elemobjectdef,
+                           *GetAnyVectorElemPointer<const Table>(&a, i),
+                           *GetAnyVectorElemPointer<const Table>(&b, j));
+      }
+      auto size = GetTypeSizeInline(element, fielddef.type()->index(),
+                                    schema);
+      return !memcmp(a.Data() + i * size, b.Data() + j * size, size);
     }
   }
-  // Now we can build the actual table from either offsets or scalar data.
-  auto start = objectdef.is_struct()
-                 ? fbb.StartStruct(objectdef.minalign())
-                 : fbb.StartTable();
-  size_t offset_idx = 0;
+}
+
+static bool EqualFields(const reflection::Schema &schema,
+                        const reflection::Field &fielddef,
+                        const Table &a, const Table &b) {
+  auto base_type = fielddef.type()->base_type();
+  auto index = fielddef.type()->index();
+  auto subobjectdef = base_type == reflection::Obj
+                      ? schema.objects()->Get(index)
+                      : nullptr;
+  if (base_type <= reflection::Double ||
+      (subobjectdef && subobjectdef->is_struct())) {
+    auto pa = a.GetAddressOf(fielddef.offset());
+    auto pb = b.GetAddressOf(fielddef.offset());
+    if (!pa || !pb) return pa == pb;
+    return !memcmp(pa, pb, GetTypeSizeInline(base_type, index, schema));
+  }
+  auto ra = a.GetPointer<const uint8_t *>(fielddef.offset());
+  auto rb = b.GetPointer<const uint8_t *>(fielddef.offset());
+  if (!ra || !rb) return ra == rb;
+  switch (base_type) {
+    case reflection::String:
+      return EqualStrings(*reinterpret_cast<const String *>(ra),
+                          *reinterpret_cast<const String *>(rb));
+    case reflection::Obj:
+      return EqualTables(schema, *subobjectdef,
+                         *reinterpret_cast<const Table *>(ra),
+                         *reinterpret_cast<const Table *>(rb));
+    case reflection::Union: {
+      auto type_a = a.GetField<uint8_t>(UnionTypeOffset(fielddef), 0);
+      auto type_b = b.GetField<uint8_t>(UnionTypeOffset(fielddef), 0);
+      auto objectdef = UnionObject(schema, fielddef, type_a);
+      return type_a == type_b && objectdef &&
+             EqualTables(schema, *objectdef,
+                         *reinterpret_cast<const Table *>(ra),
+                         *reinterpret_cast<const Table *>(rb));
+    }
+    case reflection::Vector: {
+      auto &va = *reinterpret_cast<const VectorOfAny *>(ra);
+      auto &vb = *reinterpret_cast<const VectorOfAny *>(rb);
+      if (va.size() != vb.size()) return false;
+      for (uoffset_t i = 0; i < va.size(); i++) {
+        if (!EqualElements(schema, fielddef, a, va, i, b, vb, i))
+          return false;
+      }
+      return true;
+    }
+    default:
+      assert(false);
+      return false;
+  }
+}
+
+static bool EqualTables(const reflection::Schema &schema,
+                        const reflection::Object &objectdef,
+                        const Table &a, const Table &b) {
+  if (&a == &b) return true;
+  auto fielddefs = objectdef.fields();
   for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
-    auto &fielddef = **it;
-    if (!table.CheckField(fielddef.offset())) continue;
+    if (!EqualFields(schema, **it, a, b)) return false;
+  }
+  return true;
+}
+
+// Writes the changes between two tables of the same type as PatchTables.
+class DiffContext {
+ public:
+  DiffContext(const reflection::Schema &schema, FlatBufferBuilder &fbb)
+    : schema_(schema), fbb_(fbb) {}
+
+  // Returns 0 if the tables are equal.
+  Offset<reflection::PatchTable> DiffTable(
+      const reflection::Object &objectdef, const Table &from, const Table &to) {
+    if (&from == &to) return 0;
+    std::vector<Offset<reflection::PatchField>> fields;
+    auto fielddefs = objectdef.fields();
+    for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+      auto field = DiffField(**it, from, to);
+      if (field.o) fields.push_back(field);
+    }
+    if (fields.empty()) return 0;
+    return reflection::CreatePatchTable(
+             fbb_, fbb_.CreateVectorOfSortedTables(&fields));
+  }
+
+  void operator=(const DiffContext &dc);
+
+ private:
+  // A copy of "table" as a FlatBuffer of its own.
+  Offset<Vector<uint8_t>> Nested(const reflection::Object &objectdef,
+                                 const Table &table) {
+    FlatBufferBuilder nested;
+    nested.Finish(CopyTable(nested, schema_, objectdef, table));
+    return fbb_.CreateVector(nested.GetBufferPointer(), nested.GetSize());
+  }
+
+  Offset<reflection::PatchField> Set(voffset_t id,
+                                     Offset<Vector<uint8_t>> data,
+                                     uint8_t union_type = 0) {
+    return reflection::CreatePatchField(fbb_, id, reflection::PatchOp_Set,
+                                        data, union_type);
+  }
+
+  Offset<reflection::PatchField> DiffField(const reflection::Field &fielddef,
+                                           const Table &from,
+                                           const Table &to) {
+    auto id = fielddef.id();
     auto base_type = fielddef.type()->base_type();
+    auto index = fielddef.type()->index();
+    auto subobjectdef = base_type == reflection::Obj
+                        ? schema_.objects()->Get(index)
+                        : nullptr;
+    auto clear = [&]() {
+      return reflection::CreatePatchField(fbb_, id, reflection::PatchOp_Clear);
+    };
+    if (base_type <= reflection::Double ||
+        (subobjectdef && subobjectdef->is_struct())) {
+      auto pa = from.GetAddressOf(fielddef.offset());
+      auto pb = to.GetAddressOf(fielddef.offset());
+      if (!pb) return pa ? clear() : 0;
+      auto size = GetTypeSizeInline(base_type, index, schema_);
+      if (pa && !memcmp(pa, pb, size)) return 0;
+      return Set(id, fbb_.CreateVector(pb, size));
+    }
+    auto ra = from.GetPointer<const uint8_t *>(fielddef.offset());
+    auto rb = to.GetPointer<const uint8_t *>(fielddef.offset());
+    if (!rb) return ra ? clear() : 0;
     switch (base_type) {
-      case reflection::Obj: {
-        auto &subobjectdef = *schema.objects()->Get(fielddef.type()->index());
-        if (subobjectdef.is_struct()) {
-          CopyInline(fbb, fielddef, table, subobjectdef.minalign(),
-                     subobjectdef.bytesize());
-          break;
+      case reflection::String: {
+        auto &sb = *reinterpret_cast<const String *>(rb);
+        if (ra && EqualStrings(*reinterpret_cast<const String *>(ra), sb))
+          return 0;
+        return Set(id, fbb_.CreateVector(sb.Data(), sb.size()));
+      }
+      case reflection::Union: {
+        auto type_a = from.GetField<uint8_t>(UnionTypeOffset(fielddef), 0);
+        auto type_b = to.GetField<uint8_t>(UnionTypeOffset(fielddef), 0);
+        subobjectdef = UnionObject(schema_, fielddef, type_b);
+        assert(subobjectdef);
+        if (type_a != type_b) {
+          return Set(id, Nested(*subobjectdef,
+                                *reinterpret_cast<const Table *>(rb)),
+                     type_b);
         }
-        // else: FALL-THRU:
       }
-      case reflection::Union:
-      case reflection::String:
+      // fall through
+      case reflection::Obj: {
+        auto &tb = *reinterpret_cast<const Table *>(rb);
+        if (!ra) return Set(id, Nested(*subobjectdef, tb), 0);
+        auto patch = DiffTable(*subobjectdef,
+                               *reinterpret_cast<const Table *>(ra), tb);
+        if (!patch.o) return 0;
+        return reflection::CreatePatchField(fbb_, id,
+                                            reflection::PatchOp_Modify, 0, 0,
+                                            patch);
+      }
       case reflection::Vector:
-        fbb.AddOffset(fielddef.offset(), Offset<void>(offsets[offset_idx++]));
-        break;
-      default: { // Scalars.
-        auto size = GetTypeSize(base_type);
-        CopyInline(fbb, fielddef, table, size, size);
-        break;
+        return DiffVector(fielddef, from,
+                          reinterpret_cast<const VectorOfAny *>(ra), to,
+                          *reinterpret_cast<const VectorOfAny *>(rb));
+      default:
+        assert(false);
+        return 0;
+    }
+  }
+
+  Offset<reflection::PatchField> DiffVector(const reflection::Field &fielddef,
+                                            const Table &from,
+                                            const VectorOfAny *va,
+                                            const Table &to,
+                                            const VectorOfAny &vb) {
+    auto element = fielddef.type()->element();
+    auto index = fielddef.type()->index();
+    auto elemobjectdef = element == reflection::Obj
+                         ? schema_.objects()->Get(index)
+                         : nullptr;
+    auto is_tables = elemobjectdef && !elemobjectdef->is_struct();
+    size_t na = va ? va->size() : 0;
+    size_t nb = vb.size();
+    // Find the range of elements that changed, by skipping the elements that
+    // are the same at the start and at the end.
+    size_t prefix = 0;
+    while (prefix < na && prefix < nb &&
+           EqualElements(schema_, fielddef, from, *va, prefix,
+                         to, vb, prefix)) {
+      prefix++;
+    }
+    if (va && prefix == na && na == nb) return 0;
+    size_t suffix = 0;
+    while (suffix < na - prefix && suffix < nb - prefix &&
+           EqualElements(schema_, fielddef, from, *va, na - 1 - suffix,
+                         to, vb, nb - 1 - suffix)) {
+      suffix++;
+    }
+    if (is_tables && va && na == nb) {
+      // Same length: patch the tables that changed in place.
+      std::vector<Offset<reflection::PatchElement>> elements;
+      for (auto i = prefix; i < na - suffix; i++) {
+        auto patch = DiffTable(*elemobjectdef,
+                               *GetAnyVectorElemPointer<const Table>(va, i),
+                               *GetAnyVectorElemPointer<const Table>(&vb, i));
+        if (patch.o) {
+          elements.push_back(reflection::CreatePatchElement(
+            fbb_, static_cast<uoffset_t>(i), patch));
+        }
+      }
+      return reflection::CreatePatchField(fbb_, fielddef.id(),
+                                          reflection::PatchOp_Modify, 0, 0, 0,
+                                          0, fbb_.CreateVector(elements));
+    }
+    // Otherwise, replace the range in between.
+    Offset<Vector<uint8_t>> data = 0;
+    Offset<Vector<Offset<reflection::PatchValue>>> values = 0;
+    if (element == reflection::String || element == reflection::Union ||
+        is_tables) {
+      auto types = element == reflection::Union
+                   ? to.GetPointer<const Vector<uint8_t> *>(
+                                                     UnionTypeOffset(fielddef))
+                   : nullptr;
+      std::vector<Offset<reflection::PatchValue>> new_values;
+      for (auto i = prefix; i < nb - suffix; i++) {
+        if (element == reflection::String) {
+          auto &str = *GetAnyVectorElemPointer<const String>(&vb, i);
+          new_values.push_back(reflection::CreatePatchValue(
+            fbb_, fbb_.CreateVector(str.Data(), str.size())));
+        } else {
+          auto union_type = types ? types->Get(static_cast<uoffset_t>(i)) : 0;
+          auto objectdef = types
+                           ? UnionObject(schema_, fielddef, union_type)
+                           : elemobjectdef;
+          assert(objectdef);
+          new_values.push_back(reflection::CreatePatchValue(
+            fbb_, Nested(*objectdef,
+                         *GetAnyVectorElemPointer<const Table>(&vb, i)),
+            union_type));
+        }
+      }
+      values = fbb_.CreateVector(new_values);
+    } else {
+      auto size = GetTypeSizeInline(element, index, schema_);
+      data = fbb_.CreateVector(vb.Data() + prefix * size,
+                               (nb - suffix - prefix) * size);
+    }
+    auto splice = reflection::CreatePatchSplice(
+                    fbb_, static_cast<uoffset_t>(prefix),
+                    static_cast<uoffset_t>(na - suffix - prefix), data,
+                    values);
+    return reflection::CreatePatchField(fbb_, fielddef.id(),
+                                        reflection::PatchOp_Modify, 0, 0, 0,
+                                        fbb_.CreateVector(&splice, 1));
+  }
+
+  const reflection::Schema &schema_;
+  FlatBufferBuilder &fbb_;
+};
+
+void Diff(const reflection::Schema &schema, const uint8_t *from,
+          const uint8_t *to, FlatBufferBuilder *patchfbb,
+          const reflection::Object *root_table) {
+  DiffContext dc(schema, *patchfbb);
+  auto patch = dc.DiffTable(root_table ? *root_table : *schema.root_table(),
+                            *GetAnyRoot(from), *GetAnyRoot(to));
+  if (!patch.o) patch = reflection::CreatePatchTable(*patchfbb);
+  reflection::FinishPatchTableBuffer(*patchfbb, patch);
+}
+
+// A field of a table being built from parts of other tables, to add once
+// all subobjects have been built.
+struct NewField {
+  voffset_t offset;
+  size_t align;
+  size_t size;
+  const uint8_t *data;  // For scalars and structs.
+  uoffset_t ref;        // For everything else.
+};
+
+static uoffset_t BuildTable(FlatBufferBuilder &fbb,
+                            std::vector<NewField> *newfields,
+                            voffset_t numfields) {
+  // Add fields with the largest alignment first, like TableCopier.
+  std::stable_sort(newfields->begin(), newfields->end(),
+                   [](const NewField &a, const NewField &b) {
+    return a.align > b.align;
+  });
+  auto start = fbb.StartTable();
+  for (auto it = newfields->begin(); it != newfields->end(); ++it) {
+    if (it->data) {
+      fbb.Align(it->align);
+      fbb.PushBytes(it->data, it->size);
+      fbb.TrackField(it->offset, fbb.GetSize());
+    } else {
+      fbb.AddOffset(it->offset, Offset<void>(it->ref));
+    }
+  }
+  return fbb.EndTable(start, numfields);
+}
+
+// Copies element "i" of "vec", a vector of strings, tables or unions stored
+// in field "fielddef" of "table".
+static uoffset_t CopyElement(TableCopier &copier,
+                             const reflection::Schema &schema,
+                             const reflection::Field &fielddef,
+                             const Table &table, const VectorOfAny &vec,
+                             uoffset_t i) {
+  switch (fielddef.type()->element()) {
+    case reflection::String:
+      return copier.CopyString(*GetAnyVectorElemPointer<const String>(&vec, i));
+    case reflection::Union: {
+      auto types = table.GetPointer<const Vector<uint8_t> *>(
+                                                   UnionTypeOffset(fielddef));
+      return copier.CopyTable(*UnionObject(schema, fielddef, types->Get(i)),
+                              *GetAnyVectorElemPointer<const Table>(&vec, i)).o;
+    }
+    default:
+      return copier.CopyTable(*schema.objects()->Get(fielddef.type()->index()),
+                              *GetAnyVectorElemPointer<const Table>(&vec, i)).o;
+  }
+}
+
+// Builds tables from a table of the base FlatBuffer and a PatchTable.
+class PatchContext {
+ public:
+  PatchContext(const reflection::Schema &schema, FlatBufferBuilder &fbb)
+    : schema_(schema), fbb_(fbb), copier_(fbb, schema) {}
+
+  uoffset_t ApplyTable(const reflection::Object &objectdef, const Table &base,
+                       const reflection::PatchTable *patch) {
+    auto patchfields = patch->fields();
+    std::vector<NewField> newfields;
+    auto fielddefs = objectdef.fields();
+    for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+      auto &fielddef = **it;
+      auto patchfield = patchfields
+                        ? patchfields->LookupByKey(fielddef.id())
+                        : nullptr;
+      auto op = patchfield ? patchfield->op() : reflection::PatchOp_Modify;
+      if (op == reflection::PatchOp_Clear) continue;
+      auto base_type = fielddef.type()->base_type();
+      auto index = fielddef.type()->index();
+      auto subobjectdef = base_type == reflection::Obj
+                          ? schema_.objects()->Get(index)
+                          : nullptr;
+      NewField newfield = { fielddef.offset(), sizeof(uoffset_t), 0, nullptr,
+                            0 };
+      if (base_type <= reflection::Double ||
+          (subobjectdef && subobjectdef->is_struct())) {
+        newfield.data = patchfield ? patchfield->data()->Data()
+                                   : base.GetAddressOf(fielddef.offset());
+        if (!newfield.data) continue;
+        newfield.size = GetTypeSizeInline(base_type, index, schema_);
+        newfield.align = subobjectdef ? subobjectdef->minalign()
+                                      : newfield.size;
+      } else if (!patchfield) {
+        newfield.ref = copier_.CopyField(objectdef, fielddef, base);
+      } else if (op == reflection::PatchOp_Set) {
+        auto data = patchfield->data();
+        if (base_type == reflection::String) {
+          newfield.ref = fbb_.CreateString(
+                           reinterpret_cast<const char *>(data->Data()),
+                           data->size()).o;
+        } else {
+          if (base_type == reflection::Union) {
+            subobjectdef = UnionObject(schema_, fielddef,
+                                       patchfield->union_type());
+          }
+          newfield.ref = CopyNested(*subobjectdef, *data);
+        }
+      } else if (base_type == reflection::Vector) {
+        newfield.ref = ApplyVector(fielddef, base, *patchfield);
+      } else {
+        if (base_type == reflection::Union) {
+          subobjectdef = UnionObject(
+            schema_, fielddef,
+            base.GetField<uint8_t>(UnionTypeOffset(fielddef), 0));
+        }
+        newfield.ref = ApplyTable(*subobjectdef, *GetFieldT(base, fielddef),
+                                  patchfield->patch());
       }
+      if (newfield.data || newfield.ref) newfields.push_back(newfield);
     }
+    return BuildTable(fbb_, &newfields,
+                      static_cast<voffset_t>(fielddefs->size()));
   }
-  assert(offset_idx == offsets.size());
-  if (objectdef.is_struct()) {
-    fbb.ClearOffsets();
-    return fbb.EndStruct();
-  } else {
-    return fbb.EndTable(start, static_cast<voffset_t>(fielddefs->size()));
+
+  void operator=(const PatchContext &pc);
+
+ private:
+  // Copies the root table of a nested FlatBuffer.
+  uoffset_t CopyNested(const reflection::Object &objectdef,
+                       const Vector<uint8_t> &data) {
+    auto buf = data.Data();
+    // Nested FlatBuffers inside a vector of bytes are not necessarily
+    // aligned.
+    std::vector<largest_scalar_t> aligned;
+    if (reinterpret_cast<size_t>(buf) % sizeof(largest_scalar_t)) {
+      aligned.resize(data.size() / sizeof(largest_scalar_t) + 1);
+      memcpy(aligned.data(), buf, data.size());
+      buf = reinterpret_cast<const uint8_t *>(aligned.data());
+    }
+    return CopyTable(fbb_, schema_, objectdef, *GetAnyRoot(buf)).o;
   }
+
+  uoffset_t ApplyVector(const reflection::Field &fielddef, const Table &base,
+                        const reflection::PatchField &patchfield) {
+    auto vec = base.GetPointer<const VectorOfAny *>(fielddef.offset());
+    size_t size = vec ? vec->size() : 0;
+    auto splices = patchfield.splices();
+    auto element = fielddef.type()->element();
+    auto index = fielddef.type()->index();
+    auto elemobjectdef = element == reflection::Obj
+                         ? schema_.objects()->Get(index)
+                         : nullptr;
+    if (element != reflection::String && element != reflection::Union &&
+        !(elemobjectdef && !elemobjectdef->is_struct())) {
+      // Scalars and structs: copy the runs of bytes between the splices.
+      auto elem_size = GetTypeSizeInline(element, index, schema_);
+      auto elem_align = elemobjectdef ? elemobjectdef->minalign() : elem_size;
+      auto data = vec ? vec->Data() : nullptr;
+      std::vector<uint8_t> bytes;
+      size_t i = 0;
+      if (splices) {
+        for (auto it = splices->begin(); it != splices->end(); ++it) {
+          auto start = std::min<size_t>(it->start(), size);
+          bytes.insert(bytes.end(), data + i * elem_size,
+                       data + start * elem_size);
+          if (it->data())
+            bytes.insert(bytes.end(), it->data()->begin(), it->data()->end());
+          i = std::min<size_t>(start + it->remove(), size);
+        }
+      }
+      if (i < size) {
+        bytes.insert(bytes.end(), data + i * elem_size,
+                     data + size * elem_size);
+      }
+      auto len = bytes.size() / elem_size;
+      fbb_.StartVector(len * elem_size / elem_align, elem_align);
+      fbb_.PushBytes(bytes.data(), bytes.size());
+      return fbb_.EndVector(len);
+    }
+    auto types = element == reflection::Union
+                 ? base.GetPointer<const Vector<uint8_t> *>(
+                                                     UnionTypeOffset(fielddef))
+                 : nullptr;
+    auto elements = patchfield.elements();
+    std::vector<Offset<void>> offsets;
+    size_t i = 0, splice_idx = 0, element_idx = 0;
+    for (;;) {
+      if (splices && splice_idx < splices->size() &&
+          splices->Get(static_cast<uoffset_t>(splice_idx))->start() == i) {
+        auto splice = splices->Get(static_cast<uoffset_t>(splice_idx++));
+        auto values = splice->values();
+        if (values) {
+          for (auto it = values->begin(); it != values->end(); ++it) {
+            auto data = it->data();
+            if (element == reflection::String) {
+              offsets.push_back(fbb_.CreateString(
+                reinterpret_cast<const char *>(data->Data()),
+                data->size()).Union());
+            } else {
+              auto objectdef = types
+                               ? UnionObject(schema_, fielddef,
+                                             it->union_type())
+                               : elemobjectdef;
+              offsets.push_back(Offset<void>(CopyNested(*objectdef, *data)));
+            }
+          }
+        }
+        i += splice->remove();
+        continue;
+      }
+      if (i >= size) break;
+      auto ui = static_cast<uoffset_t>(i);
+      while (elements && element_idx < elements->size() &&
+             elements->Get(static_cast<uoffset_t>(element_idx))->index() < ui) {
+        element_idx++;
+      }
+      auto elem = elements && element_idx < elements->size()
+                  ? elements->Get(static_cast<uoffset_t>(element_idx))
+                  : nullptr;
+      if (elem && elem->index() == ui) {
+        auto objectdef = types
+                         ? UnionObject(schema_, fielddef, types->Get(ui))
+                         : elemobjectdef;
+        offsets.push_back(Offset<void>(ApplyTable(
+          *objectdef, *GetAnyVectorElemPointer<const Table>(vec, ui),
+          elem->patch())));
+      } else {
+        offsets.push_back(Offset<void>(
+          CopyElement(copier_, schema_, fielddef, base, *vec, ui)));
+      }
+      i++;
+    }
+    return fbb_.CreateVector(offsets).o;
+  }
+
+  const reflection::Schema &schema_;
+  FlatBufferBuilder &fbb_;
+  TableCopier copier_;
+};
+
+void ApplyPatch(const reflection::Schema &schema, const uint8_t *base,
+                const uint8_t *patch, FlatBufferBuilder *fbb,
+                const reflection::Object *root_table) {
+  PatchContext pc(schema, *fbb);
+  auto root = pc.ApplyTable(root_table ? *root_table : *schema.root_table(),
+                            *GetAnyRoot(base),
+                            reflection::GetPatchTable(patch));
+  fbb->Finish(Offset<Table>(root), FileIdentifierOf(schema, base));
+}
+
+// Builds tables that have the fields of an overlay table where it has them,
+// and those of a base table elsewhere.
+class MergeContext {
+ public:
+  MergeContext(FlatBufferBuilder &fbb, const reflection::Schema &schema,
+               MergePolicy policy)
+    : schema_(schema), fbb_(fbb), policy_(policy), copier_(fbb, schema) {}
+
+  uoffset_t MergeTables(const reflection::Object &objectdef,
+                        const Table &base, const Table &overlay) {
+    std::vector<NewField> newfields;
+    auto fielddefs = objectdef.fields();
+    for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+      auto &fielddef = **it;
+      auto base_type = fielddef.type()->base_type();
+      auto index = fielddef.type()->index();
+      auto subobjectdef = base_type == reflection::Obj
+                          ? schema_.objects()->Get(index)
+                          : nullptr;
+      NewField newfield = { fielddef.offset(), sizeof(uoffset_t), 0, nullptr,
+                            0 };
+      if (base_type <= reflection::Double ||
+          (subobjectdef && subobjectdef->is_struct())) {
+        newfield.data = overlay.GetAddressOf(fielddef.offset());
+        if (!newfield.data) {
+          newfield.data = base.GetAddressOf(fielddef.offset());
+        }
+        if (!newfield.data) continue;
+        newfield.size = GetTypeSizeInline(base_type, index, schema_);
+        newfield.align = subobjectdef ? subobjectdef->minalign()
+                                      : newfield.size;
+        newfields.push_back(newfield);
+        continue;
+      }
+      auto rb = base.GetPointer<const uint8_t *>(fielddef.offset());
+      auto ro = overlay.GetPointer<const uint8_t *>(fielddef.offset());
+      if (!ro || !rb) {
+        newfield.ref = copier_.CopyField(objectdef, fielddef,
+                                         ro ? overlay : base);
+      } else if (base_type == reflection::Vector) {
+        newfield.ref = policy_ == kMergeConcatVectors
+                       ? ConcatVectors(fielddef, base, overlay)
+                       : copier_.CopyField(objectdef, fielddef, overlay);
+      } else if (base_type == reflection::Union) {
+        auto type = base.GetField<uint8_t>(UnionTypeOffset(fielddef), 0);
+        newfield.ref =
+          type == overlay.GetField<uint8_t>(UnionTypeOffset(fielddef), 0)
+          ? MergeTables(*UnionObject(schema_, fielddef, type),
+                        *reinterpret_cast<const Table *>(rb),
+                        *reinterpret_cast<const Table *>(ro))
+          : copier_.CopyField(objectdef, fielddef, overlay);
+      } else if (base_type == reflection::Obj) {
+        newfield.ref = MergeTables(*subobjectdef,
+                                   *reinterpret_cast<const Table *>(rb),
+                                   *reinterpret_cast<const Table *>(ro));
+      } else {
+        newfield.ref = copier_.CopyField(objectdef, fielddef, overlay);
+      }
+      if (newfield.ref) newfields.push_back(newfield);
+    }
+    return BuildTable(fbb_, &newfields,
+                      static_cast<voffset_t>(fielddefs->size()));
+  }
+
+  void operator=(const MergeContext &mc);
+
+ private:
+  // The elements of the base vector followed by those of the overlay.
+  uoffset_t ConcatVectors(const reflection::Field &fielddef,
+                          const Table &base, const Table &overlay) {
+    auto &vb = *base.GetPointer<const VectorOfAny *>(fielddef.offset());
+    auto &vo = *overlay.GetPointer<const VectorOfAny *>(fielddef.offset());
+    auto element = fielddef.type()->element();
+    auto index = fielddef.type()->index();
+    auto elemobjectdef = element == reflection::Obj
+                         ? schema_.objects()->Get(index)
+                         : nullptr;
+    if (element != reflection::String && element != reflection::Union &&
+        !(elemobjectdef && !elemobjectdef->is_struct())) {
+      auto elem_size = GetTypeSizeInline(element, index, schema_);
+      auto elem_align = elemobjectdef ? elemobjectdef->minalign() : elem_size;
+      auto len = vb.size() + vo.size();
+      fbb_.StartVector(len * elem_size / elem_align, elem_align);
+      // The builder grows downwards, so the last bytes go in first.
+      fbb_.PushBytes(vo.Data(), vo.size() * elem_size);
+      fbb_.PushBytes(vb.Data(), vb.size() * elem_size);
+      return fbb_.EndVector(len);
+    }
+    std::vector<Offset<void>> offsets;
+    offsets.reserve(vb.size() + vo.size());
+    for (uoffset_t i = 0; i < vb.size(); i++) {
+      offsets.push_back(Offset<void>(
+        CopyElement(copier_, schema_, fielddef, base, vb, i)));
+    }
+    for (uoffset_t i = 0; i < vo.size(); i++) {
+      offsets.push_back(Offset<void>(
+        CopyElement(copier_, schema_, fielddef, overlay, vo, i)));
+    }
+    return fbb_.CreateVector(offsets).o;
+  }
+
+  const reflection::Schema &schema_;
+  FlatBufferBuilder &fbb_;
+  MergePolicy policy_;
+  TableCopier copier_;
+};
+
+Offset<const Table *> Merge(FlatBufferBuilder &fbb,
+                            const reflection::Schema &schema,
+                            const reflection::Object &objectdef,
+                            const Table &base, const Table &overlay,
+                            MergePolicy policy) {
+  MergeContext mc(fbb, schema, policy);
+  return mc.MergeTables(objectdef, base, overlay);
+}
+
+template<typename T> static int64_t ReadI(const uint8_t *p) {
+  return static_cast<int64_t>(ReadScalar<T>(p));
+}
+template<typename T> static double ReadF(const uint8_t *p) {
+  return static_cast<double>(ReadScalar<T>(p));
+}
+static int64_t ReadNoneI(const uint8_t *) { return 0; }
+static double ReadNoneF(const uint8_t *) { return 0; }
+
+template<typename T> static void SetReaders(CompiledField *field) {
+  field->read_i = ReadI<T>;
+  field->read_f = ReadF<T>;
+}
+
+CompiledSchema::CompiledSchema(const reflection::Schema &schema)
+    : schema_(schema) {
+  auto objects = schema.objects();
+  for (auto it = objects->begin(); it != objects->end(); ++it) {
+    auto fielddefs = it->fields();
+    auto &fields = fields_[*it];
+    fields.resize(fielddefs->size());
+    for (auto fit = fielddefs->begin(); fit != fielddefs->end(); ++fit) {
+      auto &field = fields[fit->id()];
+      auto base_type = fit->type()->base_type();
+      field.fielddef = *fit;
+      field.objectdef = base_type == reflection::Obj
+                        ? objects->Get(fit->type()->index())
+                        : nullptr;
+      if (base_type == reflection::Float || base_type == reflection::Double) {
+        field.default_i = static_cast<int64_t>(fit->default_real());
+        field.default_f = fit->default_real();
+      } else {
+        field.default_i = fit->default_integer();
+        field.default_f = base_type == reflection::ULong
+          ? static_cast<double>(static_cast<uint64_t>(fit->default_integer()))
+          : static_cast<double>(fit->default_integer());
+      }
+      switch (base_type) {
+        case reflection::UType:
+        case reflection::Bool:
+        case reflection::UByte:  SetReaders<uint8_t>(&field); break;
+        case reflection::Byte:   SetReaders<int8_t>(&field); break;
+        case reflection::Short:  SetReaders<int16_t>(&field); break;
+        case reflection::UShort: SetReaders<uint16_t>(&field); break;
+        case reflection::Int:    SetReaders<int32_t>(&field); break;
+        case reflection::UInt:   SetReaders<uint32_t>(&field); break;
+        case reflection::Long:   SetReaders<int64_t>(&field); break;
+        case reflection::ULong:  SetReaders<uint64_t>(&field); break;
+        case reflection::Float:  SetReaders<float>(&field); break;
+        case reflection::Double: SetReaders<double>(&field); break;
+        default:
+          field.read_i = ReadNoneI;
+          field.read_f = ReadNoneF;
+          break;
+      }
+    }
+  }
+}
+
+bool CompiledSchema::Compile(const reflection::Object &objectdef,
+                             const std::string &path,
+                             CompiledPath *compiled) const {
+  CompiledPath result;
+  auto objdef = &objectdef;
+  auto in_struct = false;
+  size_t start = 0;
+  for (;;) {
+    auto end = path.find('.', start);
+    auto name = path.substr(start, end == std::string::npos
+                                   ? std::string::npos
+                                   : end - start);
+    auto fielddef = objdef->fields()->LookupByKey(name.c_str());
+    if (!fielddef) return false;
+    if (in_struct) {
+      result.struct_offset_ += fielddef->offset();
+    } else {
+      result.offset_ = fielddef->offset();
+    }
+    result.field_ = &fields_.find(objdef)->second[fielddef->id()];
+    if (end == std::string::npos) break;
+    // Only tables and structs have fields to go into.
+    objdef = result.field_->objectdef;
+    if (!objdef) return false;
+    if (objdef->is_struct()) {
+      in_struct = true;
+    } else {
+      result.tables_.push_back(result.offset_);
+    }
+    start = end + 1;
+  }
+  *compiled = result;
+  return true;
+}
+
+bool CompiledSchema::Compile(const std::string &object_name,
+                             const std::string &path,
+                             CompiledPath *compiled) const {
+  auto objectdef = schema_.objects()->LookupByKey(object_name.c_str());
+  return objectdef && Compile(*objectdef, path, compiled);
+}
+
+DynamicBuilder::DynamicBuilder(FlatBufferBuilder &fbb,
+                               const reflection::Schema &schema)
+    : fbb_(fbb), schema_(schema) {
+  auto objects = schema.objects();
+  fields_.resize(objects->size());
+  sortbysize_.resize(objects->size());
+  for (uoffset_t i = 0; i < objects->size(); i++) {
+    auto objectdef = objects->Get(i);
+    auto fielddefs = objectdef->fields();
+    fields_[i].resize(fielddefs->size());
+    for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+      fields_[i][it->id()] = *it;
+    }
+    auto attributes = objectdef->attributes();
+    sortbysize_[i] = !attributes ||
+                     !attributes->LookupByKey("original_order");
+  }
+}
+
+int DynamicBuilder::LookupObject(const char *name) const {
+  // Objects are sorted by name, like for LookupByKey, but we want the index.
+  auto objects = schema_.objects();
+  for (uoffset_t lo = 0, hi = objects->size(); lo < hi; ) {
+    auto mid = lo + (hi - lo) / 2;
+    auto cmp = objects->Get(mid)->KeyCompareWithValue(name);
+    if (!cmp) return static_cast<int>(mid);
+    if (cmp < 0) lo = mid + 1; else hi = mid;
+  }
+  return -1;
+}
+
+DynamicBuilder::FieldHandle DynamicBuilder::LookupField(
+                                int object, const char *name) const {
+  FieldHandle field;
+  if (object < 0 || object >= static_cast<int>(fields_.size())) return field;
+  auto fielddef = schema_.objects()->Get(object)->fields()->LookupByKey(name);
+  if (!fielddef) return field;
+  field.object = object;
+  field.id = fielddef->id();
+  return field;
+}
+
+void DynamicBuilder::StartTable(int object) {
+  assert(object >= 0 && object < static_cast<int>(fields_.size()));
+  assert(!schema_.objects()->Get(object)->is_struct());
+  Frame frame = { object, pending_.size(), struct_data_.size() };
+  frames_.push_back(frame);
+}
+
+const reflection::Field *DynamicBuilder::StartField(FieldHandle field) const {
+  if (frames_.empty() || field.object != frames_.back().object) return nullptr;
+  auto fielddef = fields_[field.object][field.id];
+  if (fielddef->deprecated()) return nullptr;
+  for (auto i = frames_.back().pending_start; i < pending_.size(); i++) {
+    if (pending_[i].id == field.id) return nullptr;
+  }
+  return fielddef;
+}
+
+bool DynamicBuilder::AddOffset(FieldHandle field, reflection::BaseType type,
+                               uoffset_t ref) {
+  auto fielddef = StartField(field);
+  if (!fielddef || fielddef->type()->base_type() != type) return false;
+  Pending pending = { field.id, type, 0, 0, ref };
+  pending_.push_back(pending);
+  return true;
+}
+
+bool DynamicBuilder::AddString(FieldHandle field, const char *str,
+                               size_t len) {
+  // Check before writing anything.
+  auto fielddef = StartField(field);
+  if (!fielddef || fielddef->type()->base_type() != reflection::String)
+    return false;
+  return AddString(field, fbb_.CreateString(str, len));
+}
+
+bool DynamicBuilder::AddString(FieldHandle field, Offset<String> str) {
+  return AddOffset(field, reflection::String, str.o);
+}
+
+bool DynamicBuilder::AddStruct(FieldHandle field, const uint8_t *data) {
+  auto fielddef = StartField(field);
+  if (!fielddef || fielddef->type()->base_type() != reflection::Obj)
+    return false;
+  auto objectdef = schema_.objects()->Get(fielddef->type()->index());
+  if (!objectdef->is_struct()) return false;
+  Pending pending = { field.id, reflection::Obj, 0, 0,
+                      static_cast<uoffset_t>(struct_data_.size()) };
+  struct_data_.insert(struct_data_.end(), data,
+                      data + objectdef->bytesize());
+  pending_.push_back(pending);
+  return true;
+}
+
+bool DynamicBuilder::AddTable(FieldHandle field, TableRef table) {
+  auto fielddef = StartField(field);
+  if (!fielddef || fielddef->type()->base_type() != reflection::Obj ||
+      fielddef->type()->index() != table.object)
+    return false;
+  return AddOffset(field, reflection::Obj, table.offset);
+}
+
+bool DynamicBuilder::AddUnion(FieldHandle field, TableRef table) {
+  auto fielddef = StartField(field);
+  if (!fielddef || fielddef->type()->base_type() != reflection::Union ||
+      !table.IsValid())
+    return false;
+  auto objectdef = schema_.objects()->Get(table.object);
+  auto values = schema_.enums()->Get(fielddef->type()->index())->values();
+  for (auto it = values->begin(); it != values->end(); ++it) {
+    if (it->object() != objectdef) continue;
+    FieldHandle type_field = field;
+    type_field.id = static_cast<voffset_t>(field.id - 1);
+    if (!AddScalar(type_field, static_cast<uint8_t>(it->value())))
+      return false;
+    return AddOffset(field, reflection::Union, table.offset);
+  }
+  return false;
+}
+
+bool DynamicBuilder::AddVector(FieldHandle field, VectorRef vec) {
+  auto fielddef = StartField(field);
+  if (!fielddef || fielddef->type()->base_type() != reflection::Vector)
+    return false;
+  auto element = fielddef->type()->element();
+  if (vec.element == reflection::Obj) {
+    if (element != reflection::Obj ||
+        (vec.object >= 0 && vec.object != fielddef->type()->index()))
+      return false;
+  } else if (vec.element == reflection::String) {
+    if (element != reflection::String) return false;
+  } else if (!ScalarMatches(element, vec.element)) {
+    return false;
+  }
+  return AddOffset(field, reflection::Vector, vec.offset);
+}
+
+DynamicBuilder::VectorRef DynamicBuilder::CreateVectorOfStrings(
+                                          const std::vector<std::string> &v) {
+  VectorRef ref;
+  ref.offset = fbb_.CreateVectorOfStrings(v).o;
+  ref.element = reflection::String;
+  return ref;
+}
+
+DynamicBuilder::VectorRef DynamicBuilder::CreateVectorOfStructs(
+                              int object, const uint8_t *data, size_t len) {
+  VectorRef ref;
+  auto objectdef = schema_.objects()->Get(object);
+  if (!objectdef->is_struct()) return ref;
+  auto size = static_cast<size_t>(objectdef->bytesize());
+  auto align = static_cast<size_t>(objectdef->minalign());
+  // Same as FlatBufferBuilder::CreateVectorOfStructs.
+  fbb_.StartVector(len * size / align, align);
+  fbb_.PushBytes(data, len * size);
+  ref.offset = fbb_.EndVector(len);
+  ref.element = reflection::Obj;
+  ref.object = object;
+  return ref;
+}
+
+DynamicBuilder::VectorRef DynamicBuilder::CreateVectorOfTables(
+                                    const TableRef *tables, size_t len) {
+  VectorRef ref;
+  for (size_t i = 0; i < len; i++) {
+    if (!tables[i].IsValid() || tables[i].object != tables[0].object)
+      return ref;
+  }
+  fbb_.StartVector(len, sizeof(Offset<void>));
+  for (auto i = len; i > 0; ) {
+    fbb_.PushElement(Offset<void>(tables[--i].offset));
+  }
+  ref.offset = fbb_.EndVector(len);
+  ref.element = reflection::Obj;
+  ref.object = len ? tables[0].object : -1;
+  return ref;
+}
+
+DynamicBuilder::TableRef DynamicBuilder::EndTable() {
+  assert(!frames_.empty());
+  auto frame = frames_.back();
+  frames_.pop_back();
+  auto &fields = fields_[frame.object];
+  auto begin = pending_.begin() + frame.pending_start;
+  auto end = pending_.end();
+  TableRef ref;
+  for (auto it = fields.begin(); it != fields.end(); ++it) {
+    auto fielddef = *it;
+    if (!fielddef->required() || fielddef->deprecated()) continue;
+    bool found = false;
+    for (auto pit = begin; pit != end && !found; ++pit) {
+      found = pit->id == fielddef->id();
+    }
+    if (!found) {
+      pending_.resize(frame.pending_start);
+      struct_data_.resize(frame.struct_data_start);
+      return ref;
+    }
+  }
+  // Same order as generated Create functions: by decreasing size (unless
+  // original_order), then in reverse order of declaration.
+  auto sortbysize = sortbysize_[frame.object];
+  std::sort(begin, end, [sortbysize](const Pending &a, const Pending &b) {
+    if (sortbysize) {
+      auto size_a = GetTypeSize(a.type);
+      auto size_b = GetTypeSize(b.type);
+      if (size_a != size_b) return size_a > size_b;
+    }
+    return a.id > b.id;
+  });
+  auto start = fbb_.StartTable();
+  for (auto it = begin; it != end; ++it) {
+    auto fielddef = fields[it->id];
+    auto offset = fielddef->offset();
+    auto def = fielddef->default_integer();
+    switch (it->type) {
+      #define FLATBUFFERS_DYNAMIC_INT(ENUM, T) \
+        case reflection::ENUM: \
+          fbb_.AddElement<T>(offset, static_cast<T>(it->i), \
+                             static_cast<T>(def)); \
+          break;
+      FLATBUFFERS_DYNAMIC_INT(UType, uint8_t)
+      FLATBUFFERS_DYNAMIC_INT(Bool, uint8_t)
+      FLATBUFFERS_DYNAMIC_INT(UByte, uint8_t)
+      FLATBUFFERS_DYNAMIC_INT(Byte, int8_t)
+      FLATBUFFERS_DYNAMIC_INT(Short, int16_t)
+      FLATBUFFERS_DYNAMIC_INT(UShort, uint16_t)
+      FLATBUFFERS_DYNAMIC_INT(Int, int32_t)
+      FLATBUFFERS_DYNAMIC_INT(UInt, uint32_t)
+      FLATBUFFERS_DYNAMIC_INT(Long, int64_t)
+      FLATBUFFERS_DYNAMIC_INT(ULong, uint64_t)
+      #undef FLATBUFFERS_DYNAMIC_INT
+      case reflection::Float:
+        fbb_.AddElement<float>(offset, static_cast<float>(it->f),
+                               static_cast<float>(fielddef->default_real()));
+        break;
+      case reflection::Double:
+        fbb_.AddElement<double>(offset, it->f, fielddef->default_real());
+        break;
+      case reflection::Obj: {
+        auto objectdef = schema_.objects()->Get(fielddef->type()->index());
+        if (objectdef->is_struct()) {
+          fbb_.Align(objectdef->minalign());
+          fbb_.PushBytes(struct_data_.data() + it->ref,
+                         objectdef->bytesize());
+          fbb_.TrackField(offset, fbb_.GetSize());
+          break;
+        }
+      }
+      // fall through
+      default:
+        fbb_.AddOffset(offset, Offset<void>(it->ref));
+        break;
+    }
+  }
+  ref.offset = fbb_.EndTable(start, static_cast<voffset_t>(fields.size()));
+  ref.object = frame.object;
+  pending_.resize(frame.pending_start);
+  struct_data_.resize(frame.struct_data_start);
+  return ref;
+}
+
+typedef std::unordered_map<const reflection::Object *,
+                           std::vector<const reflection::Field *>>
+        FieldsByIdCache;
+
+// The fields of "objectdef" in id order, rather than sorted by name.
+static const std::vector<const reflection::Field *> &FieldsById(
+    FieldsByIdCache &cache, const reflection::Object &objectdef) {
+  auto &fields = cache[&objectdef];
+  auto fielddefs = objectdef.fields();
+  if (fields.size() != fielddefs->size()) {
+    fields.resize(fielddefs->size());
+    for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+      fields[it->id()] = *it;
+    }
+  }
+  return fields;
+}
+
+// Whether a scalar field stored at "data" holds its default value. Floats
+// are compared bitwise, so -0.0 is not mistaken for a default of 0.0.
+static bool IsDefault(const reflection::Field &fielddef, const uint8_t *data) {
+  switch (fielddef.type()->base_type()) {
+    case reflection::Float: {
+      auto value = ReadScalar<float>(data);
+      auto default_value = static_cast<float>(fielddef.default_real());
+      return !memcmp(&value, &default_value, sizeof(value));
+    }
+    case reflection::Double: {
+      auto value = ReadScalar<double>(data);
+      auto default_value = fielddef.default_real();
+      return !memcmp(&value, &default_value, sizeof(value));
+    }
+    default:
+      return GetAnyValueI(fielddef.type()->base_type(), data) ==
+             fielddef.default_integer();
+  }
+}
+
+// Whether the union type field "fielddef", stored at "data", is left out
+// along with its value, because the value is not set or of a type we don't
+// know about.
+static bool IsDanglingUnionType(const reflection::Schema &schema,
+                                const reflection::Field &fielddef,
+                                const Table &table, const uint8_t *data) {
+  return fielddef.type()->base_type() == reflection::UType &&
+         (!table.GetPointer<const uint8_t *>(
+            static_cast<voffset_t>(fielddef.offset() + sizeof(voffset_t))) ||
+          !UnionObject(schema, fielddef, ReadScalar<uint8_t>(data)));
+}
+
+// Copies the fields of a struct to "dst", which should be zeroed, so that
+// the padding in between stays zero.
+static void CanonicalStruct(const reflection::Schema &schema,
+                            const reflection::Object &objectdef,
+                            const uint8_t *src, uint8_t *dst) {
+  auto fielddefs = objectdef.fields();
+  for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+    auto offset = it->offset();
+    auto base_type = it->type()->base_type();
+    if (base_type == reflection::Obj) {
+      CanonicalStruct(schema, *schema.objects()->Get(it->type()->index()),
+                      src + offset, dst + offset);
+    } else {
+      memcpy(dst + offset, src + offset, GetTypeSize(base_type));
+    }
+  }
+}
+
+// Copies tables depth first, in field id order, without sharing anything.
+class CanonicalContext {
+ public:
+  CanonicalContext(const reflection::Schema &schema, FlatBufferBuilder &fbb)
+    : schema_(schema), fbb_(fbb) {}
+
+  uoffset_t CopyTable(const reflection::Object &objectdef,
+                      const Table &table) {
+    auto &fields = FieldsById(fields_, objectdef);
+    std::vector<NewField> newfields;
+    // Subobjects first, as they can't be built while building the table.
+    size_t struct_size = 0;
+    for (auto it = fields.begin(); it != fields.end(); ++it) {
+      auto &fielddef = **it;
+      auto base_type = fielddef.type()->base_type();
+      if (base_type <= reflection::Double) continue;
+      auto subobjectdef = base_type == reflection::Obj ? SubObject(fielddef)
+                                                       : nullptr;
+      if (subobjectdef && subobjectdef->is_struct()) {
+        if (table.GetAddressOf(fielddef.offset()))
+          struct_size += subobjectdef->bytesize();
+        continue;
+      }
+      auto ref = table.GetPointer<const uint8_t *>(fielddef.offset());
+      if (!ref) continue;
+      NewField newfield = { fielddef.offset(), sizeof(uoffset_t), 0, nullptr,
+                            CopyObject(fielddef, table, ref) };
+      if (newfield.ref) newfields.push_back(newfield);
+    }
+    // Then scalars and structs, the latter copied to scratch_ first.
+    auto scratch_start = scratch_.size();
+    scratch_.resize(scratch_start + struct_size);
+    auto scratch = scratch_.data() + scratch_start;
+    for (auto it = fields.begin(); it != fields.end(); ++it) {
+      auto &fielddef = **it;
+      auto base_type = fielddef.type()->base_type();
+      auto subobjectdef = base_type == reflection::Obj ? SubObject(fielddef)
+                                                       : nullptr;
+      if (base_type > reflection::Double &&
+          !(subobjectdef && subobjectdef->is_struct()))
+        continue;
+      auto data = table.GetAddressOf(fielddef.offset());
+      if (!data) continue;
+      NewField newfield = { fielddef.offset(), 0, 0, data, 0 };
+      if (subobjectdef) {
+        CanonicalStruct(schema_, *subobjectdef, data, scratch);
+        newfield.data = scratch;
+        newfield.size = subobjectdef->bytesize();
+        newfield.align = subobjectdef->minalign();
+        scratch += newfield.size;
+      } else {
+        if (IsDefault(fielddef, data) ||
+            IsDanglingUnionType(schema_, fielddef, table, data))
+          continue;
+        newfield.size = newfield.align = GetTypeSize(base_type);
+      }
+      newfields.push_back(newfield);
+    }
+    auto table_ref = BuildTable(fbb_, &newfields,
+                                static_cast<voffset_t>(fields.size()));
+    scratch_.resize(scratch_start);
+    return table_ref;
+  }
+
+  void operator=(const CanonicalContext &cc);
+
+ private:
+  const reflection::Object *SubObject(const reflection::Field &fielddef) {
+    return fielddef.type()->base_type() == reflection::Obj ||
+           fielddef.type()->element() == reflection::Obj
+           ? schema_.objects()->Get(fielddef.type()->index())
+           : nullptr;
+  }
+
+  uoffset_t CopyObject(const reflection::Field &fielddef, const Table &table,
+                       const uint8_t *ref) {
+    switch (fielddef.type()->base_type()) {
+      case reflection::String:
+        return fbb_.CreateString(reinterpret_cast<const String *>(ref)).o;
+      case reflection::Obj:
+        return CopyTable(*SubObject(fielddef),
+                         *reinterpret_cast<const Table *>(ref));
+      case reflection::Union: {
+        auto objectdef = UnionObject(
+          schema_, fielddef,
+          table.GetField<uint8_t>(UnionTypeOffset(fielddef), 0));
+        return objectdef ? CopyTable(*objectdef,
+                                     *reinterpret_cast<const Table *>(ref))
+                         : 0;
+      }
+      case reflection::Vector:
+        return CopyVector(fielddef, table,
+                          *reinterpret_cast<const VectorOfAny *>(ref));
+      default:
+        assert(false);
+        return 0;
+    }
+  }
+
+  uoffset_t CopyVector(const reflection::Field &fielddef, const Table &table,
+                       const VectorOfAny &vec) {
+    auto element = fielddef.type()->element();
+    auto elemobjectdef = SubObject(fielddef);
+    auto len = vec.size();
+    if (element == reflection::String || element == reflection::Union ||
+        (elemobjectdef && !elemobjectdef->is_struct())) {
+      auto types = element == reflection::Union
+                   ? table.GetPointer<const Vector<uint8_t> *>(
+                                                   UnionTypeOffset(fielddef))
+                   : nullptr;
+      std::vector<Offset<void>> offsets(len);
+      for (uoffset_t i = 0; i < len; i++) {
+        if (element == reflection::String) {
+          offsets[i] = fbb_.CreateString(
+            GetAnyVectorElemPointer<const String>(&vec, i)).Union();
+        } else {
+          auto objectdef = types
+                           ? UnionObject(schema_, fielddef, types->Get(i))
+                           : elemobjectdef;
+          offsets[i] = Offset<void>(CopyTable(
+            *objectdef, *GetAnyVectorElemPointer<const Table>(&vec, i)));
+        }
+      }
+      return fbb_.CreateVector(offsets).o;
+    }
+    auto elem_size = GetTypeSizeInline(element, fielddef.type()->index(),
+                                       schema_);
+    auto elem_align = elemobjectdef ? elemobjectdef->minalign() : elem_size;
+    auto data = vec.Data();
+    auto scratch_start = scratch_.size();
+    if (elemobjectdef) {
+      scratch_.resize(scratch_start + len * elem_size);
+      for (uoffset_t i = 0; i < len; i++) {
+        CanonicalStruct(schema_, *elemobjectdef, data + i * elem_size,
+                        scratch_.data() + scratch_start + i * elem_size);
+      }
+      data = scratch_.data() + scratch_start;
+    }
+    fbb_.StartVector(len * elem_size / elem_align, elem_align);
+    fbb_.PushBytes(data, len * elem_size);
+    scratch_.resize(scratch_start);
+    return fbb_.EndVector(len);
+  }
+
+  const reflection::Schema &schema_;
+  FlatBufferBuilder &fbb_;
+  FieldsByIdCache fields_;
+  // Canonical copies of structs, always zeroed past the end.
+  std::vector<uint8_t> scratch_;
+};
+
+void Canonicalize(const reflection::Schema &schema, const uint8_t *buf,
+                  FlatBufferBuilder *fbb,
+                  const reflection::Object *root_table) {
+  assert(!fbb->GetSize());
+  fbb->DedupVtables(true);
+  CanonicalContext cc(schema, *fbb);
+  auto root = cc.CopyTable(root_table ? *root_table : *schema.root_table(),
+                           *GetAnyRoot(buf));
+  fbb->Finish(Offset<Table>(root), FileIdentifierOf(schema, buf));
+}
+
+static const uint64_t kHashPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t kHashPrime3 = 0x165667B19E3779F9ULL;
+static const uint64_t kHashPrime4 = 0x85EBCA77C2B2AE63ULL;
+// Ends tables, can't be confused with a field tag.
+static const uint64_t kHashEndOfTable = ~0ULL;
+
+static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// Murmur3's finalizer.
+static uint64_t HashMix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  return h ^ (h >> 33);
+}
+
+// Reads "size" little endian bytes.
+static uint64_t LoadLittleEndian(const uint8_t *data, size_t size) {
+  uint64_t word = 0;
+  for (size_t i = 0; i < size; i++) {
+    word |= static_cast<uint64_t>(data[i]) << (i * 8);
+  }
+  return word;
+}
+
+ContentHash TableHasher::Hash(const reflection::Object &objectdef,
+                              const Table &table) {
+  a_ = kHashPrime1;
+  b_ = kHashPrime3;
+  AddTable(objectdef, table);
+  ContentHash hash = { HashMix(a_ ^ Rotl(b_, 29)),
+                       HashMix(b_ + a_ * kHashPrime2) };
+  return hash;
+}
+
+void TableHasher::AddWord(uint64_t word) {
+  // Two lanes that mix each word differently, for 128 bits.
+  a_ = Rotl(a_ ^ (word * kHashPrime2), 31) * kHashPrime1;
+  b_ = Rotl(b_ + (word * kHashPrime4), 27) * kHashPrime3 + kHashPrime2;
+}
+
+void TableHasher::AddBytes(const uint8_t *data, size_t len) {
+  AddWord(len);
+  for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {
+    AddWord(LoadLittleEndian(data, sizeof(uint64_t)));
+    data += sizeof(uint64_t);
+  }
+  if (len) AddWord(LoadLittleEndian(data, len));
+}
+
+void TableHasher::AddStruct(const reflection::Object &objectdef,
+                            const uint8_t *data) {
+  // Field by field, so padding doesn't matter.
+  auto fielddefs = objectdef.fields();
+  for (auto it = fielddefs->begin(); it != fielddefs->end(); ++it) {
+    auto base_type = it->type()->base_type();
+    if (base_type == reflection::Obj) {
+      AddStruct(*schema_.objects()->Get(it->type()->index()),
+                data + it->offset());
+    } else {
+      AddWord(LoadLittleEndian(data + it->offset(), GetTypeSize(base_type)));
+    }
+  }
+}
+
+void TableHasher::AddElement(const reflection::Field &fielddef,
+                             const Table &table, const VectorOfAny &vec,
+                             uoffset_t i) {
+  switch (fielddef.type()->element()) {
+    case reflection::String: {
+      auto str = GetAnyVectorElemPointer<const String>(&vec, i);
+      AddBytes(str->Data(), str->size());
+      break;
+    }
+    case reflection::Union: {
+      auto types = table.GetPointer<const Vector<uint8_t> *>(
+                                                   UnionTypeOffset(fielddef));
+      auto objectdef = UnionObject(schema_, fielddef, types->Get(i));
+      if (objectdef) {
+        AddTable(*objectdef, *GetAnyVectorElemPointer<const Table>(&vec, i));
+      }
+      break;
+    }
+    default:
+      AddTable(*schema_.objects()->Get(fielddef.type()->index()),
+               *GetAnyVectorElemPointer<const Table>(&vec, i));
+      break;
+  }
+}
+
+void TableHasher::AddTable(const reflection::Object &objectdef,
+                           const Table &table) {
+  auto &fields = FieldsById(fields_, objectdef);
+  for (auto it = fields.begin(); it != fields.end(); ++it) {
+    auto &fielddef = **it;
+    auto base_type = fielddef.type()->base_type();
+    auto index = fielddef.type()->index();
+    auto subobjectdef = base_type == reflection::Obj
+                        ? schema_.objects()->Get(index)
+                        : nullptr;
+    auto tag = static_cast<uint64_t>(fielddef.id()) << 8 | base_type;
+    if (base_type <= reflection::Double) {
+      auto data = table.GetAddressOf(fielddef.offset());
+      if (!data || IsDefault(fielddef, data) ||
+          IsDanglingUnionType(schema_, fielddef, table, data))
+        continue;
+      AddWord(tag);
+      AddWord(LoadLittleEndian(data, GetTypeSize(base_type)));
+      continue;
+    }
+    if (subobjectdef && subobjectdef->is_struct()) {
+      auto data = table.GetAddressOf(fielddef.offset());
+      if (!data) continue;
+      AddWord(tag);
+      AddStruct(*subobjectdef, data);
+      continue;
+    }
+    auto ref = table.GetPointer<const uint8_t *>(fielddef.offset());
+    if (!ref) continue;
+    if (base_type == reflection::Union) {
+      subobjectdef = UnionObject(
+        schema_, fielddef,
+        table.GetField<uint8_t>(UnionTypeOffset(fielddef), 0));
+      // Canonicalize leaves out unions of unknown types too.
+      if (!subobjectdef) continue;
+    }
+    AddWord(tag);
+    switch (base_type) {
+      case reflection::String: {
+        auto str = reinterpret_cast<const String *>(ref);
+        AddBytes(str->Data(), str->size());
+        break;
+      }
+      case reflection::Obj:
+      case reflection::Union:
+        AddTable(*subobjectdef, *reinterpret_cast<const Table *>(ref));
+        break;
+      case reflection::Vector: {
+        auto &vec = *reinterpret_cast<const VectorOfAny *>(ref);
+        auto element = fielddef.type()->element();
+        auto elemobjectdef = element == reflection::Obj
+                             ? schema_.objects()->Get(index)
+                             : nullptr;
+        if (element <= reflection::Double) {
+          AddBytes(vec.Data(), vec.size() * GetTypeSize(element));
+        } else if (elemobjectdef && elemobjectdef->is_struct()) {
+          AddWord(vec.size());
+          for (uoffset_t i = 0; i < vec.size(); i++) {
+            AddStruct(*elemobjectdef,
+                      vec.Data() + i * elemobjectdef->bytesize());
+          }
+        } else {
+          AddWord(vec.size());
+          for (uoffset_t i = 0; i < vec.size(); i++) {
+            AddElement(fielddef, table, vec, i);
+          }
+        }
+        break;
+      }
+      default:
+        assert(false);
+        break;
+    }
+  }
+  AddWord(kHashEndOfTable);
+}
+
+// The values an integer type can hold (union types are bytes).
+static void IntegerRange(reflection::BaseType type, int64_t *min,
+                         uint64_t *max) {
+  *min = 0;
+  switch (type) {
+    #define FLATBUFFERS_INTEGER_RANGE(ENUM, T) \
+      case reflection::ENUM: \
+        *min = std::numeric_limits<T>::min(); \
+        *max = std::numeric_limits<T>::max(); \
+        break;
+    FLATBUFFERS_INTEGER_RANGE(Byte, int8_t)
+    FLATBUFFERS_INTEGER_RANGE(Short, int16_t)
+    FLATBUFFERS_INTEGER_RANGE(UShort, uint16_t)
+    FLATBUFFERS_INTEGER_RANGE(Int, int32_t)
+    FLATBUFFERS_INTEGER_RANGE(UInt, uint32_t)
+    FLATBUFFERS_INTEGER_RANGE(Long, int64_t)
+    FLATBUFFERS_INTEGER_RANGE(ULong, uint64_t)
+    #undef FLATBUFFERS_INTEGER_RANGE
+    case reflection::Bool: *max = 1; break;
+    case reflection::UType:
+    case reflection::UByte:
+    case reflection::Union: *max = 0xFF; break;
+    default: *max = 0; break;
+  }
+}
+
+// The elements of any kind of FlexBuffer vector (but not of a map).
+class FlexElements {
+ public:
+  explicit FlexElements(flexbuffers::Reference ref)
+    : type_(ref.GetType()), vec_(ref.AsVector()), typed_(ref.AsTypedVector()),
+      fixed_(ref.AsFixedTypedVector()), size_(0) {
+    if (type_ == flexbuffers::TYPE_VECTOR) {
+      size_ = vec_.size();
+    } else if (flexbuffers::IsTypedVector(type_)) {
+      size_ = typed_.size();
+    } else if (flexbuffers::IsFixedTypedVector(type_)) {
+      size_ = fixed_.size();
+    }
+  }
+
+  bool IsVector() const {
+    return type_ == flexbuffers::TYPE_VECTOR ||
+           flexbuffers::IsTypedVector(type_) ||
+           flexbuffers::IsFixedTypedVector(type_);
+  }
+
+  size_t size() const { return size_; }
+
+  flexbuffers::Reference operator[](size_t i) const {
+    if (type_ == flexbuffers::TYPE_VECTOR) return vec_[i];
+    if (flexbuffers::IsTypedVector(type_)) return typed_[i];
+    return fixed_[i];
+  }
+
+ private:
+  flexbuffers::Type type_;
+  flexbuffers::Vector vec_;
+  flexbuffers::TypedVector typed_;
+  flexbuffers::FixedTypedVector fixed_;
+  size_t size_;
+};
+
+FlexConverter::FlexConverter(const reflection::Schema &schema,
+                             bool skip_unknown_fields)
+  : schema_(schema), skip_unknown_fields_(skip_unknown_fields),
+    fbb_(nullptr), builder_(nullptr), depth_(0) {}
+
+const FlexConverter::ObjectPlan *FlexConverter::GetPlan(
+                                        const reflection::Object &objectdef) {
+  auto it = plans_.find(&objectdef);
+  if (it != plans_.end()) return &it->second;
+  // Insert the plan before filling it in, so recursive types find it.
+  auto &plan = plans_[&objectdef];
+  plan.objectdef = &objectdef;
+  std::vector<FieldPlan> fields;
+  // The schema has the fields sorted by name already.
+  auto fielddefs = objectdef.fields();
+  for (auto fit = fielddefs->begin(); fit != fielddefs->end(); ++fit) {
+    auto &fielddef = **fit;
+    FieldPlan field;
+    field.fielddef = &fielddef;
+    field.name = fielddef.name()->c_str();
+    field.name_len = fielddef.name()->size();
+    field.offset = fielddef.offset();
+    field.base_type = fielddef.type()->base_type();
+    field.element = fielddef.type()->element();
+    field.size = GetTypeSize(field.base_type);
+    field.align = field.size;
+    field.elem_size = GetTypeSize(field.element);
+    field.elem_align = field.elem_size;
+    IntegerRange(field.base_type == reflection::Vector ? field.element
+                                                        : field.base_type,
+                 &field.min, &field.max);
+    field.enumdef = nullptr;
+    field.object = nullptr;
+    auto index = fielddef.type()->index();
+    auto is_object = field.base_type == reflection::Obj ||
+                     (field.base_type == reflection::Vector &&
+                      field.element == reflection::Obj);
+    if (is_object) {
+      auto &subobjectdef = *schema_.objects()->Get(index);
+      field.object = GetPlan(subobjectdef);
+      if (subobjectdef.is_struct() && field.base_type == reflection::Obj) {
+        field.size = subobjectdef.bytesize();
+        field.align = subobjectdef.minalign();
+      } else if (subobjectdef.is_struct()) {
+        field.elem_size = subobjectdef.bytesize();
+        field.elem_align = subobjectdef.minalign();
+      }
+    } else if (index >= 0) {
+      field.enumdef = schema_.enums()->Get(index);
+    }
+    if (field.base_type == reflection::Union ||
+        field.element == reflection::Union) {
+      field.type_key = std::string(field.name) + UnionTypeFieldSuffix();
+    }
+    fields.push_back(field);
+  }
+  plan.fields.swap(fields);
+  plan.numfields = static_cast<voffset_t>(fielddefs->size());
+  return &plan;
+}
+
+bool FlexConverter::Error(const ObjectPlan &plan, const FieldPlan *field,
+                          const std::string &msg) {
+  error_ = plan.objectdef->name()->str();
+  if (field) error_ += std::string(".") + field->name;
+  error_ += ": " + msg;
+  return false;
+}
+
+Offset<const Table *> FlexConverter::FlexToFlat(
+                          const reflection::Object &objectdef,
+                          flexbuffers::Reference map, FlatBufferBuilder &fbb) {
+  error_.clear();
+  fbb_ = &fbb;
+  auto offset = ToTable(*GetPlan(objectdef), map);
+  fbb_ = nullptr;
+  return Offset<const Table *>(offset);
+}
+
+uoffset_t FlexConverter::ToTable(const ObjectPlan &plan,
+                                 flexbuffers::Reference ref) {
+  // As for JSON, to bound the recursion on hostile input.
+  const int kMaxDepth = 64;
+  if (depth_ >= kMaxDepth) {
+    Error(plan, nullptr, "maximum nesting depth exceeded");
+    return 0;
+  }
+  if (!ref.IsMap()) {
+    Error(plan, nullptr, "expected a map");
+    return 0;
+  }
+  // Before we can start the table, we have to build its subobjects, and
+  // collect the scalars.
+  auto map = ref.AsMap();
+  auto keys = map.Keys();
+  auto values = map.Values();
+  auto pending_start = pending_.size();
+  auto struct_data_start = struct_data_.size();
+  auto ok = true;
+  depth_++;
+  // Both the keys and the fields are sorted, so the field for a key is at or
+  // after the field for the key before it.
+  size_t f = 0;
+  for (size_t i = 0; ok && i < keys.size(); i++) {
+    auto key = keys[i].AsKey();
+    if (f && !strcmp(plan.fields[f - 1].name, key)) {
+      ok = Error(plan, &plan.fields[f - 1], "field set more than once");
+      break;
+    }
+    auto comp = 1;
+    while (f < plan.fields.size() &&
+           (comp = strcmp(plan.fields[f].name, key)) < 0) {
+      f++;
+    }
+    if (comp) {
+      if (!skip_unknown_fields_)
+        ok = Error(plan, nullptr, std::string("unknown field: ") + key);
+      continue;
+    }
+    auto &field = plan.fields[f++];
+    auto value = values[i];
+    if (field.fielddef->deprecated() || value.IsNull()) continue;
+    ok = ToField(plan, field, value, map);
+  }
+  depth_--;
+  for (auto it = plan.fields.begin(); ok && it != plan.fields.end(); ++it) {
+    if (!it->fielddef->required() || it->fielddef->deprecated()) continue;
+    auto found = false;
+    for (auto pit = pending_.begin() + pending_start;
+         pit != pending_.end() && !found; ++pit) {
+      found = pit->field == &*it;
+    }
+    if (!found) ok = Error(plan, &*it, "missing required field");
+  }
+  uoffset_t offset = 0;
+  if (ok) {
+    // Add fields with the largest alignment first, so there is as little
+    // padding between them as possible.
+    std::stable_sort(pending_.begin() + pending_start, pending_.end(),
+                     [](const Pending &a, const Pending &b) {
+      return a.field->align > b.field->align;
+    });
+    auto start = fbb_->StartTable();
+    for (auto it = pending_.begin() + pending_start; it != pending_.end();
+         ++it) {
+      auto &field = *it->field;
+      auto def = field.fielddef->default_integer();
+      switch (field.base_type) {
+        #define FLATBUFFERS_FLEX_INT(ENUM, T) \
+          case reflection::ENUM: \
+            fbb_->AddElement<T>(field.offset, static_cast<T>(it->i), \
+                                static_cast<T>(def)); \
+            break;
+        FLATBUFFERS_FLEX_INT(UType, uint8_t)
+        FLATBUFFERS_FLEX_INT(Bool, uint8_t)
+        FLATBUFFERS_FLEX_INT(UByte, uint8_t)
+        FLATBUFFERS_FLEX_INT(Byte, int8_t)
+        FLATBUFFERS_FLEX_INT(Short, int16_t)
+        FLATBUFFERS_FLEX_INT(UShort, uint16_t)
+        FLATBUFFERS_FLEX_INT(Int, int32_t)
+        FLATBUFFERS_FLEX_INT(UInt, uint32_t)
+        FLATBUFFERS_FLEX_INT(Long, int64_t)
+        FLATBUFFERS_FLEX_INT(ULong, uint64_t)
+        #undef FLATBUFFERS_FLEX_INT
+        case reflection::Float:
+          fbb_->AddElement<float>(field.offset, static_cast<float>(it->f),
+                                  static_cast<float>(
+                                    field.fielddef->default_real()));
+          break;
+        case reflection::Double:
+          fbb_->AddElement<double>(field.offset, it->f,
+                                   field.fielddef->default_real());
+          break;
+        case reflection::Obj:
+          if (field.object->objectdef->is_struct()) {
+            fbb_->Align(field.align);
+            fbb_->PushBytes(struct_data_.data() + it->ref, field.size);
+            fbb_->TrackField(field.offset, fbb_->GetSize());
+            break;
+          }
+          // fall through
+        default:
+          fbb_->AddOffset(field.offset, Offset<void>(it->ref));
+          break;
+      }
+    }
+    offset = fbb_->EndTable(start, plan.numfields);
+  }
+  pending_.resize(pending_start);
+  struct_data_.resize(struct_data_start);
+  return offset;
+}
+
+bool FlexConverter::ToField(const ObjectPlan &plan, const FieldPlan &field,
+                            flexbuffers::Reference value,
+                            const flexbuffers::Map &map) {
+  Pending pending = { &field, 0, 0, 0 };
+  switch (field.base_type) {
+    case reflection::String:
+      if (value.IsString()) {
+        auto str = value.AsString();
+        pending.ref = fbb_->CreateString(str.c_str(), str.length()).o;
+      } else if (value.IsKey()) {
+        pending.ref = fbb_->CreateString(value.AsKey()).o;
+      } else {
+        return Error(plan, &field, "expected a string");
+      }
+      break;
+    case reflection::Obj:
+      if (field.object->objectdef->is_struct()) {
+        pending.ref = static_cast<uoffset_t>(struct_data_.size());
+        struct_data_.resize(struct_data_.size() + field.size, 0);
+        if (!ToStruct(*field.object, value,
+                      struct_data_.data() + pending.ref))
+          return false;
+      } else {
+        pending.ref = ToTable(*field.object, value);
+      }
+      break;
+    case reflection::Union:
+      pending.ref = ToUnion(plan, field, map[field.type_key.c_str()], value);
+      break;
+    case reflection::Vector:
+      pending.ref = ToVector(plan, field, value, map);
+      break;
+    default:
+      if (!ToScalar(plan, field, field.base_type, value, &pending.i,
+                    &pending.f))
+        return false;
+      pending_.push_back(pending);
+      return true;
+  }
+  // Only scalars and structs can be 0.
+  if (!pending.ref && field.base_type != reflection::Obj) return false;
+  if (!pending.ref && !field.object->objectdef->is_struct()) return false;
+  pending_.push_back(pending);
+  return true;
+}
+
+bool FlexConverter::ToStruct(const ObjectPlan &plan,
+                             flexbuffers::Reference ref, uint8_t *data) {
+  if (!ref.IsMap()) return Error(plan, nullptr, "expected a map");
+  auto map = ref.AsMap();
+  auto keys = map.Keys();
+  auto values = map.Values();
+  // Every field must be set, so walk both in order.
+  size_t i = 0;
+  for (auto it = plan.fields.begin(); it != plan.fields.end(); ++it) {
+    auto comp = 1;
+    while (i < keys.size() && (comp = strcmp(keys[i].AsKey(), it->name)) < 0) {
+      if (!skip_unknown_fields_)
+        return Error(plan, nullptr,
+                     std::string("unknown field: ") + keys[i].AsKey());
+      i++;
+    }
+    if (comp) return Error(plan, &*it, "missing field");
+    auto value = values[i++];
+    if (it->base_type == reflection::Obj) {
+      if (!ToStruct(*it->object, value, data + it->offset)) return false;
+      continue;
+    }
+    int64_t iv = 0;
+    double fv = 0;
+    if (!ToScalar(plan, *it, it->base_type, value, &iv, &fv)) return false;
+    if (it->base_type == reflection::Float ||
+        it->base_type == reflection::Double) {
+      SetAnyValueF(it->base_type, data + it->offset, fv);
+    } else {
+      SetAnyValueI(it->base_type, data + it->offset, iv);
+    }
+  }
+  if (i < keys.size() && !skip_unknown_fields_)
+    return Error(plan, nullptr,
+                 std::string("unknown field: ") + keys[i].AsKey());
+  return true;
+}
+
+// Reads "value" as a scalar of "type": the type of "field", or of its
+// elements.
+bool FlexConverter::ToScalar(const ObjectPlan &plan, const FieldPlan &field,
+                             reflection::BaseType type,
+                             flexbuffers::Reference value, int64_t *i,
+                             double *f) {
+  if (type == reflection::Float || type == reflection::Double) {
+    if (!value.IsNumeric()) return Error(plan, &field, "expected a number");
+    *f = value.AsDouble();
+    auto magnitude = *f < 0 ? -*f : *f;
+    if (type == reflection::Float &&
+        magnitude > std::numeric_limits<float>::max() &&
+        magnitude != std::numeric_limits<double>::infinity())
+      return Error(plan, &field, "value out of range for Float");
+    return true;
+  }
+  if (field.enumdef && (value.IsString() || value.IsKey())) {
+    auto name = value.IsKey() ? value.AsKey() : value.AsString().c_str();
+    auto enumvals = field.enumdef->values();
+    for (auto it = enumvals->begin(); it != enumvals->end(); ++it) {
+      if (!strcmp(it->name()->c_str(), name)) {
+        *i = it->value();
+        return true;
+      }
+    }
+    return Error(plan, &field, std::string("unknown enum value: ") + name);
+  }
+  if (value.IsUInt()) {
+    auto u = value.AsUInt64();
+    if (u > field.max) {
+      return Error(plan, &field, std::string("value out of range for ") +
+                                 reflection::EnumNameBaseType(type));
+    }
+    *i = static_cast<int64_t>(u);
+    return true;
+  }
+  if (value.IsInt()) {
+    *i = value.AsInt64();
+    if (*i < field.min || (*i > 0 && static_cast<uint64_t>(*i) > field.max)) {
+      return Error(plan, &field, std::string("value out of range for ") +
+                                 reflection::EnumNameBaseType(type));
+    }
+    return true;
+  }
+  return Error(plan, &field, "expected an integer");
+}
+
+uoffset_t FlexConverter::ToUnion(const ObjectPlan &plan,
+                                 const FieldPlan &field,
+                                 flexbuffers::Reference type,
+                                 flexbuffers::Reference value) {
+  if (type.IsNull()) {
+    Error(plan, &field, "missing " + field.type_key);
+    return 0;
+  }
+  int64_t union_type = 0;
+  double unused = 0;
+  if (!ToScalar(plan, field, reflection::UType, type, &union_type, &unused))
+    return 0;
+  auto objectdef = UnionObject(schema_, *field.fielddef,
+                               static_cast<uint8_t>(union_type));
+  if (!objectdef) {
+    Error(plan, &field, "unknown union type");
+    return 0;
+  }
+  return ToTable(*GetPlan(*objectdef), value);
+}
+
+uoffset_t FlexConverter::ToVector(const ObjectPlan &plan,
+                                  const FieldPlan &field,
+                                  flexbuffers::Reference value,
+                                  const flexbuffers::Map &map) {
+  FlexElements elems(value);
+  if (!elems.IsVector()) {
+    Error(plan, &field, "expected a vector");
+    return 0;
+  }
+  auto len = elems.size();
+  auto mark = offsets_.size();
+  switch (field.element) {
+    case reflection::String:
+      for (size_t i = 0; i < len; i++) {
+        auto elem = elems[i];
+        if (elem.IsString()) {
+          auto str = elem.AsString();
+          offsets_.push_back(fbb_->CreateString(str.c_str(),
+                                                str.length()).Union());
+        } else if (elem.IsKey()) {
+          offsets_.push_back(fbb_->CreateString(elem.AsKey()).Union());
+        } else {
+          Error(plan, &field, "expected a vector of strings");
+          break;
+        }
+      }
+      break;
+    case reflection::Union: {
+      FlexElements types(map[field.type_key.c_str()]);
+      if (len && (!types.IsVector() || types.size() != len)) {
+        Error(plan, &field, "expected as many " + field.type_key);
+        return 0;
+      }
+      for (size_t i = 0; i < len; i++) {
+        auto offset = ToUnion(plan, field, types[i], elems[i]);
+        if (!offset) break;
+        offsets_.push_back(Offset<void>(offset));
+      }
+      break;
+    }
+    case reflection::Obj:
+      if (!field.object->objectdef->is_struct()) {
+        for (size_t i = 0; i < len; i++) {
+          auto offset = ToTable(*field.object, elems[i]);
+          if (!offset) break;
+          offsets_.push_back(Offset<void>(offset));
+        }
+        break;
+      }
+      // fall through
+    default: {  // Scalars and structs.
+      scratch_.assign(len * field.elem_size, 0);
+      for (size_t i = 0; i < len; i++) {
+        auto data = scratch_.data() + i * field.elem_size;
+        if (field.element == reflection::Obj) {
+          if (!ToStruct(*field.object, elems[i], data)) return 0;
+          continue;
+        }
+        int64_t iv = 0;
+        double fv = 0;
+        if (!ToScalar(plan, field, field.element, elems[i], &iv, &fv))
+          return 0;
+        if (field.element == reflection::Float ||
+            field.element == reflection::Double) {
+          SetAnyValueF(field.element, data, fv);
+        } else {
+          SetAnyValueI(field.element, data, iv);
+        }
+      }
+      fbb_->StartVector(len * field.elem_size / field.elem_align,
+                        field.elem_align);
+      if (len) fbb_->PushBytes(scratch_.data(), scratch_.size());
+      return fbb_->EndVector(len);
+    }
+  }
+  uoffset_t offset = 0;
+  if (offsets_.size() - mark == len)
+    offset = fbb_->CreateVector(offsets_.data() + mark, len).o;
+  offsets_.resize(mark);
+  return offset;
+}
+
+void FlexConverter::FlatToFlex(const reflection::Object &objectdef,
+                               const Table &table,
+                               flexbuffers::Builder &builder) {
+  builder_ = &builder;
+  FromTable(*GetPlan(objectdef), table);
+  builder_ = nullptr;
+}
+
+void FlexConverter::FromTable(const ObjectPlan &plan, const Table &table) {
+  // The fields are in name order, so the map needs no sorting.
+  auto start = builder_->StartMap();
+  for (auto it = plan.fields.begin(); it != plan.fields.end(); ++it) {
+    auto &field = *it;
+    if (field.fielddef->deprecated()) continue;
+    auto is_struct = field.base_type == reflection::Obj &&
+                     field.object->objectdef->is_struct();
+    if (field.base_type <= reflection::Double || is_struct) {
+      auto data = table.GetAddressOf(field.offset);
+      if (!data) continue;
+      builder_->Key(field.name, field.name_len);
+      if (is_struct) {
+        FromStruct(*field.object, data);
+      } else {
+        FromScalar(field.base_type, data);
+      }
+      continue;
+    }
+    auto ref = table.GetPointer<const uint8_t *>(field.offset);
+    if (!ref) continue;
+    const reflection::Object *subobjectdef = nullptr;
+    if (field.base_type == reflection::Union) {
+      subobjectdef = UnionObject(
+        schema_, *field.fielddef,
+        table.GetField<uint8_t>(UnionTypeOffset(*field.fielddef), 0));
+      // Leave out values of types we don't know about.
+      if (!subobjectdef) continue;
+    }
+    builder_->Key(field.name, field.name_len);
+    switch (field.base_type) {
+      case reflection::String: {
+        auto str = reinterpret_cast<const String *>(ref);
+        builder_->String(str->c_str(), str->size());
+        break;
+      }
+      case reflection::Obj:
+        FromTable(*field.object, *reinterpret_cast<const Table *>(ref));
+        break;
+      case reflection::Union:
+        FromTable(*GetPlan(*subobjectdef),
+                  *reinterpret_cast<const Table *>(ref));
+        break;
+      default:
+        FromVector(field, table, *reinterpret_cast<const VectorOfAny *>(ref));
+        break;
+    }
+  }
+  builder_->EndMap(start);
+}
+
+void FlexConverter::FromStruct(const ObjectPlan &plan, const uint8_t *data) {
+  auto start = builder_->StartMap();
+  for (auto it = plan.fields.begin(); it != plan.fields.end(); ++it) {
+    builder_->Key(it->name, it->name_len);
+    if (it->base_type == reflection::Obj) {
+      FromStruct(*it->object, data + it->offset);
+    } else {
+      FromScalar(it->base_type, data + it->offset);
+    }
+  }
+  builder_->EndMap(start);
+}
+
+void FlexConverter::FromScalar(reflection::BaseType type,
+                               const uint8_t *data) {
+  switch (type) {
+    case reflection::Float: builder_->Float(ReadScalar<float>(data)); break;
+    case reflection::Double: builder_->Double(ReadScalar<double>(data)); break;
+    case reflection::UType:
+    case reflection::UByte:
+    case reflection::UShort:
+    case reflection::UInt:
+    case reflection::ULong:
+      builder_->UInt(static_cast<uint64_t>(GetAnyValueI(type, data)));
+      break;
+    default:
+      // Bools too, as FlexBuffers have none.
+      builder_->Int(GetAnyValueI(type, data));
+      break;
+  }
+}
+
+void FlexConverter::FromVector(const FieldPlan &field, const Table &table,
+                               const VectorOfAny &vec) {
+  auto start = builder_->StartVector();
+  auto typed = false;
+  switch (field.element) {
+    case reflection::String:
+      for (uoffset_t i = 0; i < vec.size(); i++) {
+        auto str = GetAnyVectorElemPointer<const String>(&vec, i);
+        builder_->String(str->c_str(), str->size());
+      }
+      break;
+    case reflection::Union: {
+      auto types = table.GetPointer<const Vector<uint8_t> *>(
+                     UnionTypeOffset(*field.fielddef));
+      for (uoffset_t i = 0; i < vec.size(); i++) {
+        auto objectdef = types && i < types->size()
+                         ? UnionObject(schema_, *field.fielddef, types->Get(i))
+                         : nullptr;
+        if (objectdef) {
+          FromTable(*GetPlan(*objectdef),
+                    *GetAnyVectorElemPointer<const Table>(&vec, i));
+        } else {
+          builder_->Null();
+        }
+      }
+      break;
+    }
+    case reflection::Obj:
+      for (uoffset_t i = 0; i < vec.size(); i++) {
+        if (field.object->objectdef->is_struct()) {
+          FromStruct(*field.object, vec.Data() + i * field.elem_size);
+        } else {
+          FromTable(*field.object,
+                    *GetAnyVectorElemPointer<const Table>(&vec, i));
+        }
+      }
+      break;
+    default:
+      for (uoffset_t i = 0; i < vec.size(); i++) {
+        FromScalar(field.element, vec.Data() + i * field.elem_size);
+      }
+      typed = true;
+      break;
+  }
+  builder_->EndVector(start, typed, false);
+}
+
+Offset<const Table *> FlexToFlat(const reflection::Schema &schema,
+                                 const reflection::Object &objectdef,
+                                 flexbuffers::Reference map,
+                                 FlatBufferBuilder &fbb, std::string *error) {
+  FlexConverter converter(schema);
+  auto offset = converter.FlexToFlat(objectdef, map, fbb);
+  if (!offset.o && error) *error = converter.error();
+  return offset;
+}
+
+void FlatToFlex(const reflection::Schema &schema,
+                const reflection::Object &objectdef, const Table &table,
+                flexbuffers::Builder &builder) {
+  FlexConverter converter(schema);
+  converter.FlatToFlex(objectdef, table, builder);
 }
 
 bool VerifyStruct(flatbuffers::Verifier &v,
@@ -5,6 +5,7 @@
 #define FLATBUFFERS_GENERATED_MONSTERTEST_MYGAME_EXAMPLE_H_
 
 #include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/json.h"
 
 namespace MyGame {
 namespace Example2 {
@@ -1294,6 +1295,1062 @@ inline void AnyUnion::Reset() {
   type = Any_NONE;
 }
 
+template<typename Sink>
+void PrintJson(Color e, flatbuffers::JsonPrinter<Sink> &p) {
+  switch (e) {
+    case Color_Red: p.Identifier("Red"); break;
+    case Color_Green: p.Identifier("Green"); break;
+    case Color_Blue: p.Identifier("Blue"); break;
+    default: p.Number(static_cast<int8_t>(e));
+  }
+}
+
+inline bool ParseJson(Color *e, flatbuffers::JsonReader &r) {
+  int8_t v;
+  if (!r.Enum(&v, [](const char *name, size_t len, int64_t *value) {
+        switch (len) {
+          case 3:
+            if (!memcmp(name, "Red", 3)) {
+              *value = static_cast<int64_t>(Color_Red); return true;
+            }
+            break;
+          case 4:
+            if (!memcmp(name, "Blue", 4)) {
+              *value = static_cast<int64_t>(Color_Blue); return true;
+            }
+            break;
+          case 5:
+            if (!memcmp(name, "Green", 5)) {
+              *value = static_cast<int64_t>(Color_Green); return true;
+            }
+            break;
+        }
+        return false;
+      })) {
+    return false;
+  }
+  *e = static_cast<Color>(v);
+  return true;
+}
+
+template<typename Sink>
+void PrintJson(Any e, flatbuffers::JsonPrinter<Sink> &p) {
+  switch (e) {
+    case Any_Monster: p.Identifier("Monster"); break;
+    case Any_TestSimpleTableWithEnum: p.Identifier("TestSimpleTableWithEnum"); break;
+    case Any_MyGame_Example2_Monster: p.Identifier("MyGame_Example2_Monster"); break;
+    default: p.Number(static_cast<uint8_t>(e));
+  }
+}
+
+inline bool ParseJson(Any *e, flatbuffers::JsonReader &r) {
+  uint8_t v;
+  if (!r.Enum(&v, [](const char *name, size_t len, int64_t *value) {
+        switch (len) {
+          case 4:
+            if (!memcmp(name, "NONE", 4)) {
+              *value = static_cast<int64_t>(Any_NONE); return true;
+            }
+            break;
+          case 7:
+            if (!memcmp(name, "Monster", 7)) {
+              *value = static_cast<int64_t>(Any_Monster); return true;
+            }
+            break;
+          case 23:
+            if (!memcmp(name, "TestSimpleTableWithEnum", 23)) {
+              *value = static_cast<int64_t>(Any_TestSimpleTableWithEnum); return true;
+            }
+            if (!memcmp(name, "MyGame_Example2_Monster", 23)) {
+              *value = static_cast<int64_t>(Any_MyGame_Example2_Monster); return true;
+            }
+            break;
+        }
+        return false;
+      })) {
+    return false;
+  }
+  *e = static_cast<Any>(v);
+  return true;
+}
+
+}  // namespace Example
+
+namespace Example2 {
+
+template<typename Sink>
+void PrintJson(const Monster &/*o*/, flatbuffers::JsonPrinter<Sink> &p) {
+  p.StartObject();
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const Monster &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+}  // namespace Example2
+
+namespace Example {
+
+template<typename Sink>
+void PrintJson(const Test &o, flatbuffers::JsonPrinter<Sink> &p) {
+  p.StartObject();
+  p.Key(0, "a"); p.Number(o.a());
+  p.Key(1, "b"); p.Number(o.b());
+  p.EndObject();
+}
+
+template<typename Sink>
+void PrintJson(const TestSimpleTableWithEnum &o, flatbuffers::JsonPrinter<Sink> &p) {
+  auto t = reinterpret_cast<const flatbuffers::Table *>(&o);
+  int n = 0;
+  p.StartObject();
+  if (t->CheckField(TestSimpleTableWithEnum::VT_COLOR)) {
+    p.Key(n++, "color");
+    PrintJson(o.color(), p);
+  }
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const TestSimpleTableWithEnum &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+template<typename Sink>
+void PrintJson(const Vec3 &o, flatbuffers::JsonPrinter<Sink> &p) {
+  p.StartObject();
+  p.Key(0, "x"); p.Number(o.x());
+  p.Key(1, "y"); p.Number(o.y());
+  p.Key(2, "z"); p.Number(o.z());
+  p.Key(3, "test1"); p.Number(o.test1());
+  p.Key(4, "test2"); PrintJson(o.test2(), p);
+  p.Key(5, "test3"); PrintJson(o.test3(), p);
+  p.EndObject();
+}
+
+template<typename Sink>
+void PrintJson(const Stat &o, flatbuffers::JsonPrinter<Sink> &p) {
+  auto t = reinterpret_cast<const flatbuffers::Table *>(&o);
+  int n = 0;
+  p.StartObject();
+  if (auto v = o.id()) {
+    p.Key(n++, "id");
+    p.String(*v);
+  }
+  if (t->CheckField(Stat::VT_VAL)) {
+    p.Key(n++, "val");
+    p.Number(o.val());
+  }
+  if (t->CheckField(Stat::VT_COUNT)) {
+    p.Key(n++, "count");
+    p.Number(o.count());
+  }
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const Stat &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+template<typename Sink>
+void PrintJson(const Monster &o, flatbuffers::JsonPrinter<Sink> &p) {
+  auto t = reinterpret_cast<const flatbuffers::Table *>(&o);
+  int n = 0;
+  p.StartObject();
+  if (auto v = o.pos()) {
+    p.Key(n++, "pos");
+    PrintJson(*v, p);
+  }
+  if (t->CheckField(Monster::VT_MANA)) {
+    p.Key(n++, "mana");
+    p.Number(o.mana());
+  }
+  if (t->CheckField(Monster::VT_HP)) {
+    p.Key(n++, "hp");
+    p.Number(o.hp());
+  }
+  if (auto v = o.name()) {
+    p.Key(n++, "name");
+    p.String(*v);
+  }
+  if (auto v = o.inventory()) {
+    p.Key(n++, "inventory");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      p.Number(v->Get(i));
+    }
+    p.EndArray();
+  }
+  if (t->CheckField(Monster::VT_COLOR)) {
+    p.Key(n++, "color");
+    PrintJson(o.color(), p);
+  }
+  if (t->CheckField(Monster::VT_TEST_TYPE)) {
+    p.Key(n++, "test_type");
+    PrintJson(o.test_type(), p);
+  }
+  switch (o.test_type()) {
+    case Any_Monster:
+      if (auto v = o.test()) {
+        p.Key(n++, "test");
+        PrintJson(*static_cast<const Monster *>(v), p);
+      }
+      break;
+    case Any_TestSimpleTableWithEnum:
+      if (auto v = o.test()) {
+        p.Key(n++, "test");
+        PrintJson(*static_cast<const TestSimpleTableWithEnum *>(v), p);
+      }
+      break;
+    case Any_MyGame_Example2_Monster:
+      if (auto v = o.test()) {
+        p.Key(n++, "test");
+        PrintJson(*static_cast<const MyGame::Example2::Monster *>(v), p);
+      }
+      break;
+    default: break;
+  }
+  if (auto v = o.test4()) {
+    p.Key(n++, "test4");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      PrintJson(*v->Get(i), p);
+    }
+    p.EndArray();
+  }
+  if (auto v = o.testarrayofstring()) {
+    p.Key(n++, "testarrayofstring");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      p.String(*v->Get(i));
+    }
+    p.EndArray();
+  }
+  if (auto v = o.testarrayoftables()) {
+    p.Key(n++, "testarrayoftables");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      PrintJson(*v->Get(i), p);
+    }
+    p.EndArray();
+  }
+  if (auto v = o.enemy()) {
+    p.Key(n++, "enemy");
+    PrintJson(*v, p);
+  }
+  if (auto v = o.testnestedflatbuffer()) {
+    p.Key(n++, "testnestedflatbuffer");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      p.Number(v->Get(i));
+    }
+    p.EndArray();
+  }
+  if (auto v = o.testempty()) {
+    p.Key(n++, "testempty");
+    PrintJson(*v, p);
+  }
+  if (t->CheckField(Monster::VT_TESTBOOL)) {
+    p.Key(n++, "testbool");
+    p.Bool(o.testbool());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHS32_FNV1)) {
+    p.Key(n++, "testhashs32_fnv1");
+    p.Number(o.testhashs32_fnv1());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHU32_FNV1)) {
+    p.Key(n++, "testhashu32_fnv1");
+    p.Number(o.testhashu32_fnv1());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHS64_FNV1)) {
+    p.Key(n++, "testhashs64_fnv1");
+    p.Number(o.testhashs64_fnv1());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHU64_FNV1)) {
+    p.Key(n++, "testhashu64_fnv1");
+    p.Number(o.testhashu64_fnv1());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHS32_FNV1A)) {
+    p.Key(n++, "testhashs32_fnv1a");
+    p.Number(o.testhashs32_fnv1a());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHU32_FNV1A)) {
+    p.Key(n++, "testhashu32_fnv1a");
+    p.Number(o.testhashu32_fnv1a());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHS64_FNV1A)) {
+    p.Key(n++, "testhashs64_fnv1a");
+    p.Number(o.testhashs64_fnv1a());
+  }
+  if (t->CheckField(Monster::VT_TESTHASHU64_FNV1A)) {
+    p.Key(n++, "testhashu64_fnv1a");
+    p.Number(o.testhashu64_fnv1a());
+  }
+  if (auto v = o.testarrayofbools()) {
+    p.Key(n++, "testarrayofbools");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      p.Bool(v->Get(i) != 0);
+    }
+    p.EndArray();
+  }
+  if (t->CheckField(Monster::VT_TESTF)) {
+    p.Key(n++, "testf");
+    p.Number(o.testf());
+  }
+  if (t->CheckField(Monster::VT_TESTF2)) {
+    p.Key(n++, "testf2");
+    p.Number(o.testf2());
+  }
+  if (t->CheckField(Monster::VT_TESTF3)) {
+    p.Key(n++, "testf3");
+    p.Number(o.testf3());
+  }
+  if (auto v = o.testarrayofstring2()) {
+    p.Key(n++, "testarrayofstring2");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      p.String(*v->Get(i));
+    }
+    p.EndArray();
+  }
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const Monster &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+}  // namespace Example
+
+namespace Example2 {
+
+inline bool ParseJson(flatbuffers::Offset<Monster> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+}  // namespace Example2
+
+namespace Example {
+
+inline bool ParseJson(Test *out, flatbuffers::JsonReader &r);
+
+inline bool ParseJson(flatbuffers::Offset<TestSimpleTableWithEnum> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+inline bool ParseJson(Vec3 *out, flatbuffers::JsonReader &r);
+
+inline bool ParseJson(flatbuffers::Offset<Stat> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+inline bool ParseJson(flatbuffers::Offset<Monster> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+inline bool ParseJson(Any type, flatbuffers::Offset<void> *out,
+                      flatbuffers::FlatBufferBuilder &fbb, flatbuffers::JsonReader &r) {
+  switch (type) {
+    case Any_Monster: {
+      flatbuffers::Offset<Monster> o;
+      if (!ParseJson(&o, fbb, r)) return false;
+      *out = o.Union();
+      return true;
+    }
+    case Any_TestSimpleTableWithEnum: {
+      flatbuffers::Offset<TestSimpleTableWithEnum> o;
+      if (!ParseJson(&o, fbb, r)) return false;
+      *out = o.Union();
+      return true;
+    }
+    case Any_MyGame_Example2_Monster: {
+      flatbuffers::Offset<MyGame::Example2::Monster> o;
+      if (!ParseJson(&o, fbb, r)) return false;
+      *out = o.Union();
+      return true;
+    }
+    default: return r.Error("illegal type id for union: Any");
+  }
+}
+
+}  // namespace Example
+
+namespace Example2 {
+
+inline bool ParseJson(flatbuffers::Offset<Monster> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  MonsterBuilder b(fbb);
+  *out = b.Finish();
+  return true;
+}
+
+}  // namespace Example2
+
+namespace Example {
+
+inline bool ParseJson(Test *out, flatbuffers::JsonReader &r) {
+  int16_t _a = static_cast<int16_t>(0);
+  bool _a_set = false;
+  int8_t _b = static_cast<int8_t>(0);
+  bool _b_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 1:
+        if (!memcmp(name, "a", 1)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_a_set, "a")) return false;
+          if (!r.Number(&_a)) return false;
+          continue;
+        }
+        if (!memcmp(name, "b", 1)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_b_set, "b")) return false;
+          if (!r.Number(&_b)) return false;
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  if (!_a_set) {
+    return r.Error("struct: wrong number of initializers: Test");
+  }
+  if (!_b_set) {
+    return r.Error("struct: wrong number of initializers: Test");
+  }
+  *out = Test(_a, _b);
+  return true;
+}
+
+inline bool ParseJson(flatbuffers::Offset<TestSimpleTableWithEnum> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  Color _color = static_cast<Color>(0);
+  bool _color_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 5:
+        if (!memcmp(name, "color", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_color_set, "color")) return false;
+          if (!ParseJson(&_color, r)) return false;
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  TestSimpleTableWithEnumBuilder b(fbb);
+  if (_color_set) b.add_color(_color);
+  *out = b.Finish();
+  return true;
+}
+
+inline bool ParseJson(Vec3 *out, flatbuffers::JsonReader &r) {
+  float _x = static_cast<float>(0);
+  bool _x_set = false;
+  float _y = static_cast<float>(0);
+  bool _y_set = false;
+  float _z = static_cast<float>(0);
+  bool _z_set = false;
+  double _test1 = static_cast<double>(0);
+  bool _test1_set = false;
+  Color _test2 = static_cast<Color>(0);
+  bool _test2_set = false;
+  Test _test3;
+  bool _test3_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 1:
+        if (!memcmp(name, "x", 1)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_x_set, "x")) return false;
+          if (!r.Number(&_x)) return false;
+          continue;
+        }
+        if (!memcmp(name, "y", 1)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_y_set, "y")) return false;
+          if (!r.Number(&_y)) return false;
+          continue;
+        }
+        if (!memcmp(name, "z", 1)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_z_set, "z")) return false;
+          if (!r.Number(&_z)) return false;
+          continue;
+        }
+        break;
+      case 5:
+        if (!memcmp(name, "test1", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_test1_set, "test1")) return false;
+          if (!r.Number(&_test1)) return false;
+          continue;
+        }
+        if (!memcmp(name, "test2", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_test2_set, "test2")) return false;
+          if (!ParseJson(&_test2, r)) return false;
+          continue;
+        }
+        if (!memcmp(name, "test3", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_test3_set, "test3")) return false;
+          if (!ParseJson(&_test3, r)) return false;
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  if (!_x_set) {
+    return r.Error("struct: wrong number of initializers: Vec3");
+  }
+  if (!_y_set) {
+    return r.Error("struct: wrong number of initializers: Vec3");
+  }
+  if (!_z_set) {
+    return r.Error("struct: wrong number of initializers: Vec3");
+  }
+  if (!_test1_set) {
+    return r.Error("struct: wrong number of initializers: Vec3");
+  }
+  if (!_test2_set) {
+    return r.Error("struct: wrong number of initializers: Vec3");
+  }
+  if (!_test3_set) {
+    return r.Error("struct: wrong number of initializers: Vec3");
+  }
+  *out = Vec3(_x, _y, _z, _test1, _test2, _test3);
+  return true;
+}
+
+inline bool ParseJson(flatbuffers::Offset<Stat> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  flatbuffers::Offset<flatbuffers::String> _id;
+  bool _id_set = false;
+  int64_t _val = static_cast<int64_t>(0);
+  bool _val_set = false;
+  uint16_t _count = static_cast<uint16_t>(0);
+  bool _count_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 2:
+        if (!memcmp(name, "id", 2)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_id_set, "id")) return false;
+          const std::string *s;
+          if (!r.String(&s)) return false;
+          _id = fbb.CreateString(*s);
+          continue;
+        }
+        break;
+      case 3:
+        if (!memcmp(name, "val", 3)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_val_set, "val")) return false;
+          if (!r.Number(&_val)) return false;
+          continue;
+        }
+        break;
+      case 5:
+        if (!memcmp(name, "count", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_count_set, "count")) return false;
+          if (!r.Number(&_count)) return false;
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  StatBuilder b(fbb);
+  if (_val_set) b.add_val(_val);
+  if (_id_set) b.add_id(_id);
+  if (_count_set) b.add_count(_count);
+  *out = b.Finish();
+  return true;
+}
+
+inline bool ParseJson(flatbuffers::Offset<Monster> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  Vec3 _pos;
+  bool _pos_set = false;
+  int16_t _mana = static_cast<int16_t>(0);
+  bool _mana_set = false;
+  int16_t _hp = static_cast<int16_t>(0);
+  bool _hp_set = false;
+  flatbuffers::Offset<flatbuffers::String> _name;
+  bool _name_set = false;
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t>> _inventory;
+  bool _inventory_set = false;
+  Color _color = static_cast<Color>(0);
+  bool _color_set = false;
+  Any _test_type = static_cast<Any>(0);
+  bool _test_type_set = false;
+  flatbuffers::Offset<void> _test;
+  bool _test_set = false;
+  const char *_test_pos = nullptr;
+  flatbuffers::Offset<flatbuffers::Vector<const Test *>> _test4;
+  bool _test4_set = false;
+  flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> _testarrayofstring;
+  bool _testarrayofstring_set = false;
+  flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Monster>>> _testarrayoftables;
+  bool _testarrayoftables_set = false;
+  flatbuffers::Offset<Monster> _enemy;
+  bool _enemy_set = false;
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t>> _testnestedflatbuffer;
+  bool _testnestedflatbuffer_set = false;
+  flatbuffers::Offset<Stat> _testempty;
+  bool _testempty_set = false;
+  bool _testbool = static_cast<bool>(0);
+  bool _testbool_set = false;
+  int32_t _testhashs32_fnv1 = static_cast<int32_t>(0);
+  bool _testhashs32_fnv1_set = false;
+  uint32_t _testhashu32_fnv1 = static_cast<uint32_t>(0);
+  bool _testhashu32_fnv1_set = false;
+  int64_t _testhashs64_fnv1 = static_cast<int64_t>(0);
+  bool _testhashs64_fnv1_set = false;
+  uint64_t _testhashu64_fnv1 = static_cast<uint64_t>(0);
+  bool _testhashu64_fnv1_set = false;
+  int32_t _testhashs32_fnv1a = static_cast<int32_t>(0);
+  bool _testhashs32_fnv1a_set = false;
+  uint32_t _testhashu32_fnv1a = static_cast<uint32_t>(0);
+  bool _testhashu32_fnv1a_set = false;
+  int64_t _testhashs64_fnv1a = static_cast<int64_t>(0);
+  bool _testhashs64_fnv1a_set = false;
+  uint64_t _testhashu64_fnv1a = static_cast<uint64_t>(0);
+  bool _testhashu64_fnv1a_set = false;
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t>> _testarrayofbools;
+  bool _testarrayofbools_set = false;
+  float _testf = static_cast<float>(0);
+  bool _testf_set = false;
+  float _testf2 = static_cast<float>(0);
+  bool _testf2_set = false;
+  float _testf3 = static_cast<float>(0);
+  bool _testf3_set = false;
+  flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> _testarrayofstring2;
+  bool _testarrayofstring2_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 2:
+        if (!memcmp(name, "hp", 2)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_hp_set, "hp")) return false;
+          if (!r.Number(&_hp)) return false;
+          continue;
+        }
+        break;
+      case 3:
+        if (!memcmp(name, "pos", 3)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_pos_set, "pos")) return false;
+          if (!ParseJson(&_pos, r)) return false;
+          continue;
+        }
+        break;
+      case 4:
+        if (!memcmp(name, "mana", 4)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_mana_set, "mana")) return false;
+          if (!r.Number(&_mana)) return false;
+          continue;
+        }
+        if (!memcmp(name, "name", 4)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_name_set, "name")) return false;
+          const std::string *s;
+          if (!r.String(&s)) return false;
+          _name = fbb.CreateString(*s);
+          continue;
+        }
+        if (!memcmp(name, "test", 4)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_test_set, "test")) return false;
+          if (!_test_type_set) {
+            _test_pos = r.Position();
+            if (!r.SkipValue()) return false;
+          } else if (!ParseJson(_test_type, &_test, fbb, r)) {
+            return false;
+          }
+          continue;
+        }
+        break;
+      case 5:
+        if (!memcmp(name, "color", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_color_set, "color")) return false;
+          if (!ParseJson(&_color, r)) return false;
+          continue;
+        }
+        if (!memcmp(name, "test4", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_test4_set, "test4")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<Test> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            Test e;
+            if (!ParseJson(&e, r)) return false;
+            v.push_back(e);
+          }
+          if (!r.ok()) return false;
+          _test4 = fbb.CreateVectorOfStructs(v);
+          continue;
+        }
+        if (!memcmp(name, "enemy", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_enemy_set, "enemy")) return false;
+          if (!ParseJson(&_enemy, fbb, r)) return false;
+          continue;
+        }
+        if (!memcmp(name, "testf", 5)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testf_set, "testf")) return false;
+          if (!r.Number(&_testf)) return false;
+          continue;
+        }
+        break;
+      case 6:
+        if (!memcmp(name, "testf2", 6)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testf2_set, "testf2")) return false;
+          if (!r.Number(&_testf2)) return false;
+          continue;
+        }
+        if (!memcmp(name, "testf3", 6)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testf3_set, "testf3")) return false;
+          if (!r.Number(&_testf3)) return false;
+          continue;
+        }
+        break;
+      case 8:
+        if (!memcmp(name, "friendly", 8)) {
+          if (!r.SkipValue()) return false;
+          continue;
+        }
+        if (!memcmp(name, "testbool", 8)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testbool_set, "testbool")) return false;
+          if (!r.Number(&_testbool)) return false;
+          continue;
+        }
+        break;
+      case 9:
+        if (!memcmp(name, "inventory", 9)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_inventory_set, "inventory")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<uint8_t> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            uint8_t e;
+            if (!r.Number(&e)) return false;
+            v.push_back(e);
+          }
+          if (!r.ok()) return false;
+          _inventory = fbb.CreateVector(v);
+          continue;
+        }
+        if (!memcmp(name, "test_type", 9)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_test_type_set, "test_type")) return false;
+          if (!ParseJson(&_test_type, r)) return false;
+          continue;
+        }
+        if (!memcmp(name, "testempty", 9)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testempty_set, "testempty")) return false;
+          if (!ParseJson(&_testempty, fbb, r)) return false;
+          continue;
+        }
+        break;
+      case 16:
+        if (!memcmp(name, "testhashs32_fnv1", 16)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashs32_fnv1_set, "testhashs32_fnv1")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashs32_fnv1 = static_cast<int32_t>(flatbuffers::HashFnv1<uint32_t>(s->c_str()));
+          } else if (!r.Number(&_testhashs32_fnv1)) {
+            return false;
+          }
+          continue;
+        }
+        if (!memcmp(name, "testhashu32_fnv1", 16)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashu32_fnv1_set, "testhashu32_fnv1")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashu32_fnv1 = static_cast<uint32_t>(flatbuffers::HashFnv1<uint32_t>(s->c_str()));
+          } else if (!r.Number(&_testhashu32_fnv1)) {
+            return false;
+          }
+          continue;
+        }
+        if (!memcmp(name, "testhashs64_fnv1", 16)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashs64_fnv1_set, "testhashs64_fnv1")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashs64_fnv1 = static_cast<int64_t>(flatbuffers::HashFnv1<uint64_t>(s->c_str()));
+          } else if (!r.Number(&_testhashs64_fnv1)) {
+            return false;
+          }
+          continue;
+        }
+        if (!memcmp(name, "testhashu64_fnv1", 16)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashu64_fnv1_set, "testhashu64_fnv1")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashu64_fnv1 = static_cast<uint64_t>(flatbuffers::HashFnv1<uint64_t>(s->c_str()));
+          } else if (!r.Number(&_testhashu64_fnv1)) {
+            return false;
+          }
+          continue;
+        }
+        if (!memcmp(name, "testarrayofbools", 16)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testarrayofbools_set, "testarrayofbools")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<uint8_t> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            bool e;
+            if (!r.Number(&e)) return false;
+            v.push_back(static_cast<uint8_t>(e));
+          }
+          if (!r.ok()) return false;
+          _testarrayofbools = fbb.CreateVector(v);
+          continue;
+        }
+        break;
+      case 17:
+        if (!memcmp(name, "testarrayofstring", 17)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testarrayofstring_set, "testarrayofstring")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<flatbuffers::Offset<flatbuffers::String>> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            flatbuffers::Offset<flatbuffers::String> e;
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            e = fbb.CreateString(*s);
+            v.push_back(e);
+          }
+          if (!r.ok()) return false;
+          _testarrayofstring = fbb.CreateVector(v);
+          continue;
+        }
+        if (!memcmp(name, "testarrayoftables", 17)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testarrayoftables_set, "testarrayoftables")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<flatbuffers::Offset<Monster>> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            flatbuffers::Offset<Monster> e;
+            if (!ParseJson(&e, fbb, r)) return false;
+            v.push_back(e);
+          }
+          if (!r.ok()) return false;
+          _testarrayoftables = fbb.CreateVector(v);
+          continue;
+        }
+        if (!memcmp(name, "testhashs32_fnv1a", 17)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashs32_fnv1a_set, "testhashs32_fnv1a")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashs32_fnv1a = static_cast<int32_t>(flatbuffers::HashFnv1a<uint32_t>(s->c_str()));
+          } else if (!r.Number(&_testhashs32_fnv1a)) {
+            return false;
+          }
+          continue;
+        }
+        if (!memcmp(name, "testhashu32_fnv1a", 17)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashu32_fnv1a_set, "testhashu32_fnv1a")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashu32_fnv1a = static_cast<uint32_t>(flatbuffers::HashFnv1a<uint32_t>(s->c_str()));
+          } else if (!r.Number(&_testhashu32_fnv1a)) {
+            return false;
+          }
+          continue;
+        }
+        if (!memcmp(name, "testhashs64_fnv1a", 17)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashs64_fnv1a_set, "testhashs64_fnv1a")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashs64_fnv1a = static_cast<int64_t>(flatbuffers::HashFnv1a<uint64_t>(s->c_str()));
+          } else if (!r.Number(&_testhashs64_fnv1a)) {
+            return false;
+          }
+          continue;
+        }
+        if (!memcmp(name, "testhashu64_fnv1a", 17)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testhashu64_fnv1a_set, "testhashu64_fnv1a")) return false;
+          if (r.Peek() == '"') {
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            _testhashu64_fnv1a = static_cast<uint64_t>(flatbuffers::HashFnv1a<uint64_t>(s->c_str()));
+          } else if (!r.Number(&_testhashu64_fnv1a)) {
+            return false;
+          }
+          continue;
+        }
+        break;
+      case 18:
+        if (!memcmp(name, "testarrayofstring2", 18)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testarrayofstring2_set, "testarrayofstring2")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<flatbuffers::Offset<flatbuffers::String>> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            flatbuffers::Offset<flatbuffers::String> e;
+            const std::string *s;
+            if (!r.String(&s)) return false;
+            e = fbb.CreateString(*s);
+            v.push_back(e);
+          }
+          if (!r.ok()) return false;
+          _testarrayofstring2 = fbb.CreateVector(v);
+          continue;
+        }
+        break;
+      case 20:
+        if (!memcmp(name, "testnestedflatbuffer", 20)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_testnestedflatbuffer_set, "testnestedflatbuffer")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<uint8_t> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            uint8_t e;
+            if (!r.Number(&e)) return false;
+            v.push_back(e);
+          }
+          if (!r.ok()) return false;
+          _testnestedflatbuffer = fbb.CreateVector(v);
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  if (!_name_set) {
+    return r.Error("required field is missing: name in Monster");
+  }
+  if (_test_pos) {
+    auto end = r.Position();
+    r.Rewind(_test_pos);
+    if (!_test_type_set) {
+      return r.Error("missing type field for this union value: test");
+    }
+    if (!ParseJson(_test_type, &_test, fbb, r)) return false;
+    r.Rewind(end);
+  }
+  MonsterBuilder b(fbb);
+  if (_testhashu64_fnv1a_set) b.add_testhashu64_fnv1a(_testhashu64_fnv1a);
+  if (_testhashs64_fnv1a_set) b.add_testhashs64_fnv1a(_testhashs64_fnv1a);
+  if (_testhashu64_fnv1_set) b.add_testhashu64_fnv1(_testhashu64_fnv1);
+  if (_testhashs64_fnv1_set) b.add_testhashs64_fnv1(_testhashs64_fnv1);
+  if (_testarrayofstring2_set) b.add_testarrayofstring2(_testarrayofstring2);
+  if (_testf3_set) b.add_testf3(_testf3);
+  if (_testf2_set) b.add_testf2(_testf2);
+  if (_testf_set) b.add_testf(_testf);
+  if (_testarrayofbools_set) b.add_testarrayofbools(_testarrayofbools);
+  if (_testhashu32_fnv1a_set) b.add_testhashu32_fnv1a(_testhashu32_fnv1a);
+  if (_testhashs32_fnv1a_set) b.add_testhashs32_fnv1a(_testhashs32_fnv1a);
+  if (_testhashu32_fnv1_set) b.add_testhashu32_fnv1(_testhashu32_fnv1);
+  if (_testhashs32_fnv1_set) b.add_testhashs32_fnv1(_testhashs32_fnv1);
+  if (_testempty_set) b.add_testempty(_testempty);
+  if (_testnestedflatbuffer_set) b.add_testnestedflatbuffer(_testnestedflatbuffer);
+  if (_enemy_set) b.add_enemy(_enemy);
+  if (_testarrayoftables_set) b.add_testarrayoftables(_testarrayoftables);
+  if (_testarrayofstring_set) b.add_testarrayofstring(_testarrayofstring);
+  if (_test4_set) b.add_test4(_test4);
+  if (_test_set) b.add_test(_test);
+  if (_inventory_set) b.add_inventory(_inventory);
+  if (_name_set) b.add_name(_name);
+  if (_pos_set) b.add_pos(&_pos);
+  if (_hp_set) b.add_hp(_hp);
+  if (_mana_set) b.add_mana(_mana);
+  if (_testbool_set) b.add_testbool(_testbool);
+  if (_test_type_set) b.add_test_type(_test_type);
+  if (_color_set) b.add_color(_color);
+  *out = b.Finish();
+  return true;
+}
+
 inline const MyGame::Example::Monster *GetMonster(const void *buf) {
   return flatbuffers::GetRoot<MyGame::Example::Monster>(buf);
 }
@@ -16,6 +16,7 @@
 
 #include "flatbuffers/flatbuffers.h"
 #include "flatbuffers/idl.h"
+#include "flatbuffers/query.h"
 #include "flatbuffers/util.h"
 
 #include "monster_test_generated.h"
@@ -632,6 +633,801 @@ void ReflectionTest(uint8_t *flatbuf, size_t length) {
   // Test buffer is valid using reflection as well
   TEST_EQ(flatbuffers::Verify(schema, *schema.root_table(),
                               fbb.GetBufferPointer(), fbb.GetSize()), true);
+
+  // A TableCopier can be reused to copy many tables into the same builder,
+  // and keeps objects that are shared in the source shared in the copy.
+  flatbuffers::FlatBufferBuilder copyfbb;
+  flatbuffers::TableCopier copier(copyfbb, schema);
+  auto &source = *flatbuffers::GetAnyRoot(flatbuf);
+  auto copy_offset = copier.CopyTable(*root_table, source);
+  TEST_EQ(copier.CopyTable(*root_table, source).o, copy_offset.o);
+  copyfbb.Finish(copy_offset, MonsterIdentifier());
+  AccessFlatBufferTest(copyfbb.GetBufferPointer(), copyfbb.GetSize());
+  auto copy = GetMonster(copyfbb.GetBufferPointer());
+  TEST_EQ(copy->test_as_Monster(), copy->testarrayoftables()->Get(1));
+  TEST_EQ(copy->testarrayofstring()->Get(0),
+          copy->testarrayofstring()->Get(2));
+  // Extract a sub-table as the root of a new buffer.
+  copyfbb.Clear();
+  copier.Reset();
+  auto fred = GetMonster(flatbuf)->testarrayoftables()->Get(1);
+  copyfbb.Finish(copier.CopyTable(
+    *root_table, *reinterpret_cast<const flatbuffers::Table *>(fred)));
+  TEST_EQ_STR(GetMonster(copyfbb.GetBufferPointer())->name()->c_str(),
+              "Fred");
+  // Copied objects are remembered by address, so a changed source needs a
+  // Reset() to be copied again.
+  std::vector<uint8_t> changing(flatbuf, flatbuf + length);
+  auto changing_fred = GetMutableMonster(changing.data())->
+                         mutable_testarrayoftables()->GetMutableObject(1);
+  auto changing_table = reinterpret_cast<const flatbuffers::Table *>(
+                          changing_fred);
+  copyfbb.Clear();
+  copier.Reset();
+  copier.CopyTable(*root_table, *changing_table);
+  changing_fred->mutable_name()->Mutate(0, 'B');
+  copier.Reset();
+  copyfbb.Finish(copier.CopyTable(*root_table, *changing_table));
+  TEST_EQ_STR(GetMonster(copyfbb.GetBufferPointer())->name()->c_str(),
+              "Bred");
+  // Structs are copied with their table, not on their own.
+  auto vec3 = schema.objects()->LookupByKey("MyGame.Example.Vec3");
+  TEST_EQ(copier.CopyTable(*vec3, source).o, 0);
+}
+
+void MutationBatchTest(const uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+
+  // All edits are recorded against the unmodified buffer, so the pointers
+  // we pass in stay valid until Apply().
+  std::vector<uint8_t> resizingbuf(flatbuf, flatbuf + length);
+  auto monster = GetMonster(resizingbuf.data());
+  flatbuffers::MutationBatch batch(schema, &resizingbuf);
+  batch.SetString(monster->name(), "a name a good deal longer than before");
+  batch.ResizeVector<uint8_t>(monster->inventory(), 3, 0);
+  // Replaces the edit above.
+  batch.ResizeVector<uint8_t>(monster->inventory(), 20, 7);
+  // Fred is shared between the union and the vector of tables.
+  batch.SetString(monster->testarrayoftables()->Get(1)->name(),
+                  "Frederick Flintstone");
+  // "bob" is pooled, so this changes elements 0 and 2.
+  batch.SetString(monster->testarrayofstring()->Get(0), "robert");
+  batch.ResizeVector<flatbuffers::Offset<flatbuffers::String>>(
+    monster->testarrayofstring(), 3, 0);
+  batch.SetString(monster->testarrayofstring2()->Get(1), "m");
+  TEST_EQ(batch.size(), 7);
+  batch.Apply();
+  TEST_EQ(batch.size(), 0);
+
+  flatbuffers::Verifier verifier(resizingbuf.data(), resizingbuf.size());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ(flatbuffers::Verify(schema, *schema.root_table(), resizingbuf.data(),
+                              resizingbuf.size()), true);
+  monster = GetMonster(resizingbuf.data());
+  TEST_EQ_STR(monster->name()->c_str(),
+              "a name a good deal longer than before");
+  TEST_EQ(monster->inventory()->size(), 20);
+  TEST_EQ(monster->inventory()->Get(9), 9);
+  TEST_EQ(monster->inventory()->Get(10), 7);
+  TEST_EQ(monster->inventory()->Get(19), 7);
+  TEST_EQ_STR(monster->testarrayoftables()->Get(1)->name()->c_str(),
+              "Frederick Flintstone");
+  TEST_EQ_STR(monster->test_as_Monster()->name()->c_str(),
+              "Frederick Flintstone");
+  TEST_EQ(monster->testarrayoftables()->Get(0)->hp(), 1000);
+  TEST_EQ_STR(monster->testarrayoftables()->Get(2)->name()->c_str(), "Wilma");
+  auto strings = monster->testarrayofstring();
+  TEST_EQ(strings->size(), 3);
+  TEST_EQ_STR(strings->Get(0)->c_str(), "robert");
+  TEST_EQ_STR(strings->Get(1)->c_str(), "fred");
+  TEST_EQ_STR(strings->Get(2)->c_str(), "robert");
+  TEST_EQ_STR(monster->testarrayofstring2()->Get(0)->c_str(), "jane");
+  TEST_EQ_STR(monster->testarrayofstring2()->Get(1)->c_str(), "m");
+  TEST_EQ(monster->hp(), 80);
+  TEST_EQ(monster->pos()->test3().a(), 10);
+}
+
+void CompactTest(const uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+
+  // Leave some garbage behind: a shrunk vector, and a name that is no longer
+  // referenced once we point the field at a string added at the end.
+  std::vector<uint8_t> resizingbuf(flatbuf, flatbuf + length);
+  flatbuffers::ResizeVector<uint8_t>(schema, 1, 0,
+                                     GetMonster(resizingbuf.data())->
+                                       inventory(),
+                                     &resizingbuf);
+  flatbuffers::FlatBufferBuilder stringfbb;
+  stringfbb.Finish(stringfbb.CreateString("hank"));
+  auto string_ptr = flatbuffers::AddFlatBuffer(resizingbuf,
+                                               stringfbb.GetBufferPointer(),
+                                               stringfbb.GetSize());
+  auto &name_field = *schema.root_table()->fields()->LookupByKey("name");
+  SetFieldT(flatbuffers::GetAnyRoot(resizingbuf.data()), name_field,
+            string_ptr);
+
+  auto size = resizingbuf.size();
+  auto reclaimed = flatbuffers::Compact(schema, &resizingbuf);
+  TEST_EQ(reclaimed > 0, true);
+  TEST_EQ(resizingbuf.size(), size - reclaimed);
+  TEST_EQ(resizingbuf.size() < length, true);
+  flatbuffers::Verifier verifier(resizingbuf.data(), resizingbuf.size());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ(MonsterBufferHasIdentifier(resizingbuf.data()), true);
+
+  auto monster = GetMonster(resizingbuf.data());
+  TEST_EQ_STR(monster->name()->c_str(), "hank");
+  TEST_EQ(monster->inventory()->size(), 1);
+  TEST_EQ(monster->hp(), 80);
+  TEST_EQ(monster->pos()->test3().a(), 10);
+  TEST_EQ_STR(monster->testarrayoftables()->Get(2)->name()->c_str(), "Wilma");
+  TEST_EQ(monster->testarrayoftables()->Get(0)->hp(), 1000);
+  // Shared objects stay shared.
+  TEST_EQ(monster->testarrayofstring()->Get(0),
+          monster->testarrayofstring()->Get(2));
+  TEST_EQ(monster->test_as_Monster(), monster->testarrayoftables()->Get(1));
+  // Fred and Wilma only have a name, so share a vtable.
+  TEST_EQ(reinterpret_cast<const flatbuffers::Table *>(
+            monster->testarrayoftables()->Get(1))->GetVTable(),
+          reinterpret_cast<const flatbuffers::Table *>(
+            monster->testarrayoftables()->Get(2))->GetVTable());
+
+  // Nothing left to reclaim.
+  std::vector<uint8_t> compacted = resizingbuf;
+  TEST_EQ(flatbuffers::Compact(schema, &resizingbuf), 0);
+  TEST_EQ(resizingbuf == compacted, true);
+}
+
+void ProjectTableTest(const uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto &root_table = *schema.root_table();
+
+  flatbuffers::FieldMask mask(schema, root_table);
+  TEST_EQ(mask.Add("name"), true);
+  TEST_EQ(mask.Add("pos"), true);
+  TEST_EQ(mask.Add("testarrayoftables.name"), true);
+  TEST_EQ(mask.Add("test"), true);  // Also selects test_type.
+  TEST_EQ(mask.Add("enemy.name"), true);
+  TEST_EQ(mask.Add("nope"), false);
+  TEST_EQ(mask.Add("pos.x"), false);  // Structs are copied whole.
+  TEST_EQ(mask.Add("name.length"), false);
+
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.Finish(flatbuffers::ProjectTable(fbb, schema, root_table,
+                                       *flatbuffers::GetAnyRoot(flatbuf),
+                                       mask), MonsterIdentifier());
+  flatbuffers::Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+
+  auto monster = GetMonster(fbb.GetBufferPointer());
+  TEST_EQ_STR(monster->name()->c_str(), "MyMonster");
+  TEST_EQ(monster->pos()->z(), 3.0f);
+  TEST_EQ(monster->hp(), 100);  // Not selected, so the default.
+  TEST_EQ(monster->inventory() == nullptr, true);
+  TEST_EQ(monster->testarrayofstring() == nullptr, true);
+  auto tables = monster->testarrayoftables();
+  TEST_EQ(tables->size(), 3);
+  TEST_EQ_STR(tables->Get(0)->name()->c_str(), "Barney");
+  TEST_EQ(tables->Get(0)->hp(), 100);  // 1000 in the source.
+  TEST_EQ(monster->test_type(), Any_Monster);
+  TEST_EQ_STR(monster->test_as_Monster()->name()->c_str(), "Fred");
+}
+
+void DiffPatchTest(const uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile, schemafile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.fbs", false, &schemafile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  flatbuffers::Parser parser;
+  const char *include_directories[] = { "tests", nullptr };
+  TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), true);
+  std::string origjson;
+  TEST_EQ(GenerateText(parser, flatbuf, &origjson), true);
+
+  // Diffs "from" against "to", checks that patching "from" gives the same
+  // data as "to", and returns the size of the patch.
+  auto diff_and_patch = [&](const uint8_t *from, const uint8_t *to) {
+    flatbuffers::FlatBufferBuilder patchfbb;
+    flatbuffers::Diff(schema, from, to, &patchfbb);
+    flatbuffers::Verifier verifier(patchfbb.GetBufferPointer(),
+                                   patchfbb.GetSize());
+    TEST_EQ(reflection::VerifyPatchTableBuffer(verifier), true);
+    flatbuffers::FlatBufferBuilder fbb;
+    flatbuffers::ApplyPatch(schema, from, patchfbb.GetBufferPointer(), &fbb);
+    flatbuffers::Verifier patchedverifier(fbb.GetBufferPointer(),
+                                          fbb.GetSize());
+    TEST_EQ(VerifyMonsterBuffer(patchedverifier), true);
+    std::string patchedjson, tojson;
+    TEST_EQ(GenerateText(parser, fbb.GetBufferPointer(), &patchedjson), true);
+    TEST_EQ(GenerateText(parser, to, &tojson), true);
+    TEST_EQ_STR(patchedjson.c_str(), tojson.c_str());
+    return patchfbb.GetSize();
+  };
+
+  // A small change gives a patch much smaller than the whole buffer.
+  auto monster = UnPackMonster(flatbuf);
+  monster->hp = 90;
+  monster->inventory[4] = 40;
+  monster->testarrayoftables[1]->name = "Freddy";
+  flatbuffers::FlatBufferBuilder smallfbb;
+  smallfbb.Finish(CreateMonster(smallfbb, monster.get()), MonsterIdentifier());
+  auto patchsize = diff_and_patch(flatbuf, smallfbb.GetBufferPointer());
+  TEST_EQ(patchsize < smallfbb.GetSize() / 2, true);
+
+  // Changes to every kind of field, both ways around.
+  monster->name = "MyMonster2";
+  monster->inventory.push_back(10);
+  monster->testarrayofstring.erase(monster->testarrayofstring.begin() + 1);
+  monster->testarrayoftables.pop_back();
+  monster->test.AsMonster()->hp = 60;
+  monster->testarrayofstring2.clear();
+  monster->enemy.reset(new MonsterT());
+  monster->enemy->name = "Enemy";
+  flatbuffers::FlatBufferBuilder bigfbb;
+  bigfbb.Finish(CreateMonster(bigfbb, monster.get()), MonsterIdentifier());
+  diff_and_patch(flatbuf, bigfbb.GetBufferPointer());
+  diff_and_patch(bigfbb.GetBufferPointer(), flatbuf);
+
+  // Equal buffers give an empty patch, which changes nothing.
+  flatbuffers::FlatBufferBuilder emptyfbb, samefbb;
+  flatbuffers::Diff(schema, flatbuf, flatbuf, &emptyfbb);
+  auto emptypatch = reflection::GetPatchTable(emptyfbb.GetBufferPointer());
+  TEST_EQ(emptypatch->fields() == nullptr, true);
+  flatbuffers::ApplyPatch(schema, flatbuf, emptyfbb.GetBufferPointer(),
+                          &samefbb);
+  TEST_EQ(samefbb.GetSize() <= length, true);
+  std::string samejson;
+  TEST_EQ(GenerateText(parser, samefbb.GetBufferPointer(), &samejson), true);
+  TEST_EQ_STR(samejson.c_str(), origjson.c_str());
+}
+
+void MergeTest(const uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto &root_table = *schema.root_table();
+
+  // A partial update: only the fields that change are set.
+  flatbuffers::FlatBufferBuilder overlayfbb;
+  auto name = overlayfbb.CreateString("Overlay");
+  uint8_t inv[] = { 100, 101 };
+  auto inventory = overlayfbb.CreateVector(inv, 2);
+  std::vector<std::string> strings;
+  strings.push_back("x");
+  auto vecofstrings = overlayfbb.CreateVectorOfStrings(strings);
+  // MonsterBuilder would insist on a name, which this update leaves alone.
+  auto start = overlayfbb.StartTable();
+  overlayfbb.AddElement<int16_t>(Monster::VT_HP, 7, 100);
+  auto unionmonster = flatbuffers::Offset<Monster>(
+                        overlayfbb.EndTable(start, 3));  // hp is field 2.
+  MonsterBuilder mb(overlayfbb);
+  mb.add_name(name);
+  mb.add_hp(50);
+  mb.add_inventory(inventory);
+  mb.add_testarrayofstring(vecofstrings);
+  mb.add_test_type(Any_Monster);
+  mb.add_test(unionmonster.Union());
+  FinishMonsterBuffer(overlayfbb, mb.Finish());
+  auto &base = *flatbuffers::GetAnyRoot(flatbuf);
+  auto &overlay = *flatbuffers::GetAnyRoot(overlayfbb.GetBufferPointer());
+
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.Finish(flatbuffers::Merge(fbb, schema, root_table, base, overlay),
+             MonsterIdentifier());
+  flatbuffers::Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  auto monster = GetMonster(fbb.GetBufferPointer());
+  TEST_EQ_STR(monster->name()->c_str(), "Overlay");
+  TEST_EQ(monster->hp(), 50);
+  TEST_EQ(monster->mana(), 150);  // Not in the overlay.
+  TEST_EQ(monster->pos()->z(), 3.0f);
+  TEST_EQ(monster->inventory()->size(), 2);
+  TEST_EQ(monster->inventory()->Get(1), 101);
+  TEST_EQ(monster->testarrayofstring()->size(), 1);
+  TEST_EQ(monster->testarrayoftables()->size(), 3);
+  TEST_EQ_STR(monster->testarrayofstring2()->Get(1)->c_str(), "mary");
+  // Unions of the same type are merged too.
+  TEST_EQ_STR(monster->test_as_Monster()->name()->c_str(), "Fred");
+  TEST_EQ(monster->test_as_Monster()->hp(), 7);
+
+  flatbuffers::FlatBufferBuilder concatfbb;
+  concatfbb.Finish(flatbuffers::Merge(concatfbb, schema, root_table, base,
+                                      overlay,
+                                      flatbuffers::kMergeConcatVectors),
+                   MonsterIdentifier());
+  flatbuffers::Verifier concatverifier(concatfbb.GetBufferPointer(),
+                                       concatfbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(concatverifier), true);
+  monster = GetMonster(concatfbb.GetBufferPointer());
+  TEST_EQ(monster->inventory()->size(), 12);
+  TEST_EQ(monster->inventory()->Get(9), 9);
+  TEST_EQ(monster->inventory()->Get(11), 101);
+  auto vecofstrings2 = monster->testarrayofstring();
+  TEST_EQ(vecofstrings2->size(), 5);
+  TEST_EQ_STR(vecofstrings2->Get(0)->c_str(), "bob");
+  TEST_EQ_STR(vecofstrings2->Get(4)->c_str(), "x");
+  // Strings shared in the base stay shared.
+  TEST_EQ(vecofstrings2->Get(0) == vecofstrings2->Get(2), true);
+}
+
+void CompiledSchemaTest(const uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  flatbuffers::CompiledSchema compiled(schema);
+  auto &root = *flatbuffers::GetAnyRoot(flatbuf);
+
+  flatbuffers::CompiledPath hp, name, z, a, enemy_hp, enemy_name, inventory;
+  TEST_EQ(compiled.Compile(*schema.root_table(), "hp", &hp), true);
+  TEST_EQ(compiled.Compile("MyGame.Example.Monster", "name", &name), true);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "pos.z", &z), true);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "pos.test3.a", &a), true);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "enemy.hp", &enemy_hp),
+          true);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "enemy.name", &enemy_name),
+          true);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "inventory", &inventory),
+          true);
+
+  TEST_EQ(hp.type(), reflection::Short);
+  TEST_EQ(hp.GetI(root), 80);
+  TEST_EQ(hp.GetF(root), 80.0);
+  TEST_EQ_STR(name.GetString(root)->c_str(), "MyMonster");
+  TEST_EQ(name.GetI(root), 0);
+  TEST_EQ(z.GetF(root), 3.0);
+  TEST_EQ(z.GetI(root), 3);
+  TEST_EQ(a.GetI(root), 10);
+  TEST_EQ(inventory.GetVector(root)->size(), 10);
+  TEST_EQ(inventory.GetString(root) == nullptr, true);
+  // No enemy, so the defaults.
+  TEST_EQ(enemy_hp.GetI(root), 100);
+  TEST_EQ(enemy_name.GetString(root) == nullptr, true);
+
+  flatbuffers::CompiledPath bad;
+  TEST_EQ(compiled.Compile(*schema.root_table(), "nope", &bad), false);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "hp.x", &bad), false);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "pos.nope", &bad), false);
+  TEST_EQ(compiled.Compile(*schema.root_table(), "test.name", &bad), false);
+  TEST_EQ(compiled.Compile("Nope", "hp", &bad), false);
+  TEST_EQ(bad.IsValid(), false);
+}
+
+void DynamicBuilderTest() {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+
+  // The reference, built with generated code.
+  flatbuffers::FlatBufferBuilder fbb1;
+  auto ename = fbb1.CreateString("Enemy");
+  auto enemy = CreateMonster(fbb1, 0, 150, 80, ename);
+  auto name = fbb1.CreateString("MyMonster");
+  uint8_t inv[] = { 0, 1, 2, 3, 4 };
+  auto inventory = fbb1.CreateVector(inv, 5);
+  Test tests[] = { Test(10, 20), Test(30, 40) };
+  auto test4 = fbb1.CreateVectorOfStructs(tests, 2);
+  std::vector<std::string> names;
+  names.push_back("bob");
+  names.push_back("fred");
+  auto strings = fbb1.CreateVectorOfStrings(names);
+  auto tables = fbb1.CreateVector(&enemy, 1);
+  Vec3 vec(1, 2, 3, 0, Color_Red, Test(5, 6));
+  FinishMonsterBuffer(fbb1, CreateMonster(fbb1, &vec, 150, 200, name,
+                                          inventory, Color_Green, Any_Monster,
+                                          enemy.Union(), test4, strings,
+                                          tables, enemy, 0, 0, true));
+
+  // The same with a DynamicBuilder, in the same order.
+  flatbuffers::FlatBufferBuilder fbb2;
+  flatbuffers::DynamicBuilder db(fbb2, schema);
+  auto monster = db.LookupObject("MyGame.Example.Monster");
+  auto stat = db.LookupObject("MyGame.Example.Stat");
+  auto test = db.LookupObject("MyGame.Example.Test");
+  TEST_EQ(monster >= 0 && stat >= 0 && test >= 0, true);
+  TEST_EQ(db.LookupObject("Nope"), -1);
+  auto f_pos = db.LookupField(monster, "pos");
+  auto f_mana = db.LookupField(monster, "mana");
+  auto f_hp = db.LookupField(monster, "hp");
+  auto f_name = db.LookupField(monster, "name");
+  auto f_inventory = db.LookupField(monster, "inventory");
+  auto f_color = db.LookupField(monster, "color");
+  auto f_test = db.LookupField(monster, "test");
+  auto f_test4 = db.LookupField(monster, "test4");
+  auto f_strings = db.LookupField(monster, "testarrayofstring");
+  auto f_tables = db.LookupField(monster, "testarrayoftables");
+  auto f_enemy = db.LookupField(monster, "enemy");
+  auto f_testempty = db.LookupField(monster, "testempty");
+  auto f_testbool = db.LookupField(monster, "testbool");
+  auto f_friendly = db.LookupField(monster, "friendly");
+  TEST_EQ(db.LookupField(monster, "nope").IsValid(), false);
+
+  db.StartTable(monster);
+  // Tables can be built while building another one.
+  db.StartTable(monster);
+  TEST_EQ(db.AddString(f_name, "Enemy"), true);
+  TEST_EQ(db.AddString(f_name, "Twice"), false);
+  TEST_EQ(db.AddScalar<int32_t>(f_hp, 80), false);  // Wrong type.
+  TEST_EQ(db.AddScalar<int16_t>(f_hp, 80), true);
+  TEST_EQ(db.AddScalar<int16_t>(f_mana, 150), true);  // The default.
+  auto enemyref = db.EndTable();
+  TEST_EQ(enemyref.IsValid(), true);
+  TEST_EQ(db.AddString(f_name, "MyMonster"), true);
+  auto inventoryref = db.CreateVector(inv, 5);
+  auto test4ref = db.CreateVectorOfStructs(
+                    test, reinterpret_cast<const uint8_t *>(tests), 2);
+  auto stringsref = db.CreateVectorOfStrings(names);
+  auto tablesref = db.CreateVectorOfTables(&enemyref, 1);
+  TEST_EQ(db.AddVector(f_strings, inventoryref), false);
+  TEST_EQ(db.AddVector(f_inventory, inventoryref), true);
+  TEST_EQ(db.AddStruct(f_pos, reinterpret_cast<const uint8_t *>(&vec)), true);
+  TEST_EQ(db.AddScalar<int16_t>(f_mana, 150), true);
+  TEST_EQ(db.AddScalar<int16_t>(f_hp, 200), true);
+  TEST_EQ(db.AddScalar<int8_t>(f_color, Color_Green), true);
+  TEST_EQ(db.AddUnion(f_test, enemyref), true);
+  TEST_EQ(db.AddVector(f_test4, test4ref), true);
+  TEST_EQ(db.AddVector(f_tables, test4ref), false);
+  TEST_EQ(db.AddVector(f_strings, stringsref), true);
+  TEST_EQ(db.AddVector(f_tables, tablesref), true);
+  TEST_EQ(db.AddTable(f_enemy, enemyref), true);
+  TEST_EQ(db.AddScalar(f_testbool, true), true);
+  TEST_EQ(db.AddScalar<int16_t>(f_friendly, 1), false);  // Deprecated.
+  db.Finish(db.EndTable(), MonsterIdentifier());
+
+  TEST_EQ(fbb2.GetSize(), fbb1.GetSize());
+  TEST_EQ(memcmp(fbb2.GetBufferPointer(), fbb1.GetBufferPointer(),
+                 fbb1.GetSize()), 0);
+
+  // Tables are type checked too.
+  db.StartTable(stat);
+  TEST_EQ(db.AddScalar<int16_t>(f_hp, 1), false);  // Not a Stat field.
+  auto statref = db.EndTable();
+  db.StartTable(monster);
+  TEST_EQ(db.AddTable(f_enemy, statref), false);
+  TEST_EQ(db.AddTable(f_testempty, statref), true);
+  TEST_EQ(db.AddUnion(f_test, statref), false);  // Not in the union.
+  // Missing required fields are caught.
+  TEST_EQ(db.EndTable().IsValid(), false);
+}
+
+void QueryTest() {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto &root_table = *schema.root_table();
+  flatbuffers::CompiledSchema compiled(schema);
+
+  // A stream of small monsters.
+  const size_t kCount = 1000;
+  std::vector<std::string> bufs;
+  for (size_t i = 0; i < kCount; i++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    auto name = fbb.CreateString((i % 3 ? "Elf" : "Orc") +
+                                 flatbuffers::NumToString(i));
+    auto enemy = i % 5 ? 0 : CreateMonster(fbb, 0, 150, 100,
+                                           fbb.CreateString("Enemy"));
+    Vec3 vec(1, 2, static_cast<float>(i % 7), 0, Color_Red, Test(5, 6));
+    FinishMonsterBuffer(fbb, CreateMonster(
+      fbb, &vec, 150, static_cast<int16_t>(i % 200), name, 0,
+      i % 2 ? Color_Red : Color_Blue, Any_NONE, 0, 0, 0, 0, enemy));
+    bufs.push_back(std::string(
+      reinterpret_cast<const char *>(fbb.GetBufferPointer()), fbb.GetSize()));
+  }
+  std::vector<const uint8_t *> buffers;
+  for (auto it = bufs.begin(); it != bufs.end(); ++it) {
+    buffers.push_back(reinterpret_cast<const uint8_t *>(it->c_str()));
+  }
+  std::vector<uint8_t> results(kCount);
+
+  // Checks a query against the same predicate written with generated code.
+  auto check = [&](const char *expr,
+                   bool (*predicate)(const Monster *)) {
+    flatbuffers::Query query(compiled);
+    TEST_EQ(query.Compile(root_table, expr), true);
+    query.Evaluate(buffers.data(), kCount, results.data());
+    for (size_t i = 0; i < kCount; i++) {
+      auto expected = predicate(GetMonster(buffers[i]));
+      TEST_EQ(results[i] != 0, expected);
+      TEST_EQ(query.Evaluate(*flatbuffers::GetAnyRoot(buffers[i])),
+              expected);
+    }
+  };
+  bool (*orcs)(const Monster *) = [](const Monster *m) {
+    return m->hp() > 100 && !strncmp(m->name()->c_str(), "Orc", 3);
+  };
+  check("hp > 100 && name startswith \"Orc\"", orcs);
+  check("color == Red || !(pos.z >= 3.5)", [](const Monster *m) {
+    return m->color() == Color_Red || !(m->pos()->z() >= 3.5);
+  });
+  check("enemy && enemy.hp == 100 && mana == 150", [](const Monster *m) {
+    return m->enemy() && m->enemy()->hp() == 100 && m->mana() == 150;
+  });
+  check("!enemy || name == \"Orc15\" || name < \"Elf2\"",
+        [](const Monster *m) {
+    return !m->enemy() || !strcmp(m->name()->c_str(), "Orc15") ||
+           strcmp(m->name()->c_str(), "Elf2") < 0;
+  });
+  check("testbool == false && hp <= 10", [](const Monster *m) {
+    return !m->testbool() && m->hp() <= 10;
+  });
+
+  flatbuffers::Query bad(compiled);
+  TEST_EQ(bad.Compile(root_table, "hp >"), false);
+  TEST_EQ(bad.Compile(root_table, "nope == 1"), false);
+  TEST_EQ(bad.Compile(root_table, "name > 3"), false);
+  TEST_EQ(bad.Compile(root_table, "hp startswith \"a\""), false);
+  TEST_EQ(bad.Compile(root_table, "(hp > 1"), false);
+  TEST_EQ(bad.Compile(root_table, "color == Nope"), false);
+  TEST_EQ(bad.Compile(root_table, "inventory == 1"), false);
+  TEST_EQ(bad.Compile(root_table, "hp == 1 hp"), false);
+  TEST_EQ(bad.error().empty(), false);
+
+  // Deep nesting is an error, not a stack overflow.
+  TEST_EQ(bad.Compile(root_table, std::string(2000000, '!') + "hp > 1"),
+          false);
+  TEST_EQ(bad.error().find("expression too deep") != std::string::npos, true);
+  TEST_EQ(bad.Compile(root_table, std::string(100000, '(') + "hp > 1" +
+                                  std::string(100000, ')')), false);
+  TEST_EQ(bad.error().find("expression too deep") != std::string::npos, true);
+  TEST_EQ(bad.Compile(root_table, std::string(10, '!') + "(((hp > 1)))"),
+          true);
+
+  // ulong fields compare as unsigned, and strings may escape \" and \\.
+  flatbuffers::FlatBufferBuilder bigfbb;
+  auto bigname = bigfbb.CreateString("a\"b\\c");
+  MonsterBuilder bigmb(bigfbb);
+  bigmb.add_name(bigname);
+  bigmb.add_testhashu64_fnv1(0xFFFFFFFFFFFFFFF0ULL);
+  FinishMonsterBuffer(bigfbb, bigmb.Finish());
+  auto big = bigfbb.GetBufferPointer();
+  auto matches = [&](const char *expr) {
+    flatbuffers::Query query(compiled);
+    TEST_EQ(query.Compile(root_table, expr), true);
+    uint8_t result = 2;
+    query.Evaluate(&big, 1, &result);
+    TEST_EQ(query.Evaluate(*flatbuffers::GetAnyRoot(big)), result != 0);
+    return result != 0;
+  };
+  TEST_EQ(matches("testhashu64_fnv1 > 5"), true);
+  TEST_EQ(matches("testhashu64_fnv1 < 5"), false);
+  TEST_EQ(matches("testhashu64_fnv1 == 18446744073709551600"), true);
+  TEST_EQ(matches("testhashu64_fnv1 > 18446744073709551599"), true);
+  TEST_EQ(matches("testhashu64_fnv1 > -1"), true);
+  TEST_EQ(matches("testhashu64_fnv1 > 1.5"), true);
+  TEST_EQ(matches("name == \"a\\\"b\\\\c\""), true);
+  TEST_EQ(matches("name startswith \"a\\\"\""), true);
+  TEST_EQ(matches("name == \"a\\\"b\""), false);
+  TEST_EQ(bad.Compile(root_table, "name == \"a\\nb\""), false);
+  TEST_EQ(bad.error().find("unknown escape code") != std::string::npos, true);
+  TEST_EQ(bad.Compile(root_table, "name == \"a\\\""), false);
+  TEST_EQ(bad.error().find("unterminated string") != std::string::npos, true);
+
+  // Both paths match the same buffers.
+  flatbuffers::Query query(compiled);
+  TEST_EQ(query.Compile(root_table, "hp > 100 && name startswith \"Orc\""),
+          true);
+  query.Evaluate(buffers.data(), kCount, results.data());
+  size_t query_matches = 0, generated_matches = 0;
+  for (size_t i = 0; i < kCount; i++) {
+    query_matches += results[i];
+    generated_matches += orcs(GetMonster(buffers[i]));
+  }
+  TEST_EQ(query_matches, generated_matches);
+  TEST_EQ(query_matches > 0, true);
+}
+
+void CanonicalizeTest(const uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto &root_table = *schema.root_table();
+
+  // The same content, built in different ways: with strings pooled, through
+  // the object API, and with defaults written out.
+  auto monster = UnPackMonster(flatbuf);
+  flatbuffers::FlatBufferBuilder repackfbb, defaultsfbb;
+  repackfbb.Finish(CreateMonster(repackfbb, monster.get()),
+                   MonsterIdentifier());
+  defaultsfbb.ForceDefaults(true);
+  defaultsfbb.Finish(CreateMonster(defaultsfbb, monster.get()),
+                     MonsterIdentifier());
+  const uint8_t *bufs[] = {
+    flatbuf, repackfbb.GetBufferPointer(), defaultsfbb.GetBufferPointer()
+  };
+
+  flatbuffers::FlatBufferBuilder canonicalfbb;
+  flatbuffers::Canonicalize(schema, flatbuf, &canonicalfbb);
+  auto canonical = canonicalfbb.GetBufferPointer();
+  flatbuffers::Verifier verifier(canonical, canonicalfbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ(MonsterBufferHasIdentifier(canonical), true);
+  auto hash = flatbuffers::HashTable(schema, root_table,
+                                     *flatbuffers::GetAnyRoot(canonical));
+  flatbuffers::TableHasher hasher(schema);
+  for (size_t i = 0; i < sizeof(bufs) / sizeof(bufs[0]); i++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    flatbuffers::Canonicalize(schema, bufs[i], &fbb);
+    TEST_EQ(fbb.GetSize(), canonicalfbb.GetSize());
+    TEST_EQ(memcmp(fbb.GetBufferPointer(), canonical, fbb.GetSize()), 0);
+    TEST_EQ(hasher.Hash(root_table, *flatbuffers::GetAnyRoot(bufs[i])) ==
+            hash, true);
+  }
+  // Canonical buffers stay the same.
+  flatbuffers::FlatBufferBuilder againfbb;
+  flatbuffers::Canonicalize(schema, canonical, &againfbb);
+  TEST_EQ(againfbb.GetSize(), canonicalfbb.GetSize());
+  TEST_EQ(memcmp(againfbb.GetBufferPointer(), canonical, againfbb.GetSize()),
+          0);
+
+  // Any change, however deep, gives a different hash.
+  auto rehash = [&]() {
+    flatbuffers::FlatBufferBuilder fbb;
+    fbb.Finish(CreateMonster(fbb, monster.get()), MonsterIdentifier());
+    return hasher.Hash(root_table,
+                       *flatbuffers::GetAnyRoot(fbb.GetBufferPointer()));
+  };
+  TEST_EQ(rehash() == hash, true);
+  monster->hp = 81;
+  TEST_EQ(rehash() != hash, true);
+  monster->hp = 80;
+  monster->testarrayoftables[2]->name = "Wilmb";
+  TEST_EQ(rehash() != hash, true);
+  monster->testarrayoftables[2]->name = "Wilma";
+  monster->pos->mutate_z(4);
+  TEST_EQ(rehash() != hash, true);
+  monster->pos->mutate_z(3);
+  monster->testarrayofstring.pop_back();
+  TEST_EQ(rehash() != hash, true);
+
+  // -0.0 is not the default 0.0, so it is kept.
+  auto testf3_hash = [&](float testf3, bool kept) {
+    monster->testf3 = testf3;
+    flatbuffers::FlatBufferBuilder fbb, zfbb;
+    fbb.ForceDefaults(true);
+    fbb.Finish(CreateMonster(fbb, monster.get()), MonsterIdentifier());
+    flatbuffers::Canonicalize(schema, fbb.GetBufferPointer(), &zfbb);
+    auto &z = *flatbuffers::GetAnyRoot(zfbb.GetBufferPointer());
+    auto value = GetMonster(zfbb.GetBufferPointer())->testf3();
+    TEST_EQ(z.CheckField(Monster::VT_TESTF3), kept);
+    TEST_EQ(memcmp(&value, &testf3, sizeof(float)), 0);
+    return hasher.Hash(root_table, z);
+  };
+  TEST_EQ(testf3_hash(-0.0f, true) != testf3_hash(0.0f, false), true);
+  monster->testf3 = 0.0f;
+
+  // A union type is left out along with its value, when that is not set or
+  // of an unknown type.
+  auto union_type_hash = [&](bool set_type, uint8_t type, bool set_value) {
+    flatbuffers::FlatBufferBuilder fbb;
+    auto name = fbb.CreateString("U");
+    auto value = CreateMonster(fbb, 0, 150, 100, name);
+    MonsterBuilder mb(fbb);
+    mb.add_name(name);
+    if (set_value) mb.add_test(value.Union());
+    if (set_type) mb.add_test_type(static_cast<Any>(type));
+    FinishMonsterBuffer(fbb, mb.Finish());
+    flatbuffers::FlatBufferBuilder ufbb;
+    flatbuffers::Canonicalize(schema, fbb.GetBufferPointer(), &ufbb);
+    auto &u = *flatbuffers::GetAnyRoot(ufbb.GetBufferPointer());
+    TEST_EQ(u.CheckField(Monster::VT_TEST_TYPE),
+            GetMonster(ufbb.GetBufferPointer())->test() != nullptr);
+    auto h = hasher.Hash(root_table,
+                         *flatbuffers::GetAnyRoot(fbb.GetBufferPointer()));
+    TEST_EQ(hasher.Hash(root_table, u) == h, true);
+    return h;
+  };
+  auto no_union = union_type_hash(false, 0, false);
+  TEST_EQ(union_type_hash(true, Any_Monster, false) == no_union, true);
+  TEST_EQ(union_type_hash(true, 200, true) == no_union, true);
+  TEST_EQ(union_type_hash(true, Any_Monster, true) != no_union, true);
+}
+
+void FlexConvertTest(const uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  auto &schema = *reflection::GetSchema(bfbsfile.c_str());
+  auto &root_table = *schema.root_table();
+  auto &root = *flatbuffers::GetAnyRoot(flatbuf);
+
+  flatbuffers::FlexConverter converter(schema);
+  flexbuffers::Builder slb;
+  converter.FlatToFlex(root_table, root, slb);
+  slb.Finish();
+  auto map = flexbuffers::GetRoot(slb.GetBuffer()).AsMap();
+  TEST_EQ(map["hp"].AsInt32(), 80);
+  TEST_EQ_STR(map["name"].AsString().c_str(), "MyMonster");
+  TEST_EQ(map["pos"].AsMap()["y"].AsFloat(), 2);
+  TEST_EQ(map["pos"].AsMap()["test3"].AsMap()["b"].AsInt32(), 20);
+  TEST_EQ(map["inventory"].AsTypedVector().size(), 10);
+  TEST_EQ(map["inventory"].AsTypedVector()[4].AsUInt32(), 4);
+  TEST_EQ(map["test_type"].AsUInt32(), Any_Monster);
+  TEST_EQ_STR(map["test"].AsMap()["name"].AsString().c_str(), "Fred");
+  TEST_EQ(map["test4"].AsVector()[1].AsMap()["a"].AsInt32(), 30);
+  TEST_EQ_STR(map["testarrayofstring"].AsVector()[1].AsString().c_str(),
+              "fred");
+  TEST_EQ(map["friendly"].IsNull(), true);  // Deprecated.
+  TEST_EQ(map["testf"].IsNull(), true);  // Not set.
+
+  // Back to a FlatBuffer, with the same content.
+  flatbuffers::FlatBufferBuilder fbb;
+  auto offset = converter.FlexToFlat(root_table,
+                                     flexbuffers::GetRoot(slb.GetBuffer()),
+                                     fbb);
+  TEST_EQ_STR(converter.error().c_str(), "");
+  fbb.Finish(offset, MonsterIdentifier());
+  flatbuffers::Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ(flatbuffers::HashTable(schema, root_table,
+            *flatbuffers::GetAnyRoot(fbb.GetBufferPointer())) ==
+          flatbuffers::HashTable(schema, root_table, root), true);
+
+  // Enums and union types by name, and errors.
+  auto convert = [&](const std::function<void(flexbuffers::Builder &)> &fill,
+                     flatbuffers::FlexConverter &fc) {
+    flexbuffers::Builder b;
+    b.Map([&]() { fill(b); });
+    b.Finish();
+    flatbuffers::FlatBufferBuilder out;
+    auto o = fc.FlexToFlat(root_table, flexbuffers::GetRoot(b.GetBuffer()),
+                           out);
+    if (!o.o) return std::string();
+    out.Finish(o);
+    return std::string(reinterpret_cast<const char *>(
+                         out.GetBufferPointer()), out.GetSize());
+  };
+  auto buf = convert([](flexbuffers::Builder &b) {
+    b.String("name", "Named");
+    b.String("color", "Red");
+    b.String("test_type", "TestSimpleTableWithEnum");
+    b.Map("test", [&]() { b.String("color", "Green"); });
+    b.Bool("testbool", true);
+  }, converter);
+  TEST_EQ_STR(converter.error().c_str(), "");
+  auto monster = GetMonster(buf.c_str());
+  TEST_EQ(monster->color(), Color_Red);
+  TEST_EQ(monster->testbool(), true);
+  TEST_EQ(monster->test_as_TestSimpleTableWithEnum()->color(), Color_Green);
+  TEST_EQ(convert([](flexbuffers::Builder &b) {
+    b.String("name", "Big");
+    b.Int("hp", 70000);
+  }, converter).empty(), true);
+  TEST_EQ_STR(converter.error().c_str(),
+              "MyGame.Example.Monster.hp: value out of range for Short");
+  TEST_EQ(convert([](flexbuffers::Builder &b) { b.Int("hp", 1); },
+                  converter).empty(), true);
+  TEST_EQ_STR(converter.error().c_str(),
+              "MyGame.Example.Monster.name: missing required field");
+  auto unknown = [](flexbuffers::Builder &b) {
+    b.String("name", "Unknown");
+    b.Int("hitpoints", 1);
+  };
+  TEST_EQ(convert(unknown, converter).empty(), true);
+  TEST_EQ_STR(converter.error().c_str(),
+              "MyGame.Example.Monster: unknown field: hitpoints");
+  flatbuffers::FlexConverter lenient(schema, true);
+  TEST_EQ(convert(unknown, lenient).empty(), false);
+  TEST_EQ(convert([](flexbuffers::Builder &b) {
+    b.String("name", "Unknown");
+    b.Map("test", [&]() {});
+  }, converter).empty(), true);
+  TEST_EQ_STR(converter.error().c_str(),
+              "MyGame.Example.Monster.test: missing test_type");
 }
 
 // Parse a .proto schema, output as .fbs
@@ -1266,6 +2062,375 @@ void UnknownFieldsTest() {
   TEST_EQ(jsongen == "{str: \"test\",i: 10}", true);
 }
 
+void FrozenLookupTest() {
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse("enum E:byte { A, B, C } table T { a:int; bb:E; }"
+                       "root_type T;"), true);
+  auto &fields = parser.root_struct_def_->fields;
+  TEST_EQ(fields.IsFrozen(), true);
+  const char *key = "bb: C";
+  TEST_EQ(fields.Lookup(key, 2), fields.Lookup("bb"));
+  TEST_EQ(fields.Lookup(key, 1) == nullptr, true);
+  auto &vals = fields.Lookup("bb")->value.type.enum_def->vals;
+  TEST_EQ(vals.Lookup(key + 4, 1)->value, 2);
+  // Adding to a frozen table must not break lookups.
+  flatbuffers::SymbolTable<flatbuffers::Value> table;
+  table.Freeze();
+  TEST_EQ(table.Lookup("x", 1) == nullptr, true);
+  auto val = new flatbuffers::Value();
+  table.Add("x", val);
+  TEST_EQ(table.IsFrozen(), false);
+  TEST_EQ(table.Lookup("x", 1), val);
+  table.Freeze();
+  TEST_EQ(table.Lookup("x", 1), val);
+  // JSON that follows its schema in the same source uses the index too.
+  TEST_EQ(parser.Parse("{ bb: \"A C\", a: 7 }"), true);
+  auto root = flatbuffers::GetRoot<flatbuffers::Table>(
+                parser.builder_.GetBufferPointer());
+  TEST_EQ(root->GetField<int8_t>(flatbuffers::FieldIndexToOffset(1), 0), 2);
+  TEST_EQ(root->GetField<int32_t>(flatbuffers::FieldIndexToOffset(0), 0), 7);
+}
+
+void JsonStreamTest() {
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse("table T { a:int; s:string; } root_type T;"
+                       "file_identifier \"STRM\";"), true);
+  auto num_structs = parser.structs_.vec.size();
+  std::vector<std::string> records;
+  auto sink = [&](const uint8_t *buf, size_t size) {
+    records.push_back(std::string(reinterpret_cast<const char *>(buf), size));
+  };
+  TEST_EQ(parser.ParseJsonStream("{ a: 1, s: \"x\" }\n"
+                                 "{ a: 2 }{ s: \"z\" }\n", sink), true);
+  TEST_EQ(records.size(), 3U);
+  auto root = flatbuffers::GetSizePrefixedRoot<flatbuffers::Table>(
+                records[1].c_str());
+  TEST_EQ(root->GetField<int32_t>(flatbuffers::FieldIndexToOffset(0), 0), 2);
+  TEST_EQ(flatbuffers::BufferHasIdentifier(
+            records[2].c_str() + sizeof(flatbuffers::uoffset_t), "STRM"),
+          true);
+  root = flatbuffers::GetSizePrefixedRoot<flatbuffers::Table>(
+           records[2].c_str());
+  TEST_EQ_STR(root->GetPointer<const flatbuffers::String *>(
+                flatbuffers::FieldIndexToOffset(1))->c_str(), "z");
+  // The parser can be reused, and doesn't touch the schema.
+  TEST_EQ(parser.ParseJsonStream("", sink), true);
+  TEST_EQ(parser.ParseJsonStream("{ a: 3 } [", sink), false);
+  TEST_EQ(records.size(), 4U);
+  TEST_EQ(parser.structs_.vec.size(), num_structs);
+}
+
+void ParseJsonIntoTest() {
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse("table Inner { a:int; s:string; }"
+                       "table Outer { x:int; inner:Inner; }"), true);
+  auto inner_def = parser.structs_.Lookup("Inner");
+  TEST_NOTNULL(inner_def);
+  // Not zero terminated: the trailing garbage must not be seen.
+  const char json[] = "{ a: 42, s: \"hi\" }garbage";
+  flatbuffers::FlatBufferBuilder fbb;
+  flatbuffers::Offset<void> inner;
+  TEST_EQ(parser.ParseJsonInto(fbb, *inner_def, json, 18, &inner), true);
+  auto start = fbb.StartTable();
+  fbb.AddElement<int32_t>(flatbuffers::FieldIndexToOffset(0), 7, 0);
+  fbb.AddOffset(flatbuffers::FieldIndexToOffset(1), inner);
+  fbb.Finish(flatbuffers::Offset<flatbuffers::Table>(fbb.EndTable(start, 2)));
+  auto outer = flatbuffers::GetRoot<flatbuffers::Table>(
+                 fbb.GetBufferPointer());
+  TEST_EQ(outer->GetField<int32_t>(flatbuffers::FieldIndexToOffset(0), 0), 7);
+  auto inner_table = outer->GetPointer<const flatbuffers::Table *>(
+                       flatbuffers::FieldIndexToOffset(1));
+  TEST_EQ(inner_table->GetField<int32_t>(flatbuffers::FieldIndexToOffset(0),
+                                         0), 42);
+  TEST_EQ_STR(inner_table->GetPointer<const flatbuffers::String *>(
+                flatbuffers::FieldIndexToOffset(1))->c_str(), "hi");
+  // The parser's own builder is not used.
+  TEST_EQ(parser.builder_.GetSize(), 0U);
+  flatbuffers::FlatBufferBuilder fbb2;
+  TEST_EQ(parser.ParseJsonInto(fbb2, *inner_def, json, sizeof(json) - 1,
+                               &inner), false);
+  TEST_NOTNULL(strstr(parser.error_.c_str(), "end of file"));
+}
+
+void DeserializeSchemaTest() {
+  std::string schemafile;
+  std::string jsonfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.fbs", false, &schemafile), true);
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monsterdata_test.golden", false, &jsonfile), true);
+  flatbuffers::IDLOptions opts;
+  opts.binary_schema_builtins = true;
+  flatbuffers::Parser parser(opts);
+  const char *include_directories[] = { "tests", nullptr };
+  TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), true);
+  TEST_EQ(parser.Parse(jsonfile.c_str(), include_directories), true);
+  std::vector<uint8_t> expected(parser.builder_.GetBufferPointer(),
+                                parser.builder_.GetBufferPointer() +
+                                parser.builder_.GetSize());
+  parser.Serialize();
+
+  // A parser loaded from the binary schema must handle JSON identically.
+  flatbuffers::Parser bfbs_parser;
+  TEST_EQ(bfbs_parser.Deserialize(parser.builder_.GetBufferPointer(),
+                                  parser.builder_.GetSize()), true);
+  TEST_NOTNULL(bfbs_parser.root_struct_def_);
+  TEST_EQ_STR(bfbs_parser.root_struct_def_->name.c_str(), "Monster");
+  TEST_EQ_STR(bfbs_parser.file_identifier_.c_str(), "MONS");
+  auto stat = bfbs_parser.structs_.Lookup("MyGame.Example.Stat");
+  TEST_NOTNULL(stat);
+  TEST_EQ_STR(stat->fields.vec[0]->name.c_str(), "id");
+  TEST_NOTNULL(bfbs_parser.root_struct_def_->fields.Lookup("testhashu32_fnv1")
+                 ->attributes.Lookup("hash"));
+  TEST_EQ(bfbs_parser.Parse(jsonfile.c_str(), include_directories), true);
+  TEST_EQ(bfbs_parser.builder_.GetSize(), expected.size());
+  TEST_EQ(memcmp(bfbs_parser.builder_.GetBufferPointer(), expected.data(),
+                 expected.size()), 0);
+  std::string jsongen;
+  TEST_EQ(GenerateText(bfbs_parser, bfbs_parser.builder_.GetBufferPointer(),
+                       &jsongen), true);
+  TEST_EQ_STR(jsongen.c_str(), jsonfile.c_str());
+
+  // Fields are defined in the namespace of their table, whichever namespace
+  // happens to be created last.
+  flatbuffers::Parser ns_parser(opts);
+  TEST_EQ(ns_parser.Parse("namespace A; table T { x:int; }"
+                          "namespace B.C; table U { t:A.T; }"
+                          "namespace A; table V { u:B.C.U; }"
+                          "root_type V;"), true);
+  ns_parser.Serialize();
+  flatbuffers::Parser ns_bfbs_parser;
+  TEST_EQ(ns_bfbs_parser.Deserialize(ns_parser.builder_.GetBufferPointer(),
+                                     ns_parser.builder_.GetSize()), true);
+  const char *tables[] = { "A.T", "B.C.U", "A.V" };
+  for (size_t i = 0; i < sizeof(tables) / sizeof(*tables); i++) {
+    auto struct_def = ns_bfbs_parser.structs_.Lookup(tables[i]);
+    TEST_NOTNULL(struct_def);
+    auto field = struct_def->fields.vec[0];
+    TEST_EQ(field->defined_namespace, struct_def->defined_namespace);
+    TEST_EQ_STR(field->defined_namespace->GetFullyQualifiedName(
+                  struct_def->name).c_str(), tables[i]);
+  }
+
+  // Corrupt schemas are rejected.
+  flatbuffers::Parser bad_parser;
+  TEST_EQ(bad_parser.Deserialize(parser.builder_.GetBufferPointer(), 4),
+          false);
+}
+
+void TextSinkTest() {
+  std::string schemafile;
+  std::string jsonfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.fbs", false, &schemafile), true);
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monsterdata_test.golden", false, &jsonfile), true);
+  flatbuffers::Parser parser;
+  const char *include_directories[] = { "tests", nullptr };
+  TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), true);
+  TEST_EQ(parser.Parse(jsonfile.c_str(), include_directories), true);
+
+  // A tiny chunk size forces many flushes, which must not change the output.
+  std::string text;
+  size_t max_write = 0;
+  flatbuffers::TextSink sink([&](const char *data, size_t size) {
+    text.append(data, size);
+    max_write = std::max(max_write, size);
+    return true;
+  }, 7);
+  TEST_EQ(GenerateText(parser, parser.builder_.GetBufferPointer(), &sink),
+          true);
+  TEST_EQ_STR(text.c_str(), jsonfile.c_str());
+  TEST_EQ(max_write, 7U);
+
+  // Write errors are reported, and stop further writes.
+  int writes = 0;
+  flatbuffers::TextSink failing_sink([&](const char *, size_t) {
+    writes++;
+    return false;
+  }, 16);
+  TEST_EQ(GenerateText(parser, parser.builder_.GetBufferPointer(),
+                       &failing_sink), false);
+  TEST_EQ(writes, 1);
+}
+
+void EnumReverseLookupTest() {
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse("enum Dense:short { A = -2, B, C = 3 }"
+                       "enum Sparse:long { X = -100000, Y = 7, "
+                       "Z = 9000000000 }"
+                       "table T { s:Sparse = Y; } union U { T }"), true);
+  auto dense = parser.enums_.Lookup("Dense");
+  TEST_EQ_STR(dense->ReverseLookup(-2)->name.c_str(), "A");
+  TEST_EQ_STR(dense->ReverseLookup(3)->name.c_str(), "C");
+  TEST_EQ(dense->ReverseLookup(0) == nullptr, true);
+  TEST_EQ(dense->ReverseLookup(-3) == nullptr, true);
+  TEST_EQ(dense->ReverseLookup(4) == nullptr, true);
+  auto sparse = parser.enums_.Lookup("Sparse");
+  TEST_EQ_STR(sparse->ReverseLookup(-100000)->name.c_str(), "X");
+  TEST_EQ_STR(sparse->ReverseLookup(9000000000LL)->name.c_str(), "Z");
+  TEST_EQ(sparse->ReverseLookup(8) == nullptr, true);
+  auto u = parser.enums_.Lookup("U");
+  TEST_EQ(u->ReverseLookup(0) == nullptr, true);
+  TEST_EQ_STR(u->ReverseLookup(0, false)->name.c_str(), "NONE");
+  TEST_EQ_STR(u->ReverseLookup(1)->name.c_str(), "T");
+  // Parsing JSON does not rebuild an index that is up to date: it still maps
+  // the old value after we change it behind the parser's back.
+  auto y = sparse->vals.Lookup("Y");
+  y->value = 8;
+  auto t_def = parser.structs_.Lookup("T");
+  const char json[] = "{ s: Y }";
+  for (int i = 0; i < 2; i++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    flatbuffers::Offset<void> t;
+    TEST_EQ(parser.ParseJsonInto(fbb, *t_def, json, sizeof(json) - 1, &t),
+            true);
+    TEST_EQ(sparse->ReverseLookup(7), y);
+  }
+  y->value = 7;
+  // Adding values invalidates the index.
+  sparse->vals.Add("W", new flatbuffers::EnumVal("W", 8));
+  TEST_EQ_STR(sparse->ReverseLookup(8)->name.c_str(), "W");
+}
+
+void GeneratedJsonTest() {
+  std::string schemafile;
+  std::string jsonfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.fbs", false, &schemafile), true);
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monsterdata_test.golden", false, &jsonfile), true);
+  flatbuffers::Parser parser;
+  const char *include_directories[] = { "tests", nullptr };
+  TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), true);
+  TEST_EQ(parser.Parse(jsonfile.c_str(), include_directories), true);
+  auto monster = GetMonster(parser.builder_.GetBufferPointer());
+
+  // The generated printer needs no parser, but must match GenerateText().
+  std::string text;
+  flatbuffers::JsonStringSink sink(&text);
+  TEST_EQ(ToJson(*monster, sink), true);
+  TEST_EQ_STR(text.c_str(), jsonfile.c_str());
+
+  parser.opts.strict_json = true;
+  parser.opts.indent_step = -1;
+  std::string expected;
+  TEST_EQ(GenerateText(parser, parser.builder_.GetBufferPointer(), &expected),
+          true);
+  flatbuffers::JsonOptions opts;
+  opts.strict_json = true;
+  opts.indent_step = -1;
+  text.clear();
+  flatbuffers::TextSink text_sink([&](const char *data, size_t size) {
+    text.append(data, size);
+    return true;
+  });
+  TEST_EQ(ToJson(*monster, text_sink, opts), true);
+  TEST_EQ(text_sink.Flush(), true);
+  TEST_EQ_STR(text.c_str(), expected.c_str());
+
+  // Strings that are not UTF-8 can't be printed.
+  flatbuffers::FlatBufferBuilder fbb;
+  auto name = fbb.CreateString("\xC0\x80");
+  FinishMonsterBuffer(fbb, CreateMonster(fbb, nullptr, 0, 0, name));
+  text.clear();
+  TEST_EQ(ToJson(*GetMonster(fbb.GetBufferPointer()), sink), false);
+}
+
+void GeneratedJsonParseTest() {
+  std::string schemafile;
+  std::string jsonfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.fbs", false, &schemafile), true);
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monsterdata_test.json", false, &jsonfile), true);
+  flatbuffers::Parser parser;
+  const char *include_directories[] = { "tests", nullptr };
+  TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), true);
+  TEST_EQ(parser.Parse(jsonfile.c_str(), include_directories), true);
+
+  // The generated parser needs no schema. With the fields in schema order, it
+  // builds the same buffer.
+  flatbuffers::FlatBufferBuilder fbb;
+  std::string error;
+  auto root = flatbuffers::FromJson<Monster>(jsonfile.c_str(), jsonfile.size(),
+                                             fbb, &error);
+  TEST_EQ_STR(error.c_str(), "");
+  FinishMonsterBuffer(fbb, root);
+  TEST_EQ(fbb.GetSize(), parser.builder_.GetSize());
+  TEST_EQ(memcmp(fbb.GetBufferPointer(), parser.builder_.GetBufferPointer(),
+                 fbb.GetSize()), 0);
+
+  // In any other order, the data is the same, but the layout may not be.
+  std::string json = "{ testf: 1.5, name: \"x\", testhashu32_fnv1: \"foo\", "
+                     "hp: 5, test: { name: \"y\" }, test_type: Monster }";
+  flatbuffers::Parser reordered;
+  TEST_EQ(reordered.Parse(schemafile.c_str(), include_directories), true);
+  TEST_EQ(reordered.Parse(json.c_str(), include_directories), true);
+  fbb.Clear();
+  root = flatbuffers::FromJson<Monster>(json.c_str(), json.size(), fbb,
+                                        &error);
+  TEST_EQ_STR(error.c_str(), "");
+  FinishMonsterBuffer(fbb, root);
+  std::string text, expected;
+  flatbuffers::JsonStringSink sink(&text), expected_sink(&expected);
+  TEST_EQ(ToJson(*GetMonster(fbb.GetBufferPointer()), sink), true);
+  TEST_EQ(ToJson(*GetMonster(reordered.builder_.GetBufferPointer()),
+                 expected_sink), true);
+  TEST_EQ_STR(text.c_str(), expected.c_str());
+
+  // Errors are reported the way the parser would.
+  fbb.Clear();
+  std::string bad = "{ name: \"x\", nope: 1 }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("unknown field: nope") != std::string::npos, true);
+  fbb.Clear();
+  error.clear();
+  bad = "{ name: \"x\", nope: null }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("unknown field: nope") != std::string::npos, true);
+  // Keywords must be whole words, and enum names must be known and not empty.
+  fbb.Clear();
+  error.clear();
+  bad = "{ name: \"x\", color: nullable }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("unknown enum value: nullable") != std::string::npos,
+          true);
+  fbb.Clear();
+  error.clear();
+  bad = "{ name: \"x\", testbool: trueish }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("invalid integer: trueish") != std::string::npos, true);
+  fbb.Clear();
+  error.clear();
+  bad = "{ name: \"x\", color: \"\" }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("unknown enum value") != std::string::npos, true);
+  fbb.Clear();
+  error.clear();
+  bad = "{ name: \"x\", color: Purple }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("unknown enum value: Purple") != std::string::npos, true);
+  fbb.Clear();
+  error.clear();
+  std::string good = "{ name: \"x\", color: null, testbool: true }";
+  root = flatbuffers::FromJson<Monster>(good.c_str(), good.size(), fbb,
+                                        &error);
+  TEST_EQ_STR(error.c_str(), "");
+  FinishMonsterBuffer(fbb, root);
+  TEST_EQ(GetMonster(fbb.GetBufferPointer())->testbool(), true);
+  fbb.Clear();
+  bad = "{ hp: 1 }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("required field is missing: name") != std::string::npos,
+          true);
+  fbb.Clear();
+  bad = "{ name: \"x\", pos: { x: 1 } }";
+  flatbuffers::FromJson<Monster>(bad.c_str(), bad.size(), fbb, &error);
+  TEST_EQ(error.find("wrong number of initializers") != std::string::npos,
+          true);
+}
+
 void ParseUnionTest() {
   // Unions must be parseable with the type field following the object.
   flatbuffers::Parser parser;
@@ -1340,6 +2505,22 @@ void UnionVectorTest() {
   const MuLan *mu_lan =
       reinterpret_cast<const MuLan*>(movie->characters()->Get(2));
   TEST_EQ(mu_lan->sword_attack_damage(), 5);
+
+  // The generated JSON functions leave vectors of unions out.
+  std::string text;
+  flatbuffers::JsonStringSink sink(&text);
+  flatbuffers::JsonOptions opts;
+  opts.indent_step = -1;
+  TEST_EQ(ToJson(*movie, sink, opts), true);
+  TEST_EQ_STR(text.c_str(),
+              "{characters_type: [Belle,Rapunzel,MuLan]}");
+  flatbuffers::FlatBufferBuilder jsonfbb;
+  std::string error;
+  std::string json = "{ characters_type: [Belle], "
+                     "characters: [{ books_read: 7 }] }";
+  flatbuffers::FromJson<Movie>(json.c_str(), json.size(), jsonfbb, &error);
+  TEST_EQ(error.find("vectors of unions are not supported: characters") !=
+          std::string::npos, true);
 }
 
 void ConformTest() {
@@ -1420,6 +2601,436 @@ void FlexBuffersTest() {
   TEST_EQ(vec[2].MutateFloat(3.14159), false);  // Double does not fit in float.
 }
 
+void FlexBuffersKeyVectorTest() {
+  // An array of records, some written in key order, some not.
+  auto build = [](flexbuffers::BuilderFlag flags,
+                  std::vector<uint8_t> *buf) {
+    flexbuffers::Builder slb(512, flags);
+    slb.Vector([&]() {
+      for (int i = 0; i < 100; i++) {
+        slb.Map([&]() {
+          if (i % 2) {
+            slb.Int("hp", i);
+            slb.String("name", "Orc");
+            slb.Int("x", i * 2);
+          } else {
+            slb.Int("x", i * 2);
+            slb.String("name", "Orc");
+            slb.Int("hp", i);
+          }
+        });
+      }
+      // A different set of keys can't share.
+      slb.Map([&]() { slb.Int("hp", 7); });
+    });
+    slb.Finish();
+    *buf = slb.GetBuffer();
+  };
+  std::vector<uint8_t> shared, unshared;
+  build(flexbuffers::BUILDER_FLAG_SHARE_ALL, &shared);
+  build(flexbuffers::BUILDER_FLAG_SHARE_KEYS_AND_STRINGS, &unshared);
+  // All but the first of the 100 records with the same keys share its key
+  // vector, saving at least its size and 3 offsets of a byte each.
+  TEST_EQ(unshared.size() - shared.size() >= 99 * 4, true);
+
+  auto records = flexbuffers::GetRoot(shared).AsVector();
+  TEST_EQ(records.size(), 101);
+  for (int i = 0; i < 100; i++) {
+    auto record = records[i].AsMap();
+    TEST_EQ(record.size(), 3);
+    TEST_EQ_STR(record.Keys()[0].AsKey(), "hp");
+    TEST_EQ_STR(record.Keys()[2].AsKey(), "x");
+    TEST_EQ(record["hp"].AsInt32(), i);
+    TEST_EQ(record["x"].AsInt32(), i * 2);
+    TEST_EQ_STR(record["name"].AsString().c_str(), "Orc");
+  }
+  auto last = records[100].AsMap();
+  TEST_EQ(last.size(), 1);
+  TEST_EQ(last["hp"].AsInt32(), 7);
+  TEST_EQ(last["x"].IsNull(), true);
+}
+
+void FlexBuffersPoolTest() {
+  // Metrics with a few tags each, drawn from a small set of values.
+  const char *hosts[] = { "web", "web1", "web12", "db" };
+  auto build = [&](flexbuffers::BuilderFlag flags, size_t max_pool_bytes,
+                   std::vector<uint8_t> *buf) {
+    flexbuffers::Builder slb(512, flags);
+    slb.LimitPoolMemory(max_pool_bytes);
+    slb.Vector([&]() {
+      for (int i = 0; i < 1000; i++) {
+        slb.Map([&]() {
+          slb.String("host", hosts[i % 4]);
+          slb.String("metric", "cpu" + flatbuffers::NumToString(i % 50));
+          slb.Int("value", i);
+        });
+      }
+    });
+    slb.Finish();
+    *buf = slb.GetBuffer();
+  };
+  std::vector<uint8_t> pooled, unpooled, capped;
+  build(flexbuffers::BUILDER_FLAG_SHARE_KEYS_AND_STRINGS,
+        static_cast<size_t>(-1), &pooled);
+  build(flexbuffers::BUILDER_FLAG_NONE, static_cast<size_t>(-1), &unpooled);
+  // Too small for even one table: nothing is shared.
+  build(flexbuffers::BUILDER_FLAG_SHARE_KEYS_AND_STRINGS, 0, &capped);
+  TEST_EQ(pooled.size() < unpooled.size() / 2, true);
+  TEST_EQ(capped.size(), unpooled.size());
+
+  auto check = [&](const std::vector<uint8_t> &buf, bool shared) {
+    auto metrics = flexbuffers::GetRoot(buf).AsVector();
+    TEST_EQ(metrics.size(), 1000);
+    for (size_t i = 0; i < metrics.size(); i++) {
+      auto metric = metrics[i].AsMap();
+      TEST_EQ_STR(metric["host"].AsString().c_str(), hosts[i % 4]);
+      TEST_EQ_STR(metric["metric"].AsString().c_str(),
+                  ("cpu" + flatbuffers::NumToString(i % 50)).c_str());
+      TEST_EQ(metric["value"].AsInt32(), static_cast<int32_t>(i));
+      // Equal strings and keys are stored once, if shared.
+      auto first = metrics[i % 4].AsMap();
+      TEST_EQ(metric["host"].AsString().c_str() ==
+              first["host"].AsString().c_str(), shared || i < 4);
+      TEST_EQ(metric.Keys()[0].AsKey() == first.Keys()[0].AsKey(),
+              shared || i < 4);
+    }
+  };
+  check(pooled, true);
+  check(unpooled, false);
+  check(capped, false);
+}
+
+// Hands out memory from a fixed region, and never frees it.
+template<typename T> struct ArenaAllocator {
+  typedef T value_type;
+  ArenaAllocator(uint8_t *arena, size_t size, size_t *used)
+    : arena_(arena), size_(size), used_(used) {}
+  template<typename U> ArenaAllocator(const ArenaAllocator<U> &other)
+    : arena_(other.arena_), size_(other.size_), used_(other.used_) {}
+  T *allocate(size_t n) {
+    auto p = arena_ + *used_;
+    *used_ += (n * sizeof(T) + 7) & ~7;
+    if (*used_ > size_) throw std::bad_alloc();
+    return reinterpret_cast<T *>(p);
+  }
+  void deallocate(T *, size_t) {}
+  bool operator==(const ArenaAllocator &other) const {
+    return arena_ == other.arena_;
+  }
+  bool operator!=(const ArenaAllocator &other) const {
+    return arena_ != other.arena_;
+  }
+  uint8_t *arena_;
+  size_t size_;
+  size_t *used_;
+};
+
+void FlexBuffersReuseTest() {
+  auto build = [](flexbuffers::Builder &slb, int i) {
+    slb.Map([&]() {
+      slb.String("level", i % 2 ? "info" : "warning");
+      slb.Int("line", i);
+    });
+    slb.Finish();
+  };
+  auto check = [](const uint8_t *buf, size_t size, int i) {
+    auto map = flexbuffers::GetRoot(buf, size).AsMap();
+    TEST_EQ(map.size(), 2);
+    TEST_EQ_STR(map["level"].AsString().c_str(), i % 2 ? "info" : "warning");
+    TEST_EQ(map["line"].AsInt32(), i);
+  };
+
+  // Clear() keeps the memory, and forgets the pooled keys and strings.
+  flexbuffers::Builder slb(512, flexbuffers::BUILDER_FLAG_SHARE_ALL);
+  build(slb, 0);
+  auto data = slb.GetBuffer().data();
+  for (int i = 1; i < 10; i++) {
+    slb.Clear();
+    build(slb, i);
+    TEST_EQ(slb.GetBuffer().data() == data, true);
+    check(slb.GetBuffer().data(), slb.GetBuffer().size(), i);
+  }
+
+  // Buffers can be moved out, or swapped out for reuse.
+  auto released = slb.ReleaseBuffer();
+  check(released.data(), released.size(), 9);
+  build(slb, 10);
+  slb.ReleaseBuffer(&released);
+  check(released.data(), released.size(), 10);
+  build(slb, 11);
+  check(slb.GetBuffer().data(), slb.GetBuffer().size(), 11);
+
+  // A builder with all its buffer memory in an arena.
+  uint8_t arena[1024];
+  size_t used = 0;
+  typedef ArenaAllocator<uint8_t> Allocator;
+  flexbuffers::BuilderT<Allocator> arenaslb(
+    256, flexbuffers::BUILDER_FLAG_SHARE_KEYS, Allocator(arena, 1024, &used));
+  arenaslb.Vector([&]() {
+    for (int i = 0; i < 100; i++) arenaslb.Int(i * 1000);
+  });
+  arenaslb.Finish();
+  auto &arenabuf = arenaslb.GetBuffer();
+  TEST_EQ(arenabuf.data() >= arena && arenabuf.data() < arena + used, true);
+  auto vec = flexbuffers::GetRoot(arenabuf.data(), arenabuf.size()).AsVector();
+  TEST_EQ(vec.size(), 100);
+  TEST_EQ(vec[99].AsInt32(), 99000);
+}
+
+void FlexBuffersJsonTest() {
+  // Parser's JSON dialect: comments, unquoted keys, trailing commas.
+  const char *json =
+    "{\n"
+    "  // A comment.\n"
+    "  name: \"Fred \\\"the\\\" \\u00E9l\\u00E8ve\",\n"
+    "  \"hp\": 80,\n"
+    "  big: 18446744073709551615,\n"
+    "  neg: -5,\n"
+    "  pos: { x: 1.5, y: -2e3, z: 0 },\n"
+    "  tags: [ \"a\", 1, true, null, [], {}, ],\n"
+    "  \"odd key\": false,\n"
+    "}";
+  flexbuffers::Builder slb;
+  std::string error;
+  TEST_EQ(flexbuffers::FromJson(json, strlen(json), &slb, &error), true);
+  auto map = flexbuffers::GetRoot(slb.GetBuffer()).AsMap();
+  TEST_EQ(map.size(), 7);
+  TEST_EQ_STR(map["name"].AsString().c_str(),
+              "Fred \"the\" \xC3\xA9l\xC3\xA8ve");
+  TEST_EQ(map["hp"].AsInt64(), 80);
+  TEST_EQ(map["big"].IsUInt(), true);
+  TEST_EQ(map["big"].AsUInt64(), 18446744073709551615ULL);
+  TEST_EQ(map["neg"].AsInt64(), -5);
+  auto pos = map["pos"].AsMap();
+  TEST_EQ(pos["x"].AsDouble(), 1.5);
+  TEST_EQ(pos["y"].AsDouble(), -2000);
+  TEST_EQ(pos["z"].IsInt(), true);
+  auto tags = map["tags"].AsVector();
+  TEST_EQ(tags.size(), 6);
+  TEST_EQ_STR(tags[0].AsString().c_str(), "a");
+  TEST_EQ(tags[2].AsInt64(), 1);  // FlexBuffers have no booleans.
+  TEST_EQ(tags[3].IsNull(), true);
+  TEST_EQ(tags[4].AsVector().size(), 0);
+  TEST_EQ(tags[5].AsMap().size(), 0);
+  TEST_EQ(map["odd key"].AsInt64(), 0);
+
+  // Printing it, compact and strict, then parsing and printing that again,
+  // gives the same.
+  flatbuffers::JsonOptions opts;
+  opts.indent_step = -1;
+  opts.strict_json = true;
+  std::string text;
+  flatbuffers::JsonStringSink sink(&text);
+  TEST_EQ(flexbuffers::GetRoot(slb.GetBuffer()).ToJson(sink, opts), true);
+  TEST_EQ_STR(text.c_str(),
+              "{\"big\": 18446744073709551615,\"hp\": 80,"
+              "\"name\": \"Fred \\\"the\\\" \\u00E9l\\u00E8ve\",\"neg\": -5,"
+              "\"odd key\": 0,\"pos\": {\"x\": 1.5,\"y\": -2000,\"z\": 0},"
+              "\"tags\": [\"a\",1,1,null,[],{}]}");
+  flexbuffers::Builder again;
+  TEST_EQ(flexbuffers::FromJson(text.c_str(), text.length(), &again), true);
+  std::string textagain;
+  flatbuffers::JsonStringSink sinkagain(&textagain);
+  TEST_EQ(flexbuffers::GetRoot(again.GetBuffer()).ToJson(sinkagain, opts),
+          true);
+  TEST_EQ_STR(textagain.c_str(), text.c_str());
+
+  // Without strict_json, only keys that aren't identifiers are quoted, as
+  // are typed vectors and blobs printed.
+  flexbuffers::Builder typed;
+  typed.Map([&]() {
+    int ints[] = { 1, 2, 3 };
+    typed.Vector("ints", ints, 3);
+    typed.FixedTypedVector("xyz", ints, 3);
+    typed.Key("a-b");
+    uint8_t bytes[] = { 0, 255 };
+    typed.Blob(bytes, 2);
+  });
+  typed.Finish();
+  opts.strict_json = false;
+  text.clear();
+  TEST_EQ(flexbuffers::GetRoot(typed.GetBuffer()).ToJson(sink, opts), true);
+  TEST_EQ_STR(text.c_str(),
+              "{\"a-b\": [0,255],ints: [1,2,3],xyz: [1,2,3]}");
+
+  // Errors, which leave the builder to be cleared.
+  const char *bad[] = {
+    "{ a: 1, a: 2 }", "[ 1, 2", "{ a: }", "[ 1x ]", "\"abc", "1 2"
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    flexbuffers::Builder badslb;
+    TEST_EQ(flexbuffers::FromJson(bad[i], strlen(bad[i]), &badslb, &error),
+            false);
+    TEST_EQ(error.empty(), false);
+  }
+  std::string deep(100, '[');
+  TEST_EQ(flexbuffers::FromJson(deep.c_str(), deep.length(), &slb, &error),
+          false);
+  TEST_EQ_STR(error.c_str(), "line 1: maximum nesting depth exceeded");
+}
+
+// Records the values it visits, as text.
+struct RecordingVisitor : public flexbuffers::Visitor {
+  RecordingVisitor() : stop_at(-1) {}
+
+  bool Null() { return Add("null"); }
+  bool Int(int64_t i) { return Add("i" + flatbuffers::NumToString(i)); }
+  bool UInt(uint64_t u) { return Add("u" + flatbuffers::NumToString(u)); }
+  bool Float(double d) { return Add("f" + flatbuffers::NumToString(d)); }
+  bool String(const char *str, size_t len) {
+    return Add("'" + std::string(str, len) + "'");
+  }
+  bool Blob(const uint8_t *, size_t len) {
+    return Add("blob" + flatbuffers::NumToString(len));
+  }
+  bool StartVector(size_t size) {
+    return Add("[" + flatbuffers::NumToString(size));
+  }
+  bool EndVector() { return Add("]"); }
+  bool StartMap(size_t size) {
+    return Add("{" + flatbuffers::NumToString(size));
+  }
+  bool Key(size_t, const char *key, size_t) {
+    return Add(std::string(key) + ":");
+  }
+  bool EndMap() { return Add("}"); }
+
+  bool Add(const std::string &event) {
+    events += event + " ";
+    return stop_at-- != 0;
+  }
+
+  std::string events;
+  int stop_at;
+};
+
+void FlexBuffersTraverseTest() {
+  flexbuffers::Builder slb;
+  slb.Map([&]() {
+    slb.Int("int", -300);
+    slb.UInt("uint", 18446744073709551615ULL);
+    slb.Double("double", 0.5);
+    slb.IndirectInt("indirect", 7);
+    slb.String("str", "hi");
+    uint8_t bytes[] = { 1, 2, 3 };
+    slb.Key("blob");
+    slb.Blob(bytes, 3);
+    slb.Vector("vec", [&]() {
+      slb.Null();
+      slb.Map([&]() { slb.Float("x", 1.5f); });
+      int ints[] = { 4, 5 };
+      slb.FixedTypedVector(ints, 2);
+    });
+    slb.TypedVector("typed", [&]() {
+      slb.String("a");
+      slb.String("b");
+    });
+  });
+  slb.Finish();
+  auto &buf = slb.GetBuffer();
+  auto root = flexbuffers::GetRoot(buf);
+
+  RecordingVisitor visitor;
+  TEST_EQ(flexbuffers::Traverse(root, visitor), true);
+  TEST_EQ_STR(visitor.events.c_str(),
+              "{8 blob: blob3 double: f0.5 indirect: i7 int: i-300 str: 'hi' "
+              "typed: [2 'a' 'b' ] uint: u18446744073709551615 "
+              "vec: [3 null {1 x: f1.5 } [2 i4 i5 ] ] } ");
+  RecordingVisitor stopping;
+  stopping.stop_at = 3;
+  TEST_EQ(flexbuffers::Traverse(root, stopping), false);
+  TEST_EQ_STR(stopping.events.c_str(), "{8 blob: blob3 double: ");
+  TEST_EQ_STR(root.AsMap()["vec"].ToString().c_str(),
+              "[null,{x: 1.5},[4,5]]");
+
+  // Cutting off the start of the buffer fails verification, and neither
+  // cutting off its end nor changing a byte lets a buffer that passes read
+  // outside of it (which ASan would catch).
+  TEST_EQ(flexbuffers::VerifyBuffer(buf.data(), buf.size()), true);
+  std::vector<uint8_t> copy;
+  flexbuffers::Visitor any;
+  for (size_t i = 1; i < buf.size(); i++) {
+    TEST_EQ(flexbuffers::VerifyBuffer(buf.data() + i, buf.size() - i), false);
+    copy.assign(buf.begin(), buf.end() - i);
+    if (flexbuffers::VerifyBuffer(copy.data(), copy.size()))
+      flexbuffers::Traverse(flexbuffers::GetRoot(copy), any);
+  }
+  const uint8_t changes[] = { 0, 0x7F, 0xFF };
+  for (size_t i = 0; i < buf.size(); i++) {
+    for (size_t j = 0; j < sizeof(changes); j++) {
+      copy = buf;
+      copy[i] = changes[j];
+      if (flexbuffers::VerifyBuffer(copy.data(), copy.size()))
+        flexbuffers::Traverse(flexbuffers::GetRoot(copy), any);
+    }
+  }
+
+  // Nesting is limited.
+  flexbuffers::Builder deep;
+  std::vector<size_t> starts;
+  for (int i = 0; i < 70; i++) starts.push_back(deep.StartVector());
+  while (!starts.empty()) {
+    deep.EndVector(starts.back(), false, false);
+    starts.pop_back();
+  }
+  deep.Finish();
+  auto &deepbuf = deep.GetBuffer();
+  TEST_EQ(flexbuffers::VerifyBuffer(deepbuf.data(), deepbuf.size()), false);
+  TEST_EQ(flexbuffers::VerifyBuffer(deepbuf.data(), deepbuf.size(), 70),
+          true);
+}
+
+void FlexBuffersHashedMapTest() {
+  // The same large map, with and without a hash index.
+  const int num_keys = 10000;
+  flexbuffers::Builder plain;
+  flexbuffers::Builder hashed(256, static_cast<flexbuffers::BuilderFlag>(
+                                     flexbuffers::BUILDER_FLAG_SHARE_KEYS |
+                                     flexbuffers::BUILDER_FLAG_HASH_MAP_KEYS));
+  auto build = [&](flexbuffers::Builder &slb, int size) {
+    slb.Map([&]() {
+      for (int i = 0; i < size; i++) {
+        slb.Int(("key" + flatbuffers::NumToString(i)).c_str(), i);
+      }
+    });
+    slb.Finish();
+  };
+  build(plain, num_keys);
+  build(hashed, num_keys);
+  auto &buf = hashed.GetBuffer();
+  TEST_EQ(flexbuffers::VerifyBuffer(buf.data(), buf.size()), true);
+  auto plain_map = flexbuffers::GetRoot(plain.GetBuffer()).AsMap();
+  auto hashed_map = flexbuffers::GetRoot(buf).AsMap();
+  TEST_EQ(plain_map.HasHashIndex(), false);
+  TEST_EQ(hashed_map.HasHashIndex(), true);
+  for (int i = 0; i < num_keys; i++) {
+    auto key = "key" + flatbuffers::NumToString(i);
+    TEST_EQ(hashed_map[key].AsInt64(), i);
+    TEST_EQ(plain_map[key].AsInt64(), i);
+  }
+  const char *missing[] = { "", "key", "key-1", "key10000", "key01" };
+  for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+    TEST_EQ(hashed_map[missing[i]].IsNull(), true);
+  }
+
+  // Readers that don't know about the index see the same sorted keys.
+  auto plain_keys = plain_map.Keys();
+  auto hashed_keys = hashed_map.Keys();
+  TEST_EQ(hashed_keys.size(), plain_keys.size());
+  for (size_t i = 0; i < plain_keys.size(); i++) {
+    TEST_EQ_STR(hashed_keys[i].AsKey(), plain_keys[i].AsKey());
+  }
+  TEST_EQ_STR(flexbuffers::GetRoot(buf).ToString().c_str(),
+              flexbuffers::GetRoot(plain.GetBuffer()).ToString().c_str());
+
+  // Small maps get no index.
+  flexbuffers::Builder small(256, flexbuffers::BUILDER_FLAG_HASH_MAP_KEYS);
+  flexbuffers::Builder small_plain(256, flexbuffers::BUILDER_FLAG_NONE);
+  build(small, 3);
+  build(small_plain, 3);
+  TEST_EQ(small.GetBuffer() == small_plain.GetBuffer(), true);
+}
+
 int main(int /*argc*/, const char * /*argv*/[]) {
   // Run our various test suites:
 
@@ -1438,6 +3049,16 @@ int main(int /*argc*/, const char * /*argv*/[]) {
   #ifndef FLATBUFFERS_NO_FILE_TESTS
   ParseAndGenerateTextTest();
   ReflectionTest(flatbuf.get(), rawbuf.length());
+  MutationBatchTest(flatbuf.get(), rawbuf.length());
+  CompactTest(flatbuf.get(), rawbuf.length());
+  ProjectTableTest(flatbuf.get());
+  DiffPatchTest(flatbuf.get(), rawbuf.length());
+  MergeTest(flatbuf.get());
+  CompiledSchemaTest(flatbuf.get());
+  DynamicBuilderTest();
+  QueryTest();
+  CanonicalizeTest(flatbuf.get());
+  FlexConvertTest(flatbuf.get());
   ParseProtoTest();
   UnionVectorTest();
   #endif
@@ -1456,10 +3077,24 @@ int main(int /*argc*/, const char * /*argv*/[]) {
   UnicodeInvalidSurrogatesTest();
   InvalidUTF8Test();
   UnknownFieldsTest();
+  FrozenLookupTest();
+  JsonStreamTest();
+  ParseJsonIntoTest();
+  DeserializeSchemaTest();
+  TextSinkTest();
+  EnumReverseLookupTest();
+  GeneratedJsonTest();
+  GeneratedJsonParseTest();
   ParseUnionTest();
   ConformTest();
 
   FlexBuffersTest();
+  FlexBuffersKeyVectorTest();
+  FlexBuffersPoolTest();
+  FlexBuffersReuseTest();
+  FlexBuffersJsonTest();
+  FlexBuffersTraverseTest();
+  FlexBuffersHashedMapTest();
 
   if (!testing_fails) {
     TEST_OUTPUT_LINE("ALL TESTS PASSED");
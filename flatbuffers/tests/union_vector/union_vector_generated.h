@@ -5,6 +5,7 @@
 #define FLATBUFFERS_GENERATED_UNIONVECTOR_H_
 
 #include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/json.h"
 
 struct MuLan;
 
@@ -273,6 +274,301 @@ inline bool VerifyCharacterVector(flatbuffers::Verifier &verifier, const flatbuf
   return true;
 }
 
+template<typename Sink>
+void PrintJson(Character e, flatbuffers::JsonPrinter<Sink> &p) {
+  switch (e) {
+    case Character_MuLan: p.Identifier("MuLan"); break;
+    case Character_Rapunzel: p.Identifier("Rapunzel"); break;
+    case Character_Belle: p.Identifier("Belle"); break;
+    default: p.Number(static_cast<uint8_t>(e));
+  }
+}
+
+inline bool ParseJson(Character *e, flatbuffers::JsonReader &r) {
+  uint8_t v;
+  if (!r.Enum(&v, [](const char *name, size_t len, int64_t *value) {
+        switch (len) {
+          case 4:
+            if (!memcmp(name, "NONE", 4)) {
+              *value = static_cast<int64_t>(Character_NONE); return true;
+            }
+            break;
+          case 5:
+            if (!memcmp(name, "MuLan", 5)) {
+              *value = static_cast<int64_t>(Character_MuLan); return true;
+            }
+            if (!memcmp(name, "Belle", 5)) {
+              *value = static_cast<int64_t>(Character_Belle); return true;
+            }
+            break;
+          case 8:
+            if (!memcmp(name, "Rapunzel", 8)) {
+              *value = static_cast<int64_t>(Character_Rapunzel); return true;
+            }
+            break;
+        }
+        return false;
+      })) {
+    return false;
+  }
+  *e = static_cast<Character>(v);
+  return true;
+}
+
+template<typename Sink>
+void PrintJson(const MuLan &o, flatbuffers::JsonPrinter<Sink> &p) {
+  auto t = reinterpret_cast<const flatbuffers::Table *>(&o);
+  int n = 0;
+  p.StartObject();
+  if (t->CheckField(MuLan::VT_SWORD_ATTACK_DAMAGE)) {
+    p.Key(n++, "sword_attack_damage");
+    p.Number(o.sword_attack_damage());
+  }
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const MuLan &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+template<typename Sink>
+void PrintJson(const Rapunzel &o, flatbuffers::JsonPrinter<Sink> &p) {
+  auto t = reinterpret_cast<const flatbuffers::Table *>(&o);
+  int n = 0;
+  p.StartObject();
+  if (t->CheckField(Rapunzel::VT_HAIR_LENGTH)) {
+    p.Key(n++, "hair_length");
+    p.Number(o.hair_length());
+  }
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const Rapunzel &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+template<typename Sink>
+void PrintJson(const Belle &o, flatbuffers::JsonPrinter<Sink> &p) {
+  auto t = reinterpret_cast<const flatbuffers::Table *>(&o);
+  int n = 0;
+  p.StartObject();
+  if (t->CheckField(Belle::VT_BOOKS_READ)) {
+    p.Key(n++, "books_read");
+    p.Number(o.books_read());
+  }
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const Belle &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+template<typename Sink>
+void PrintJson(const Movie &o, flatbuffers::JsonPrinter<Sink> &p) {
+  int n = 0;
+  p.StartObject();
+  if (auto v = o.characters_type()) {
+    p.Key(n++, "characters_type");
+    p.StartArray();
+    for (flatbuffers::uoffset_t i = 0; i < v->size(); i++) {
+      p.Element(i);
+      PrintJson(static_cast<Character>(v->Get(i)), p);
+    }
+    p.EndArray();
+  }
+  p.EndObject();
+}
+
+template<typename Sink>
+bool ToJson(const Movie &o, Sink &sink,
+            const flatbuffers::JsonOptions &opts = flatbuffers::JsonOptions()) {
+  flatbuffers::JsonPrinter<Sink> p(sink, opts);
+  PrintJson(o, p);
+  return p.Finish();
+}
+
+inline bool ParseJson(flatbuffers::Offset<MuLan> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+inline bool ParseJson(flatbuffers::Offset<Rapunzel> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+inline bool ParseJson(flatbuffers::Offset<Belle> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+inline bool ParseJson(flatbuffers::Offset<Movie> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r);
+
+inline bool ParseJson(Character type, flatbuffers::Offset<void> *out,
+                      flatbuffers::FlatBufferBuilder &fbb, flatbuffers::JsonReader &r) {
+  switch (type) {
+    case Character_MuLan: {
+      flatbuffers::Offset<MuLan> o;
+      if (!ParseJson(&o, fbb, r)) return false;
+      *out = o.Union();
+      return true;
+    }
+    case Character_Rapunzel: {
+      flatbuffers::Offset<Rapunzel> o;
+      if (!ParseJson(&o, fbb, r)) return false;
+      *out = o.Union();
+      return true;
+    }
+    case Character_Belle: {
+      flatbuffers::Offset<Belle> o;
+      if (!ParseJson(&o, fbb, r)) return false;
+      *out = o.Union();
+      return true;
+    }
+    default: return r.Error("illegal type id for union: Character");
+  }
+}
+
+inline bool ParseJson(flatbuffers::Offset<MuLan> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  int32_t _sword_attack_damage = static_cast<int32_t>(0);
+  bool _sword_attack_damage_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 19:
+        if (!memcmp(name, "sword_attack_damage", 19)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_sword_attack_damage_set, "sword_attack_damage")) return false;
+          if (!r.Number(&_sword_attack_damage)) return false;
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  MuLanBuilder b(fbb);
+  if (_sword_attack_damage_set) b.add_sword_attack_damage(_sword_attack_damage);
+  *out = b.Finish();
+  return true;
+}
+
+inline bool ParseJson(flatbuffers::Offset<Rapunzel> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  int32_t _hair_length = static_cast<int32_t>(0);
+  bool _hair_length_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 11:
+        if (!memcmp(name, "hair_length", 11)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_hair_length_set, "hair_length")) return false;
+          if (!r.Number(&_hair_length)) return false;
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  RapunzelBuilder b(fbb);
+  if (_hair_length_set) b.add_hair_length(_hair_length);
+  *out = b.Finish();
+  return true;
+}
+
+inline bool ParseJson(flatbuffers::Offset<Belle> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  int32_t _books_read = static_cast<int32_t>(0);
+  bool _books_read_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 10:
+        if (!memcmp(name, "books_read", 10)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_books_read_set, "books_read")) return false;
+          if (!r.Number(&_books_read)) return false;
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  BelleBuilder b(fbb);
+  if (_books_read_set) b.add_books_read(_books_read);
+  *out = b.Finish();
+  return true;
+}
+
+inline bool ParseJson(flatbuffers::Offset<Movie> *out,
+                      flatbuffers::FlatBufferBuilder &fbb,
+                      flatbuffers::JsonReader &r) {
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t>> _characters_type;
+  bool _characters_type_set = false;
+  if (!r.Expect('{')) return false;
+  int n = 0;
+  const char *name;
+  size_t len;
+  while (r.NextField(&n, &name, &len)) {
+    switch (len) {
+      case 10:
+        if (!memcmp(name, "characters", 10)) {
+          return r.Error("vectors of unions are not supported: characters");
+        }
+        break;
+      case 15:
+        if (!memcmp(name, "characters_type", 15)) {
+          if (r.Null()) continue;
+          if (!r.Once(&_characters_type_set, "characters_type")) return false;
+          if (!r.Expect('[')) return false;
+          std::vector<uint8_t> v;
+          for (flatbuffers::uoffset_t i = 0; r.NextElement(i); i++) {
+            Character e;
+            if (!ParseJson(&e, r)) return false;
+            v.push_back(static_cast<uint8_t>(e));
+          }
+          if (!r.ok()) return false;
+          _characters_type = fbb.CreateVector(v);
+          continue;
+        }
+        break;
+    }
+    return r.Error("unknown field: " + std::string(name, len));
+  }
+  if (!r.ok()) return false;
+  MovieBuilder b(fbb);
+  if (_characters_type_set) b.add_characters_type(_characters_type);
+  *out = b.Finish();
+  return true;
+}
+
 inline const Movie *GetMovie(const void *buf) {
   return flatbuffers::GetRoot<Movie>(buf);
 }